@@ -3,4 +3,12 @@
 #include "MyProject3.h"
 #include "Modules/ModuleManager.h"
 
+LLM_DEFINE_TAG(Slash);
+LLM_DEFINE_TAG(Slash_Enemies);
+LLM_DEFINE_TAG(Slash_Weapons);
+LLM_DEFINE_TAG(Slash_Items);
+LLM_DEFINE_TAG(Slash_Breakables);
+LLM_DEFINE_TAG(Slash_HUD);
+LLM_DEFINE_TAG(Slash_AI);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, MyProject3, "MyProject3" );
@@ -3,4 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
 
+// Shared stat group for the gameplay systems, view with "stat Slash"
+DECLARE_STATS_GROUP(TEXT("Slash"), STATGROUP_Slash, STATCAT_Advanced);
+
+// Low level memory tracker tags for the gameplay systems, under Slash in "stat LLMFULL" and -llmcsv
+LLM_DECLARE_TAG(Slash_Enemies);
+LLM_DECLARE_TAG(Slash_Weapons);
+LLM_DECLARE_TAG(Slash_Items);
+LLM_DECLARE_TAG(Slash_Breakables);
+LLM_DECLARE_TAG(Slash_HUD);
+LLM_DECLARE_TAG(Slash_AI);
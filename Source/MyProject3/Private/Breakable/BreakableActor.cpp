@@ -2,14 +2,25 @@
 
 
 #include "Breakable/BreakableActor.h"
+#include "Breakable/DestructionSubsystem.h"
+#include "Spawning/AsyncSpawnSubsystem.h"
+#include "Replay/GameplayRandomSubsystem.h"
 #include "Items/Treasure.h"
 #include "Components/CapsuleComponent.h"
+#include "Components/PersistentStateComponent.h"
 #include "GeometryCollection/GeometryCollectionComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "MyProject3/MyProject3.h"
 
 ABreakableActor::ABreakableActor()
 {
+	LLM_SCOPE_BYTAG(Slash_Breakables);
 	PrimaryActorTick.bCanEverTick = false;
 
+	// Only breaking has to reach clients
+	bReplicates = true;
+	NetDormancy = ENetDormancy::DORM_Initial;
+
 	GeometryCollection = CreateDefaultSubobject<UGeometryCollectionComponent>(TEXT("GeometryCollection"));
 	SetRootComponent(GeometryCollection);
 	GeometryCollection->SetGenerateOverlapEvents(true);
@@ -20,13 +31,44 @@ ABreakableActor::ABreakableActor()
 	Capsule->SetupAttachment(GetRootComponent());
 	Capsule->SetCollisionResponseToAllChannels(ECollisionResponse::ECR_Ignore);
 	Capsule->SetCollisionResponseToChannel(ECollisionChannel::ECC_Pawn, ECollisionResponse::ECR_Block);
-	
+
+	PersistentState = CreateDefaultSubobject<UPersistentStateComponent>(TEXT("PersistentState"));
 }
 
 void ABreakableActor::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Slash_Breakables);
 	Super::BeginPlay();
-	
+
+	// Broke before this cell streamed out, the debris is long gone
+	FPersistentActorState State;
+	if (HasAuthority() && PersistentState && PersistentState->LoadState(State) && State.HasFlag(EPersistentStateFlags::Broken))
+	{
+		isBroken = true;
+		Destroy();
+		return;
+	}
+
+	if (UDestructionSubsystem* Destruction = GetWorld()->GetSubsystem<UDestructionSubsystem>())
+	{
+		Destruction->RegisterBreakable(this);
+	}
+}
+
+void ABreakableActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UDestructionSubsystem* Destruction = GetWorld()->GetSubsystem<UDestructionSubsystem>())
+	{
+		Destruction->UnregisterBreakable(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void ABreakableActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ABreakableActor, isBroken);
 }
 
 void ABreakableActor::Tick(float DeltaTime)
@@ -37,8 +79,21 @@ void ABreakableActor::Tick(float DeltaTime)
 
 void ABreakableActor::GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter)
 {
+	LLM_SCOPE_BYTAG(Slash_Breakables);
 	if (isBroken) return;
+	FlushNetDormancy();
 	isBroken = true;
+	if (PersistentState)
+	{
+		FPersistentActorState State = PersistentState->GetState();
+		State.Flags |= EPersistentStateFlags::Broken;
+		PersistentState->SaveState(State);
+	}
+	// Let the destruction budget pick the fracture detail before the fields reach us
+	if (UDestructionSubsystem* Destruction = GetWorld()->GetSubsystem<UDestructionSubsystem>())
+	{
+		Destruction->OnBreakableFractured(this);
+	}
 	// Spawn actor with <> will spawn an actor from cpp, not blueprints. Blueprints has fields we set like static mesh. So we need to spawn blueprint (lecutre 156)
 	UWorld* World = GetWorld();
 	if (World && TreasureClasses.Num() > 0)
@@ -47,9 +102,28 @@ void ABreakableActor::GetHit_Implementation(const FVector& ImpactPoint, AActor*
 		FVector Location = GetActorLocation();
 		Location.Z += 75.f;
 
-		const int32 Selection = FMath::RandRange(0, TreasureClasses.Num() - 1);
+		const int32 Selection = UGameplayRandomSubsystem::GetStream(this, EGameplayRandom::Loot).RandRange(0, TreasureClasses.Num() - 1);
+
+		if (UAsyncSpawnSubsystem* AsyncSpawn = World->GetSubsystem<UAsyncSpawnSubsystem>())
+		{
+			AsyncSpawn->SpawnActorAsync(TreasureClasses[Selection], FTransform(GetActorRotation(), Location), FActorSpawnParameters());
+		}
+	}
+}
 
-		World->SpawnActor<ATreasure>(TreasureClasses[Selection], Location, GetActorRotation());
+void ABreakableActor::OnRep_Broken()
+{
+	if (UDestructionSubsystem* Destruction = GetWorld()->GetSubsystem<UDestructionSubsystem>())
+	{
+		Destruction->OnBreakableFractured(this);
+	}
+}
+
+void ABreakableActor::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	for (const TSoftClassPtr<ATreasure>& TreasureClass : TreasureClasses)
+	{
+		OutAssets.Add(TreasureClass.ToSoftObjectPath());
 	}
 }
 
@@ -0,0 +1,255 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Breakable/DestructionSubsystem.h"
+#include "Breakable/BreakableActor.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "GeometryCollection/GeometryCollection.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_CYCLE_STAT(TEXT("Destruction Tick"), STAT_SlashDestructionTick, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Fractures"), STAT_SlashActiveFractures, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frozen Fractures"), STAT_SlashFrozenFractures, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Breakable Rigid Bodies"), STAT_SlashBreakableRigidBodies, STATGROUP_Slash);
+
+static TAutoConsoleVariable<int32> CVarMaxActiveFractures(
+	TEXT("slash.Destruction.MaxActiveFractures"),
+	4,
+	TEXT("Max breakables simulating at once. Breaking another one freezes the oldest."));
+
+static TAutoConsoleVariable<float> CVarFreezeAfter(
+	TEXT("slash.Destruction.FreezeAfter"),
+	2.5f,
+	TEXT("Seconds after breaking before debris is frozen to kinematic."));
+
+static TAutoConsoleVariable<float> CVarDebrisLifetime(
+	TEXT("slash.Destruction.DebrisLifetime"),
+	12.f,
+	TEXT("Seconds after breaking before debris is removed."));
+
+static TAutoConsoleVariable<int32> CVarMaxDebris(
+	TEXT("slash.Destruction.MaxDebris"),
+	16,
+	TEXT("Max broken breakables kept in the world, active or frozen. The oldest is removed first."));
+
+static TAutoConsoleVariable<float> CVarReducedDetailDistance(
+	TEXT("slash.Destruction.ReducedDetailDistance"),
+	2500.f,
+	TEXT("Breakables further than this from the camera only break their top cluster level."));
+
+void UDestructionSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlashDestructionTick);
+	SLASH_HITCH_SCOPE(Destruction);
+	LLM_SCOPE_BYTAG(Slash_Breakables);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double FreezeAfter = CVarFreezeAfter.GetValueOnGameThread();
+	const double Lifetime = CVarDebrisLifetime.GetValueOnGameThread();
+
+	for (int32 Index = Fractures.Num() - 1; Index >= 0; --Index)
+	{
+		FFracture& Fracture = Fractures[Index];
+		if (!Fracture.Breakable.IsValid())
+		{
+			Fractures.RemoveAt(Index);
+			continue;
+		}
+
+		const double Age = Now - Fracture.BrokenTime;
+		if (Age >= Lifetime)
+		{
+			RemoveFracture(Index);
+		}
+		else if (!Fracture.bFrozen && Age >= FreezeAfter)
+		{
+			FreezeFracture(Fracture);
+		}
+	}
+
+	const int32 MaxDebris = FMath::Max(1, CVarMaxDebris.GetValueOnGameThread());
+	while (Fractures.Num() > MaxDebris)
+	{
+		RemoveFracture(0);
+	}
+
+	UpdateStats();
+}
+
+TStatId UDestructionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDestructionSubsystem, STATGROUP_Tickables);
+}
+
+bool UDestructionSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UDestructionSubsystem::RegisterBreakable(ABreakableActor* Breakable)
+{
+	if (Breakable)
+	{
+		Breakables.AddUnique(Breakable);
+	}
+}
+
+void UDestructionSubsystem::UnregisterBreakable(ABreakableActor* Breakable)
+{
+	Breakables.Remove(Breakable);
+}
+
+void UDestructionSubsystem::OnBreakableFractured(ABreakableActor* Breakable)
+{
+	if (Breakable == nullptr) return;
+
+	FVector ViewLocation;
+	const bool bReduced = GetViewLocation(ViewLocation) &&
+		FVector::DistSquared(ViewLocation, Breakable->GetActorLocation()) > FMath::Square(CVarReducedDetailDistance.GetValueOnGameThread());
+
+	FFracture& Fracture = Fractures.AddDefaulted_GetRef();
+	Fracture.Breakable = Breakable;
+	Fracture.BrokenTime = GetWorld()->GetTimeSeconds();
+	ApplyFractureDetail(Breakable, bReduced, Fracture);
+
+	// Over the cap, freeze the oldest fractures that are still simulating to make room for this one
+	int32 NumSimulating = 0;
+	for (const FFracture& Other : Fractures)
+	{
+		if (!Other.bFrozen) ++NumSimulating;
+	}
+	const int32 MaxActive = FMath::Max(1, CVarMaxActiveFractures.GetValueOnGameThread());
+	for (int32 Index = 0; Index < Fractures.Num() - 1 && NumSimulating > MaxActive; ++Index)
+	{
+		if (!Fractures[Index].bFrozen)
+		{
+			FreezeFracture(Fractures[Index]);
+			--NumSimulating;
+		}
+	}
+
+	UpdateStats();
+}
+
+bool UDestructionSubsystem::HasBreakableWithin(const FVector& Location, float Radius) const
+{
+	const double RadiusSquared = FMath::Square(Radius);
+	for (const TWeakObjectPtr<ABreakableActor>& Breakable : Breakables)
+	{
+		if (Breakable.IsValid() && FVector::DistSquared(Breakable->GetActorLocation(), Location) <= RadiusSquared)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UDestructionSubsystem::ApplyFractureDetail(ABreakableActor* Breakable, bool bReduced, FFracture& Fracture)
+{
+	UGeometryCollectionComponent* GeometryCollection = Breakable->GetGeometryCollection();
+	if (GeometryCollection == nullptr) return;
+
+	const FBodyCounts& Counts = GetBodyCounts(GeometryCollection->GetRestCollection());
+	Fracture.RigidBodies = bReduced ? Counts.Reduced : Counts.Full;
+
+	if (bReduced)
+	{
+		// Only the top cluster can come apart and pieces can't shatter each other on impact
+		TArray<float> DamageThreshold = GeometryCollection->DamageThreshold;
+		for (int32 Level = 1; Level < DamageThreshold.Num(); ++Level)
+		{
+			DamageThreshold[Level] = UE_BIG_NUMBER;
+		}
+		GeometryCollection->SetDamageThreshold(DamageThreshold);
+		GeometryCollection->SetEnableDamageFromCollision(false);
+	}
+}
+
+void UDestructionSubsystem::FreezeFracture(FFracture& Fracture)
+{
+	Fracture.bFrozen = true;
+
+	ABreakableActor* Breakable = Fracture.Breakable.Get();
+	if (Breakable == nullptr) return;
+	Breakables.Remove(Breakable);
+
+	if (UGeometryCollectionComponent* GeometryCollection = Breakable->GetGeometryCollection())
+	{
+		// Pin every piece where it is, the bounds grow with the debris so this catches all of them
+		GeometryCollection->SetEnableDamageFromCollision(false);
+		GeometryCollection->ApplyKinematicField(GeometryCollection->Bounds.SphereRadius + 100.f, GeometryCollection->Bounds.Origin);
+	}
+}
+
+void UDestructionSubsystem::RemoveFracture(int32 Index)
+{
+	// Clients keep the debris until the server's destroy replicates
+	ABreakableActor* Breakable = Fractures[Index].Breakable.Get();
+	if (Breakable && Breakable->HasAuthority())
+	{
+		Breakable->Destroy();
+	}
+	Fractures.RemoveAt(Index);
+}
+
+bool UDestructionSubsystem::GetViewLocation(FVector& OutLocation) const
+{
+	if (APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0))
+	{
+		OutLocation = CameraManager->GetCameraLocation();
+		return true;
+	}
+	return false;
+}
+
+const UDestructionSubsystem::FBodyCounts& UDestructionSubsystem::GetBodyCounts(const UGeometryCollection* RestCollection)
+{
+	static const FBodyCounts Unknown;
+	if (RestCollection == nullptr) return Unknown;
+
+	if (const FBodyCounts* Cached = BodyCountCache.Find(RestCollection))
+	{
+		return *Cached;
+	}
+
+	FBodyCounts Counts;
+	if (const TSharedPtr<FGeometryCollection, ESPMode::ThreadSafe> Collection = RestCollection->GetGeometryCollection())
+	{
+		Counts.Full = FMath::Max(1, Collection->NumElements(FGeometryCollection::TransformGroup));
+		Counts.Reduced = Counts.Full;
+
+		// Reduced detail only releases the direct children of the root
+		if (const TManagedArray<int32>* Levels = Collection->FindAttribute<int32>("Level", FGeometryCollection::TransformGroup))
+		{
+			int32 NumTopLevel = 0;
+			for (const int32 Level : *Levels)
+			{
+				if (Level == 1) ++NumTopLevel;
+			}
+			Counts.Reduced = FMath::Max(1, NumTopLevel);
+		}
+	}
+	return BodyCountCache.Add(RestCollection, Counts);
+}
+
+void UDestructionSubsystem::UpdateStats()
+{
+	NumActiveFractures = 0;
+	NumActiveRigidBodies = 0;
+	for (const FFracture& Fracture : Fractures)
+	{
+		if (!Fracture.bFrozen)
+		{
+			++NumActiveFractures;
+			NumActiveRigidBodies += Fracture.RigidBodies;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_SlashActiveFractures, NumActiveFractures);
+	SET_DWORD_STAT(STAT_SlashFrozenFractures, Fractures.Num() - NumActiveFractures);
+	SET_DWORD_STAT(STAT_SlashBreakableRigidBodies, NumActiveRigidBodies);
+}
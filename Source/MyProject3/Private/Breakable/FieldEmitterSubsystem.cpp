@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Breakable/FieldEmitterSubsystem.h"
+#include "Breakable/DestructionSubsystem.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Engine/World.h"
+#include "Field/FieldSystemComponent.h"
+#include "Field/FieldSystemObjects.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_CYCLE_STAT(TEXT("Field Emitter Tick"), STAT_SlashFieldEmitterTick, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fields Applied"), STAT_SlashFieldsApplied, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fields Skipped"), STAT_SlashFieldsSkipped, STATGROUP_Slash);
+
+static TAutoConsoleVariable<bool> CVarFieldsNative(
+	TEXT("slash.Fields.Native"),
+	true,
+	TEXT("Weapon impacts use the pooled native fields. Off falls back to the weapon's Blueprint CreateFields."));
+
+static TAutoConsoleVariable<int32> CVarFieldPoolSize(
+	TEXT("slash.Fields.PoolSize"),
+	4,
+	TEXT("Field system components created at begin play, also the most impacts applied in one frame."));
+
+static TAutoConsoleVariable<float> CVarFieldRadius(
+	TEXT("slash.Fields.Radius"),
+	250.f,
+	TEXT("Radius of the impact fields. Impacts with no breakable this close are skipped."));
+
+static TAutoConsoleVariable<float> CVarFieldStrain(
+	TEXT("slash.Fields.Strain"),
+	1000000.f,
+	TEXT("External strain put on geometry collection clusters inside the radius."));
+
+static TAutoConsoleVariable<float> CVarFieldVelocity(
+	TEXT("slash.Fields.Velocity"),
+	600.f,
+	TEXT("Outward velocity given to loose pieces at the impact point, falling off to zero at the radius."));
+
+static TAutoConsoleVariable<float> CVarFieldMergeDistance(
+	TEXT("slash.Fields.MergeDistance"),
+	50.f,
+	TEXT("Impacts queued in the same frame closer than this share one field."));
+
+void UFieldEmitterSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	CreatePool(InWorld);
+}
+
+void UFieldEmitterSubsystem::Deinitialize()
+{
+	if (IsValid(PoolOwner))
+	{
+		PoolOwner->Destroy();
+	}
+	PoolOwner = nullptr;
+	Pool.Empty();
+	PendingImpacts.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UFieldEmitterSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UFieldEmitterSubsystem::IsEnabled()
+{
+	return CVarFieldsNative.GetValueOnGameThread();
+}
+
+void UFieldEmitterSubsystem::CreatePool(UWorld& InWorld)
+{
+	LLM_SCOPE_BYTAG(Slash_Breakables);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Name = TEXT("FieldEmitterPool");
+	SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+	SpawnParams.ObjectFlags |= RF_Transient;
+	PoolOwner = InWorld.SpawnActor<AActor>(SpawnParams);
+	if (PoolOwner == nullptr) return;
+
+	const int32 PoolSize = FMath::Max(1, CVarFieldPoolSize.GetValueOnGameThread());
+	for (int32 Index = 0; Index < PoolSize; ++Index)
+	{
+		FFieldEmitter& Emitter = Pool.AddDefaulted_GetRef();
+		Emitter.Component = NewObject<UFieldSystemComponent>(PoolOwner);
+		Emitter.Component->RegisterComponent();
+
+		Emitter.Strain = NewObject<URadialFalloff>(Emitter.Component);
+		Emitter.VelocityFalloff = NewObject<URadialFalloff>(Emitter.Component);
+		Emitter.Velocity = NewObject<URadialVector>(Emitter.Component);
+		Emitter.FalloffVelocity = NewObject<UOperatorField>(Emitter.Component);
+		Emitter.FalloffVelocity->SetOperatorField(1.f, Emitter.Velocity, Emitter.VelocityFalloff, EFieldOperationType::Field_Multiply);
+
+		// Only pieces already flying get thrown, static and kinematic ones are left to the strain
+		Emitter.DebrisFilter = NewObject<UFieldSystemMetaDataFilter>(Emitter.Component);
+		Emitter.DebrisFilter->SetMetaDataFilterType(EFieldFilterType::Field_Filter_Dynamic, EFieldObjectType::Field_Object_Destruction, EFieldPositionType::Field_Position_CenterOfMass);
+	}
+}
+
+bool UFieldEmitterSubsystem::QueueImpact(const FVector& Location)
+{
+	const UDestructionSubsystem* Destruction = GetWorld()->GetSubsystem<UDestructionSubsystem>();
+	if (Pool.Num() == 0 || Destruction == nullptr || !Destruction->HasBreakableWithin(Location, CVarFieldRadius.GetValueOnGameThread()))
+	{
+		INC_DWORD_STAT(STAT_SlashFieldsSkipped);
+		return false;
+	}
+
+	const double MergeDistanceSquared = FMath::Square(CVarFieldMergeDistance.GetValueOnGameThread());
+	for (const FVector& Pending : PendingImpacts)
+	{
+		if (FVector::DistSquared(Pending, Location) <= MergeDistanceSquared)
+		{
+			INC_DWORD_STAT(STAT_SlashFieldsSkipped);
+			return true;
+		}
+	}
+
+	PendingImpacts.Add(Location);
+	return true;
+}
+
+void UFieldEmitterSubsystem::Tick(float DeltaTime)
+{
+	if (PendingImpacts.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SlashFieldEmitterTick);
+	SLASH_HITCH_SCOPE(Destruction);
+
+	// Anything past the pool size waits for the next frame
+	const int32 NumToApply = FMath::Min(PendingImpacts.Num(), Pool.Num());
+	for (int32 Index = 0; Index < NumToApply; ++Index)
+	{
+		FFieldEmitter& Emitter = Pool[NextEmitter];
+		NextEmitter = (NextEmitter + 1) % Pool.Num();
+		if (Emitter.Component == nullptr) continue;
+
+		ApplyImpact(Emitter, PendingImpacts[Index]);
+	}
+	PendingImpacts.RemoveAt(0, NumToApply, false);
+	INC_DWORD_STAT_BY(STAT_SlashFieldsApplied, NumToApply);
+}
+
+void UFieldEmitterSubsystem::ApplyImpact(FFieldEmitter& Emitter, const FVector& Location)
+{
+	const float Radius = CVarFieldRadius.GetValueOnGameThread();
+
+	Emitter.Strain->SetRadialFalloff(CVarFieldStrain.GetValueOnGameThread(), 0.f, 1.f, 0.f, Radius, Location, EFieldFalloffType::Field_FallOff_None);
+	Emitter.Component->ApplyPhysicsField(true, EFieldPhysicsType::Field_ExternalClusterStrain, nullptr, Emitter.Strain);
+
+	Emitter.VelocityFalloff->SetRadialFalloff(1.f, 0.f, 1.f, 0.f, Radius, Location, EFieldFalloffType::Field_Falloff_Linear);
+	Emitter.Velocity->SetRadialVector(CVarFieldVelocity.GetValueOnGameThread(), Location);
+	Emitter.Component->ApplyPhysicsField(true, EFieldPhysicsType::Field_LinearVelocity, Emitter.DebrisFilter, Emitter.FalloffVelocity);
+}
+
+TStatId UFieldEmitterSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFieldEmitterSubsystem, STATGROUP_Tickables);
+}
@@ -4,12 +4,23 @@
 #include "Components/BoxComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/AttributeComponent.h"
+#include "CombatCore/CombatCoreConversions.h"
 #include "Items/Weapons/Weapon.h"
 #include "Kismet/GameplayStatics.h"
+#include "Diagnostics/CombatTelemetrySubsystem.h"
+#include "Diagnostics/InputLatencySubsystem.h"
+#include "Loading/LevelPrewarmSubsystem.h"
+#include "Net/LagCompensationSubsystem.h"
+#include "Replay/GameplayRandomSubsystem.h"
+#include "Animation/AnimMontage.h"
+#include "Particles/ParticleSystem.h"
+#include "Sound/SoundBase.h"
+#include "Net/UnrealNetwork.h"
 #include "MyProject3/DebugMacros.h"
 
 
-ABaseCharacter::ABaseCharacter()
+ABaseCharacter::ABaseCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
 {
 	PrimaryActorTick.bCanEverTick = true;
 
@@ -18,27 +29,82 @@ ABaseCharacter::ABaseCharacter()
 
 }
 
+void ABaseCharacter::GetPrewarmAssets(TArray<UObject*>& OutAssets) const
+{
+	OutAssets.Append({ HitSound, HitParticles, AttackMontage, TwoHandedAttackMontage, HitReactMontage, DeathMontage });
+}
+
+void ABaseCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ABaseCharacter, EquippedWeapon);
+}
+
 void ABaseCharacter::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	// Servers keep a hitbox history so client hits can be checked where the client saw us
+	if (ULagCompensationSubsystem* LagComp = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagComp->RegisterCharacter(this);
+	}
+}
+
+void ABaseCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (ULagCompensationSubsystem* LagComp = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagComp->UnregisterCharacter(this);
+	}
+	Super::EndPlay(EndPlayReason);
 }
 
 void ABaseCharacter::GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter)
 {
+	SLASH_COMBAT_EVENT(Hit, this, Hitter, ImpactPoint, Attributes ? Attributes->GetHealthPercent() : 0.f, 0, 0);
 	if (IsAlive() && Hitter)
 	{
-		DirectionalHitReact(Hitter->GetActorLocation());
+		MulticastHitReact(Hitter->GetActorLocation());
 	}
 	else
 	{
+		if (!IsAlive())
+		{
+			SLASH_COMBAT_EVENT(Death, this, Hitter, GetActorLocation(), 0.f, 0, 0);
+		}
 		Die();
 	}
 
+	MulticastHitEffects(ImpactPoint);
+}
+
+void ABaseCharacter::MulticastPlayMontageSection_Implementation(UAnimMontage* Montage, FName SectionName)
+{
+	if (IsMontagePredictedLocally(Montage)) return;
+	PlayMontageSection(Montage, SectionName);
+}
+
+void ABaseCharacter::MulticastHitReact_Implementation(FVector_NetQuantize HitterLocation)
+{
+	DirectionalHitReact(HitterLocation);
+}
+
+void ABaseCharacter::MulticastHitEffects_Implementation(FVector_NetQuantize ImpactPoint)
+{
 	PlayHitSound(ImpactPoint);
 	SpawnHitParticles(ImpactPoint);
 }
 
+void ABaseCharacter::OnRep_EquippedWeapon()
+{
+	if (EquippedWeapon)
+	{
+		EquippedWeapon->Equip(GetMesh(), GetEquippedWeaponSocket(), this, this);
+	}
+}
+
 void ABaseCharacter::Attack()
 {
 }
@@ -52,6 +118,7 @@ void ABaseCharacter::PlayHitReactMontage(const FName& SectionName)
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 	if (AnimInstance && HitReactMontage)
 	{
+		ULevelPrewarmSubsystem::NoteAssetUse(this, HitReactMontage);
 		AnimInstance->Montage_Play(HitReactMontage);
 		AnimInstance->Montage_JumpToSection(SectionName, HitReactMontage);
 	}
@@ -59,45 +126,32 @@ void ABaseCharacter::PlayHitReactMontage(const FName& SectionName)
 
 void ABaseCharacter::DirectionalHitReact(const FVector& ImpactPoint)
 {
-	const FVector Forward = GetActorForwardVector();
-	const FVector ImpactLowered(ImpactPoint.X, ImpactPoint.Y, GetActorLocation().Z);
-	const FVector ToHit = (ImpactLowered - GetActorLocation()).GetSafeNormal();
-
-	// Forward o ToHit = |Forward||ToHit| * cos(theta)
-	// |Forward| = 1 |ToHit| = 1 => Forward o ToHit = cos(theta) 
-	const double CosTheta = FVector::DotProduct(Forward, ToHit);
-	double Theta = FMath::Acos(CosTheta);
-	Theta = FMath::RadiansToDegrees(Theta);
-	FVector CrossProduct = FVector::CrossProduct(Forward, ToHit);
-	// if down theta is negative
-	if (CrossProduct.Z < 0)
-	{
-		Theta *= -1.f;
-	}
+	// The impact is lowered to our height, only the direction around us counts
+	const CombatCore::FVec3 Forward = CombatCore::ToCore(GetActorForwardVector());
+	const CombatCore::FVec3 ToHit = CombatCore::ToCore(ImpactPoint - GetActorLocation());
 
-	if (-45.f <= Theta && Theta < 45.f)
+	switch (CombatCore::ClassifyHitDirection(Forward.X, Forward.Y, ToHit.X, ToHit.Y))
 	{
+	case CombatCore::EHitDirection::Front:
 		PlayHitReactMontage(FName("FromFront"));
-	}
-	else if (-135.f <= Theta && Theta < -45.f)
-	{
+		break;
+	case CombatCore::EHitDirection::Left:
 		PlayHitReactMontage(FName("FromLeft"));
-	}
-	else if (45.f <= Theta && Theta < 135.f)
-	{
+		break;
+	case CombatCore::EHitDirection::Right:
 		PlayHitReactMontage(FName("FromRight"));
-	}
-	else
-	{
+		break;
+	case CombatCore::EHitDirection::Back:
 		PlayHitReactMontage(FName("FromBack"));
+		break;
 	}
 }
 
 void ABaseCharacter::PlayHitSound(const FVector& ImpactPoint)
 {
-	UE_LOG(LogTemp, Warning, TEXT("Playing hit sound for BC"));
 	if (HitSound)
 	{
+		ULevelPrewarmSubsystem::NoteAssetUse(this, HitSound);
 		UGameplayStatics::PlaySoundAtLocation(this, HitSound, ImpactPoint);
 	}
 }
@@ -106,10 +160,16 @@ void ABaseCharacter::SpawnHitParticles(const FVector& ImpactPoint)
 {
 	if (HitParticles)
 	{
+		ULevelPrewarmSubsystem::NoteAssetUse(this, HitParticles);
+		// Pooled, the prewarm fills the pool while the level loads
 		UGameplayStatics::SpawnEmitterAtLocation(
 			GetWorld(),
 			HitParticles,
-			ImpactPoint
+			ImpactPoint,
+			FRotator::ZeroRotator,
+			FVector(1.f),
+			true,
+			EPSCPoolMethod::AutoRelease
 		);
 	}
 }
@@ -127,23 +187,28 @@ void ABaseCharacter::PlayMontageSection(UAnimMontage* Montage, const FName& Sect
 	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
 	if (AnimInstance && Montage)
 	{
+		ULevelPrewarmSubsystem::NoteAssetUse(this, Montage);
 		AnimInstance->Montage_Play(Montage);
 		AnimInstance->Montage_JumpToSection(SectionName, Montage);
 	}
 }
 
-int32 ABaseCharacter::PlayRandomMontageSection(UAnimMontage* Montage, const TArray<FName>& SectionNames)
+int32 ABaseCharacter::PlayRandomMontageSection(UAnimMontage* Montage, const TArray<FName>& SectionNames, int32 Selection)
 {
 	if (SectionNames.Num() <= 0) return -1;
-	const int32 MaxSectionIndex = SectionNames.Num() - 1;
-	const int32 Selection = FMath::RandRange(0, MaxSectionIndex);
-	PlayMontageSection(Montage, SectionNames[Selection]);
+	// A section picked elsewhere (the client that predicted the attack) is kept so both ends play the same one
+	if (!SectionNames.IsValidIndex(Selection))
+	{
+		const int32 MaxSectionIndex = SectionNames.Num() - 1;
+		Selection = UGameplayRandomSubsystem::GetStream(this, EGameplayRandom::Animation).RandRange(0, MaxSectionIndex);
+	}
+	MulticastPlayMontageSection(Montage, SectionNames[Selection]);
 	return Selection;
 }
 
-int32 ABaseCharacter::PlayAttackMontage()
+int32 ABaseCharacter::PlayAttackMontage(int32 Selection)
 {
-	return PlayRandomMontageSection(AttackMontage, AttackMontageSections);
+	return PlayRandomMontageSection(AttackMontage, AttackMontageSections, Selection);
 }
 
 int32 ABaseCharacter::PlayDeathMontage()
@@ -165,12 +230,8 @@ FVector ABaseCharacter::GetTranslationWarpTarget()
 	if (CombatTarget == nullptr) return FVector();
 
 	const FVector CombatTargetLocation = CombatTarget->GetActorLocation();
-	const FVector Location = GetActorLocation();
-
-	FVector TargetToMe = (Location - CombatTargetLocation).GetSafeNormal();
-	TargetToMe *= WarpTargetDistance;
-
-	return CombatTargetLocation + TargetToMe;
+	const CombatCore::FVec3 TargetToMe = CombatCore::ToCore(GetActorLocation() - CombatTargetLocation);
+	return CombatTargetLocation + CombatCore::ToVector(CombatCore::GetTranslationWarpOffset(TargetToMe, static_cast<float>(WarpTargetDistance)));
 }
 
 FVector ABaseCharacter::GetRotationWarpTarget()
@@ -213,6 +274,10 @@ void ABaseCharacter::SetWeaponCollisionEnabled(ECollisionEnabled::Type Collision
 	{
 		EquippedWeapon->GetWeaponBox()->SetCollisionEnabled(CollisionEnabled);
 		EquippedWeapon->IgnoreActors.Empty();
+		if (CollisionEnabled != ECollisionEnabled::NoCollision)
+		{
+			UInputLatencySubsystem::NoteEffect(this, ELatencyEffect::AttackCollision);
+		}
 	}
 }
 
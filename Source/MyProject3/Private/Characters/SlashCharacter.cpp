@@ -8,9 +8,40 @@
 #include "Camera/CameraComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GroomComponent.h"
+#include "Components/GroomPolicyComponent.h"
+#include "Components/AttributeComponent.h"
+#include "Diagnostics/InputLatencySubsystem.h"
+#include "Engine/GameInstance.h"
 #include "Items/Item.h"
 #include "Items/Weapons/Weapon.h"
+#include "Animation/AnimInstance.h"
 #include "Animation/AnimMontage.h"
+#include "Net/LagCompensationSubsystem.h"
+#include "Net/UnrealNetwork.h"
+#include "Persistence/SaveGameSubsystem.h"
+#include "Spawning/AsyncSpawnSubsystem.h"
+#include "GameFramework/PlayerState.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Predicted Actions"), STAT_SlashPredictedActions, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Mispredicted Actions"), STAT_SlashMispredictions, STATGROUP_Slash);
+
+static TAutoConsoleVariable<float> CVarPredictionCatchUpTime(
+	TEXT("slash.Prediction.CatchUpTime"),
+	0.1f,
+	TEXT("Seconds of montage the server may skip, on top of half the owner's ping, to accept an action the owner already started."));
+
+static FAutoConsoleCommandWithWorld DumpPredictionCommand(
+	TEXT("slash.Prediction.Dump"),
+	TEXT("Prints how many actions the local player predicted and how many the server disagreed with."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		if (const ASlashCharacter* SlashCharacter = PlayerController ? Cast<ASlashCharacter>(PlayerController->GetPawn()) : nullptr)
+		{
+			SlashCharacter->DumpPredictionStats();
+		}
+	}));
 
 ASlashCharacter::ASlashCharacter()
 {
@@ -36,6 +67,8 @@ ASlashCharacter::ASlashCharacter()
 	ViewCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("ViewCamera"));
 	ViewCamera->SetupAttachment(CameraBoom);
 
+	// Server only builds never draw hair
+#if !UE_SERVER
 	Hair = CreateDefaultSubobject<UGroomComponent>(TEXT("Hair"));
 	Hair->SetupAttachment(GetMesh());
 	Hair->AttachmentName = FString("head");
@@ -43,6 +76,9 @@ ASlashCharacter::ASlashCharacter()
 	Eyebrows = CreateDefaultSubobject<UGroomComponent>(TEXT("Eyebrows"));
 	Eyebrows->SetupAttachment(GetMesh());
 	Eyebrows->AttachmentName = FString("head");
+#endif
+
+	GroomPolicy = CreateDefaultSubobject<UGroomPolicyComponent>(TEXT("GroomPolicy"));
 
 }
 
@@ -61,8 +97,8 @@ void ASlashCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComp
 		EnhancedInputComponent->BindAction(MovementAction, ETriggerEvent::Triggered, this, &ASlashCharacter::Move);
 		EnhancedInputComponent->BindAction(LookAction, ETriggerEvent::Triggered, this, &ASlashCharacter::Look);
 		EnhancedInputComponent->BindAction(EKeyAction, ETriggerEvent::Triggered, this, &ASlashCharacter::EKeyPressed);
-		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Triggered, this, &ACharacter::Jump);
-		EnhancedInputComponent->BindAction(AttackAction, ETriggerEvent::Triggered, this, &ASlashCharacter::Attack);
+		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Triggered, this, &ASlashCharacter::JumpPressed);
+		EnhancedInputComponent->BindAction(AttackAction, ETriggerEvent::Triggered, this, &ASlashCharacter::AttackPressed);
 	}
 }
 
@@ -70,13 +106,58 @@ void ASlashCharacter::GetHit_Implementation(const FVector& ImpactPoint, AActor*
 {
 	Super::GetHit_Implementation(ImpactPoint, Hitter);
 	SetWeaponCollisionEnabled(ECollisionEnabled::NoCollision);
-	ActionState = EActionState::EAS_HitReaction;
+	SetActionState(EActionState::EAS_HitReaction);
+}
+
+void ASlashCharacter::GetPrewarmAssets(TArray<UObject*>& OutAssets) const
+{
+	Super::GetPrewarmAssets(OutAssets);
+	OutAssets.Add(EquipMontage);
+}
+
+void ASlashCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ASlashCharacter, CharacterState, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(ASlashCharacter, ActionState, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(ASlashCharacter, AuthCharacterState, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(ASlashCharacter, AuthActionState, COND_OwnerOnly);
+}
+
+void ASlashCharacter::PreRegisterAllComponents()
+{
+	Super::PreRegisterAllComponents();
+
+	// Dedicated servers and -nullrhi runs of a client build can't draw hair either, drop it before it registers.
+	// Only in game worlds, a commandlet or cook would save placed characters without their grooms
+	const UWorld* World = GetWorld();
+	if (!FApp::CanEverRender() && World && World->IsGameWorld())
+	{
+		if (Hair)
+		{
+			Hair->DestroyComponent();
+			Hair = nullptr;
+		}
+		if (Eyebrows)
+		{
+			Eyebrows->DestroyComponent();
+			Eyebrows = nullptr;
+		}
+	}
 }
 
 void ASlashCharacter::BeginPlay()
 {
 	Super::BeginPlay();
-	if (APlayerController* PlayerController = Cast<APlayerController>(GetController()))
+	if (GroomPolicy)
+	{
+		GroomPolicy->AddGroom(Hair);
+		GroomPolicy->AddGroom(Eyebrows);
+	}
+	// A replay drives the player from the recording, live input would only throw it off
+	APlayerController* PlayerController = Cast<APlayerController>(GetController());
+	if (PlayerController && !USessionRecorderSubsystem::IsReplaying(this))
 	{
 		UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(PlayerController->GetLocalPlayer());
 		if (Subsystem)
@@ -86,6 +167,13 @@ void ASlashCharacter::BeginPlay()
 	}
 	Tags.Add(FName("EngageableTarget"));
 	Tags.Add(FName("Player"));
+
+	USaveGameSubsystem* SaveGame = GetGameInstance() ? GetGameInstance()->GetSubsystem<USaveGameSubsystem>() : nullptr;
+	SaveFile::FPlayer Saved;
+	if (HasAuthority() && IsLocallyControlled() && SaveGame && SaveGame->ConsumePlayer(Saved))
+	{
+		ApplySaveState(Saved);
+	}
 }
 
 void ASlashCharacter::MoveForward(float Value)
@@ -124,22 +212,290 @@ void ASlashCharacter::LookUp(float Value)
 
 void ASlashCharacter::EKeyPressed()
 {
-	AWeapon* OverlappingWeapon = Cast<AWeapon>(OverlappingItem);
-	if (OverlappingWeapon)
+	USessionRecorderSubsystem::NoteInput(this, ESessionInput::EKey);
+	UInputLatencySubsystem::NoteInput(this, ELatencyInput::EKey);
+	if (HasAuthority())
 	{
-		EquipWeapon(OverlappingWeapon);
+		PerformEKeyAction();
+		return;
+	}
+
+	// Do it here first so the montage starts on the key press, the server answers for it later
+	AWeapon* WeaponBefore = EquippedWeapon;
+	EPredictedAction Action;
+	{
+		TGuardValue<bool> PredictedMontageGuard(bPlayingPredictedMontage, true);
+		Action = PerformEKeyAction();
+	}
+	if (Action != EPredictedAction::EPA_None)
+	{
+		ServerEKeyPressed(BeginPrediction(Action, WeaponBefore));
+	}
+}
+
+void ASlashCharacter::AttackPressed()
+{
+	USessionRecorderSubsystem::NoteInput(this, ESessionInput::Attack);
+	UInputLatencySubsystem::NoteInput(this, ELatencyInput::Attack);
+	if (HasAuthority())
+	{
+		Attack();
+		return;
+	}
+
+	if (!CanAttack()) return;
+	int32 AttackSection;
+	{
+		TGuardValue<bool> PredictedMontageGuard(bPlayingPredictedMontage, true);
+		AttackSection = PerformAttack(INDEX_NONE);
 	}
-	else
+	// The server plays the same section so the swing everyone else sees matches ours
+	ServerAttack(BeginPrediction(EPredictedAction::EPA_Attack, EquippedWeapon), static_cast<int8>(AttackSection));
+}
+
+void ASlashCharacter::JumpPressed()
+{
+	USessionRecorderSubsystem::NoteInput(this, ESessionInput::Jump);
+	Jump();
+}
+
+void ASlashCharacter::ReplayInput(ESessionInput Type, const FVector2D& Value)
+{
+	switch (Type)
 	{
-		if (CanDisarm())
+	case ESessionInput::Move:
+		Move(FInputActionValue(Value));
+		break;
+	case ESessionInput::Look:
+		Look(FInputActionValue(Value));
+		break;
+	case ESessionInput::Jump:
+		JumpPressed();
+		break;
+	case ESessionInput::EKey:
+		EKeyPressed();
+		break;
+	case ESessionInput::Attack:
+		AttackPressed();
+		break;
+	}
+}
+
+void ASlashCharacter::GetSaveState(SaveFile::FPlayer& OutPlayer) const
+{
+	OutPlayer.Location = FVector3f(GetActorLocation());
+	OutPlayer.Yaw = static_cast<float>(GetActorRotation().Yaw);
+	OutPlayer.HealthPercent = Attributes ? Attributes->GetHealthPercent() : 1.f;
+	OutPlayer.Gold = Attributes ? Attributes->GetGold() : 0;
+	OutPlayer.CharacterState = CharacterState;
+	FMemory::Memzero(OutPlayer.WeaponClass);
+	if (EquippedWeapon)
+	{
+		FCStringAnsi::Strncpy(OutPlayer.WeaponClass, TCHAR_TO_ANSI(*EquippedWeapon->GetClass()->GetPathName()), UE_ARRAY_COUNT(OutPlayer.WeaponClass));
+	}
+}
+
+void ASlashCharacter::ApplySaveState(const SaveFile::FPlayer& Player)
+{
+	const FRotator Rotation(0.f, Player.Yaw, 0.f);
+	SetActorLocationAndRotation(FVector(Player.Location), Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	if (Controller)
+	{
+		Controller->SetControlRotation(Rotation);
+	}
+	if (Attributes)
+	{
+		Attributes->SetHealthPercent(Player.HealthPercent);
+		Attributes->SetGold(Player.Gold);
+	}
+
+	ANSICHAR WeaponClass[UE_ARRAY_COUNT(Player.WeaponClass)];
+	FCStringAnsi::Strncpy(WeaponClass, Player.WeaponClass, UE_ARRAY_COUNT(WeaponClass));
+	UAsyncSpawnSubsystem* AsyncSpawn = GetWorld()->GetSubsystem<UAsyncSpawnSubsystem>();
+	if (AsyncSpawn == nullptr || WeaponClass[0] == 0) return;
+
+	// The weapon where it was picked up stays away as collected, the player gets a new one
+	TWeakObjectPtr<ASlashCharacter> WeakThis(this);
+	const ECharacterState SavedState = Player.CharacterState;
+	AsyncSpawn->SpawnActorAsync(TSoftClassPtr<AActor>(FSoftObjectPath(ANSI_TO_TCHAR(WeaponClass))), FTransform::Identity, FActorSpawnParameters(),
+		[WeakThis, SavedState](AActor* Spawned)
 		{
-			Disarm();
-		}
-		else if (CanArm())
+			ASlashCharacter* Character = WeakThis.Get();
+			AWeapon* Weapon = Cast<AWeapon>(Spawned);
+			if (Character == nullptr || Weapon == nullptr || Character->EquippedWeapon)
+			{
+				Spawned->Destroy();
+				return;
+			}
+			Character->EquipWeapon(Weapon);
+			if (SavedState == ECharacterState::ECS_Unequipped)
+			{
+				Character->SetCharacterState(ECharacterState::ECS_Unequipped);
+				Character->AttachWeaponToBack();
+			}
+		});
+}
+
+void ASlashCharacter::AddGold(int32 Amount)
+{
+	if (Attributes)
+	{
+		Attributes->AddGold(Amount);
+	}
+}
+
+void ASlashCharacter::ServerEKeyPressed_Implementation(uint8 PredictionId)
+{
+	CatchUpWithOwner();
+	const EPredictedAction Action = PerformEKeyAction();
+	ClientAckAction(PredictionId, Action, ActionState, CharacterState);
+}
+
+void ASlashCharacter::ServerAttack_Implementation(uint8 PredictionId, int8 AttackSection)
+{
+	CatchUpWithOwner();
+	Super::Attack();
+	EPredictedAction Action = EPredictedAction::EPA_None;
+	if (CanAttack())
+	{
+		PerformAttack(AttackSection);
+		Action = EPredictedAction::EPA_Attack;
+	}
+	ClientAckAction(PredictionId, Action, ActionState, CharacterState);
+}
+
+void ASlashCharacter::ClientAckAction_Implementation(uint8 PredictionId, EPredictedAction ServerAction, EActionState ServerActionState, ECharacterState ServerCharacterState)
+{
+	const int32 Index = PendingActions.IndexOfByPredicate([PredictionId](const FPredictedAction& Pending) { return Pending.Id == PredictionId; });
+	// Already thrown away by an earlier rollback
+	if (Index == INDEX_NONE) return;
+
+	const FPredictedAction Acked = PendingActions[Index];
+	// Acks are reliable and in order, anything older has been answered
+	PendingActions.RemoveAt(0, Index + 1);
+
+	if (Acked.Action != ServerAction)
+	{
+		RollBackPrediction(Acked, ServerAction, ServerActionState, ServerCharacterState);
+	}
+	else if (PendingActions.Num() == 0 && (AuthActionState != ServerActionState || AuthCharacterState != ServerCharacterState))
+	{
+		// Something changed on the server after our action (a hit) while we were ignoring its states
+		OnRep_AuthState();
+	}
+}
+
+void ASlashCharacter::OnRep_AuthState()
+{
+	// Until everything in flight is answered our own prediction stands
+	if (PendingActions.Num() > 0) return;
+	ActionState = AuthActionState;
+	CharacterState = AuthCharacterState;
+}
+
+uint8 ASlashCharacter::BeginPrediction(EPredictedAction Action, AWeapon* WeaponBefore)
+{
+	if (PendingActions.Num() == MaxPendingActions)
+	{
+		// Nothing answered in a long while, drop the oldest rather than grow
+		PendingActions.RemoveAt(0);
+	}
+
+	FPredictedAction& Pending = PendingActions.AddDefaulted_GetRef();
+	Pending.Id = NextPredictionId++;
+	Pending.Action = Action;
+	Pending.WeaponBefore = WeaponBefore;
+
+	++NumPredictedActions;
+	INC_DWORD_STAT(STAT_SlashPredictedActions);
+	return Pending.Id;
+}
+
+void ASlashCharacter::RollBackPrediction(const FPredictedAction& Mispredicted, EPredictedAction ServerAction, EActionState ServerActionState, ECharacterState ServerCharacterState)
+{
+	++NumMispredictions;
+	INC_DWORD_STAT(STAT_SlashMispredictions);
+	UE_LOG(LogTemp, Warning, TEXT("%s: server did %s instead of predicted %s, rolling back"), *GetName(),
+		*UEnum::GetValueAsString(ServerAction), *UEnum::GetValueAsString(Mispredicted.Action));
+
+	// Stop what we played for it, the server's states below say where we really are
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->Montage_Stop(0.1f, GetAttackMontage());
+		AnimInstance->Montage_Stop(0.1f, EquipMontage);
+	}
+
+	if (Mispredicted.Action == EPredictedAction::EPA_PickUp)
+	{
+		// Let go of the weapon we grabbed, the server's version of it replicates back
+		AWeapon* WeaponBefore = Mispredicted.WeaponBefore.Get();
+		if (EquippedWeapon && EquippedWeapon != WeaponBefore)
 		{
-			Arm();
+			EquippedWeapon->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+			OverlappingItem = EquippedWeapon;
 		}
+		EquippedWeapon = WeaponBefore;
+	}
+
+	// Anything predicted after it was built on top of it
+	PendingActions.Reset();
+	ActionState = ServerActionState;
+	CharacterState = ServerCharacterState;
+	if (EquippedWeapon)
+	{
+		EquippedWeapon->AttachMeshToSocket(GetMesh(), GetEquippedWeaponSocket());
+	}
+}
+
+void ASlashCharacter::CatchUpWithOwner()
+{
+	if (ActionState != EActionState::EAS_Attacking && ActionState != EActionState::EAS_EquippingWeapon) return;
+
+	// The owner started the montage half a round trip before we did, so its end notify fires that
+	// much earlier too. Finish ours when it's that close to done instead of refusing the next action.
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	UAnimMontage* Montage = AnimInstance ? AnimInstance->GetCurrentActiveMontage() : nullptr;
+	if (Montage == nullptr) return;
+
+	const float Position = AnimInstance->Montage_GetPosition(Montage);
+	float SectionStart = 0.f;
+	float SectionEnd = 0.f;
+	Montage->GetSectionStartAndEndTime(Montage->GetSectionIndexFromPosition(Position), SectionStart, SectionEnd);
+	const float Remaining = (SectionEnd - Position) / FMath::Max(AnimInstance->Montage_GetPlayRate(Montage), UE_KINDA_SMALL_NUMBER);
+	const float HalfPing = GetPlayerState() ? GetPlayerState()->GetPingInMilliseconds() * 0.0005f : 0.f;
+
+	if (Remaining <= HalfPing + CVarPredictionCatchUpTime.GetValueOnGameThread())
+	{
+		SetActionState(EActionState::EAS_Unoccupied);
+	}
+}
+
+void ASlashCharacter::DumpPredictionStats() const
+{
+	const float Rate = NumPredictedActions > 0 ? 100.f * NumMispredictions / NumPredictedActions : 0.f;
+	UE_LOG(LogTemp, Display, TEXT("%s: %d actions predicted, %d mispredicted (%.1f%%), %d waiting on the server"),
+		*GetName(), NumPredictedActions, NumMispredictions, Rate, PendingActions.Num());
+}
+
+void ASlashCharacter::ServerLagCompProbe_Implementation(ACharacter* Target, FVector_NetQuantize SeenLocation, double ClientTime)
+{
+#if !UE_BUILD_SHIPPING
+	if (ULagCompensationSubsystem* LagComp = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		LagComp->ProbeHit(Target, SeenLocation, ClientTime);
 	}
+#endif
+}
+
+FName ASlashCharacter::GetEquippedWeaponSocket() const
+{
+	return CharacterState == ECharacterState::ECS_Unequipped ? FName("SpineSocket") : FName("RightHandSocket");
+}
+
+bool ASlashCharacter::IsMontagePredictedLocally(const UAnimMontage* Montage) const
+{
+	if (bPlayingPredictedMontage || HasAuthority() || !IsLocallyControlled()) return false;
+	return Montage == EquipMontage || Montage == GetAttackMontage();
 }
 
 void ASlashCharacter::EquipWeapon(AWeapon* Weapon)
@@ -150,19 +506,70 @@ void ASlashCharacter::EquipWeapon(AWeapon* Weapon)
 	SetStateToEquippedWeaponHandedness();
 }
 
+EPredictedAction ASlashCharacter::PerformEKeyAction()
+{
+	AWeapon* OverlappingWeapon = Cast<AWeapon>(OverlappingItem);
+	if (OverlappingWeapon)
+	{
+		EquipWeapon(OverlappingWeapon);
+		return EPredictedAction::EPA_PickUp;
+	}
+	if (CanDisarm())
+	{
+		Disarm();
+		return EPredictedAction::EPA_Disarm;
+	}
+	if (CanArm())
+	{
+		Arm();
+		return EPredictedAction::EPA_Arm;
+	}
+	return EPredictedAction::EPA_None;
+}
+
+int32 ASlashCharacter::PerformAttack(int32 AttackSection)
+{
+	const int32 PlayedSection = PlayAttackMontage(AttackSection);
+	if (PlayedSection != INDEX_NONE)
+	{
+		UInputLatencySubsystem::NoteEffect(this, ELatencyEffect::AttackMontage);
+	}
+	SetActionState(EActionState::EAS_Attacking);
+	return PlayedSection;
+}
+
+void ASlashCharacter::SetActionState(EActionState NewState)
+{
+	ActionState = NewState;
+	if (HasAuthority())
+	{
+		AuthActionState = NewState;
+	}
+}
+
+void ASlashCharacter::SetCharacterState(ECharacterState NewState)
+{
+	CharacterState = NewState;
+	if (HasAuthority())
+	{
+		AuthCharacterState = NewState;
+	}
+}
+
 void ASlashCharacter::Attack()
 {
 	Super::Attack();
 	if (CanAttack())
 	{
-		PlayAttackMontage();
-		ActionState = EActionState::EAS_Attacking;
+		PerformAttack(INDEX_NONE);
 	}
 }
 
 void ASlashCharacter::AttackEnd()
 {
-	ActionState = EActionState::EAS_Unoccupied;
+	// The montage notifies fire on every machine, the server and the predicting owner act on them
+	if (!HasAuthority() && !IsLocallyControlled()) return;
+	SetActionState(EActionState::EAS_Unoccupied);
 }
 
 bool ASlashCharacter::CanAttack()
@@ -186,31 +593,32 @@ bool ASlashCharacter::CanArm()
 void ASlashCharacter::Disarm()
 {
 	PlayEquipMontage(FName("Unequip"));
-	CharacterState = ECharacterState::ECS_Unequipped;
-	ActionState = EActionState::EAS_EquippingWeapon;
+	SetCharacterState(ECharacterState::ECS_Unequipped);
+	SetActionState(EActionState::EAS_EquippingWeapon);
 }
 
 void ASlashCharacter::Arm()
 {
 	PlayEquipMontage(FName("Equip"));
 	SetStateToEquippedWeaponHandedness();
-	ActionState = EActionState::EAS_EquippingWeapon;
+	SetActionState(EActionState::EAS_EquippingWeapon);
 }
 
 void ASlashCharacter::PlayEquipMontage(const FName& SectionName)
 {
-	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
-	if (AnimInstance && EquipMontage)
+	if (EquipMontage)
 	{
-		AnimInstance->Montage_Play(EquipMontage);
-		AnimInstance->Montage_JumpToSection(SectionName, EquipMontage);
+		MulticastPlayMontageSection(EquipMontage, SectionName);
+		UInputLatencySubsystem::NoteEffect(this, ELatencyEffect::EquipMontage);
 	}
 }
 
 void ASlashCharacter::Move(const FInputActionValue& Value)
 {
-	if (ActionState != EActionState::EAS_Unoccupied) return;
 	const FVector2D MovementVector = Value.Get<FVector2D>();
+	USessionRecorderSubsystem::NoteInput(this, ESessionInput::Move, MovementVector);
+	UInputLatencySubsystem::NoteInput(this, ELatencyInput::Move);
+	if (ActionState != EActionState::EAS_Unoccupied) return;
 	/*FVector Forward = GetActorForwardVector();
 	AddMovementInput(Forward, MovementVector.Y);
 	FVector Right = GetActorRightVector();
@@ -227,6 +635,7 @@ void ASlashCharacter::Move(const FInputActionValue& Value)
 void ASlashCharacter::Look(const FInputActionValue& Value)
 {
 	const FVector2D LookAxisVector = Value.Get<FVector2D>();
+	USessionRecorderSubsystem::NoteInput(this, ESessionInput::Look, LookAxisVector);
 	AddControllerPitchInput(LookAxisVector.Y);
 	// UE_LOG(LogTemp, Warning, TEXT("The y value is %d"), LookAxisVector.Y);
 	AddControllerYawInput(LookAxisVector.X);
@@ -251,12 +660,14 @@ void ASlashCharacter::AttachWeaponToHand()
 
 void ASlashCharacter::FinishEquipping()
 {
-	ActionState = EActionState::EAS_Unoccupied;
+	if (!HasAuthority() && !IsLocallyControlled()) return;
+	SetActionState(EActionState::EAS_Unoccupied);
 }
 
 void ASlashCharacter::HitReactEnd()
 {
-	ActionState = EActionState::EAS_Unoccupied;
+	if (!HasAuthority() && !IsLocallyControlled()) return;
+	SetActionState(EActionState::EAS_Unoccupied);
 }
 
 void ASlashCharacter::SetStateToEquippedWeaponHandedness()
@@ -266,10 +677,10 @@ void ASlashCharacter::SetStateToEquippedWeaponHandedness()
 		switch (EquippedWeapon->Handedness)
 		{
 		case EWeaponHanded::EWH_OneHanded:
-			CharacterState = ECharacterState::ECS_EquippedOneHandedWeapon;
+			SetCharacterState(ECharacterState::ECS_EquippedOneHandedWeapon);
 			break;
 		case EWeaponHanded::EWH_TwoHanded:
-			CharacterState = ECharacterState::ECS_EquippedTwoHandedWeapon;
+			SetCharacterState(ECharacterState::ECS_EquippedTwoHandedWeapon);
 			break;
 		}
 	}
@@ -1,9 +1,12 @@
 #include "Components/AttributeComponent.h"
+#include "CombatCore/CombatCore.h"
+#include "Net/UnrealNetwork.h"
 
 UAttributeComponent::UAttributeComponent()
 {
 	PrimaryComponentTick.bCanEverTick = true;
 
+	SetIsReplicatedByDefault(true);
 }
 
 
@@ -11,7 +14,7 @@ void UAttributeComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	
+	UpdateReplicatedHealth();
 }
 
 
@@ -21,9 +24,17 @@ void UAttributeComponent::TickComponent(float DeltaTime, ELevelTick TickType, FA
 
 }
 
+void UAttributeComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UAttributeComponent, ReplicatedHealth);
+}
+
 void UAttributeComponent::ReceiveDamage(float Damage)
 {
-	Health = FMath::Clamp(Health - Damage, 0.f, MaxHealth);
+	Health = CombatCore::ApplyDamage(Health, Damage, MaxHealth);
+	UpdateReplicatedHealth();
 }
 
 float UAttributeComponent::GetHealthPercent()
@@ -31,8 +42,31 @@ float UAttributeComponent::GetHealthPercent()
 	return Health / MaxHealth;
 }
 
+void UAttributeComponent::SetHealthPercent(float Percent)
+{
+	Health = FMath::Clamp(Percent, 0.f, 1.f) * MaxHealth;
+	UpdateReplicatedHealth();
+}
+
 bool UAttributeComponent::IsAlive()
 {
 	return Health > 0.f;
 }
 
+void UAttributeComponent::AddGold(int32 Amount)
+{
+	Gold += Amount;
+}
+
+
+void UAttributeComponent::UpdateReplicatedHealth()
+{
+	// Anything still alive keeps at least one step so clients don't see it as dead
+	ReplicatedHealth = CombatCore::QuantizeHealth(Health, MaxHealth);
+}
+
+void UAttributeComponent::OnRep_ReplicatedHealth()
+{
+	Health = ReplicatedHealth / 255.f * MaxHealth;
+	OnHealthChanged.Broadcast(GetHealthPercent());
+}
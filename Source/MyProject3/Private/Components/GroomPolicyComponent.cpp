@@ -0,0 +1,133 @@
+#include "Components/GroomPolicyComponent.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GroomComponent.h"
+#include "Kismet/GameplayStatics.h"
+#include "Scalability.h"
+
+static TAutoConsoleVariable<int32> CVarGroomQuality(
+	TEXT("slash.Groom.Quality"),
+	-1,
+	TEXT("Best groom detail allowed. 0 mesh, 1 cards, 2 strands, 3 simulated strands, -1 follows effects quality."));
+
+UGroomPolicyComponent::UGroomPolicyComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.TickInterval = 0.2f;
+}
+
+void UGroomPolicyComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Nothing to manage on servers and headless runs where the grooms were never created
+	SetComponentTickEnabled(Grooms.Num() > 0);
+}
+
+void UGroomPolicyComponent::AddGroom(UGroomComponent* Groom)
+{
+	if (Groom == nullptr) return;
+
+	Grooms.Add(Groom);
+	AppliedDetail.AddDefaulted();
+	SetComponentTickEnabled(true);
+}
+
+void UGroomPolicyComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	APlayerCameraManager* CameraManager = UGameplayStatics::GetPlayerCameraManager(this, 0);
+	if (CameraManager == nullptr) return;
+
+	const FVector ViewLocation = CameraManager->GetCameraLocation();
+	const float TanHalfFOV = FMath::Tan(FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5f));
+	const bool bRendered = GetOwner()->WasRecentlyRendered(OffscreenTime);
+
+	for (int32 Index = 0; Index < Grooms.Num(); ++Index)
+	{
+		UGroomComponent* Groom = Grooms[Index];
+		if (Groom == nullptr) continue;
+
+		const EGroomDetail Detail = bRendered ? ChooseDetail(Groom, ViewLocation, TanHalfFOV) : EGroomDetail::EGD_Hidden;
+		if (!AppliedDetail[Index].IsSet() || AppliedDetail[Index].GetValue() != Detail)
+		{
+			ApplyDetail(Groom, Detail);
+			AppliedDetail[Index] = Detail;
+		}
+	}
+}
+
+EGroomDetail UGroomPolicyComponent::ChooseDetail(const UGroomComponent* Groom, const FVector& ViewLocation, float TanHalfFOV) const
+{
+	const double Distance = FVector::Dist(ViewLocation, Groom->Bounds.Origin);
+	if (Distance > MaxDrawDistance) return EGroomDetail::EGD_Hidden;
+
+	const double ScreenSize = Groom->Bounds.SphereRadius / FMath::Max(1.0, Distance * TanHalfFOV);
+	EGroomDetail Detail = EGroomDetail::EGD_Mesh;
+	if (ScreenSize >= SimulationScreenSize)
+	{
+		Detail = EGroomDetail::EGD_Simulated;
+	}
+	else if (ScreenSize >= StrandsScreenSize)
+	{
+		Detail = EGroomDetail::EGD_Strands;
+	}
+	else if (ScreenSize >= CardsScreenSize)
+	{
+		Detail = EGroomDetail::EGD_Cards;
+	}
+
+	// Lower enum values are more detailed
+	return FMath::Max(Detail, GetBestAllowedDetail());
+}
+
+void UGroomPolicyComponent::ApplyDetail(UGroomComponent* Groom, EGroomDetail Detail)
+{
+	const int32 MaxLOD = FMath::Max(0, Groom->GetNumLODs() - 1);
+
+	switch (Detail)
+	{
+	case EGroomDetail::EGD_Simulated:
+		Groom->SetForcedLOD(-1);
+		Groom->SetEnableSimulation(true);
+		break;
+	case EGroomDetail::EGD_Strands:
+		Groom->SetForcedLOD(-1);
+		Groom->SetEnableSimulation(false);
+		break;
+	case EGroomDetail::EGD_Cards:
+		Groom->SetForcedLOD(FMath::Min(CardsLOD, MaxLOD));
+		Groom->SetEnableSimulation(false);
+		break;
+	case EGroomDetail::EGD_Mesh:
+		Groom->SetForcedLOD(FMath::Min(MeshLOD, MaxLOD));
+		Groom->SetEnableSimulation(false);
+		break;
+	case EGroomDetail::EGD_Hidden:
+		Groom->SetEnableSimulation(false);
+		break;
+	}
+
+	// Hidden grooms don't need their tick at all, that's where the CPU side update lives
+	const bool bVisible = Detail != EGroomDetail::EGD_Hidden;
+	Groom->SetVisibility(bVisible);
+	Groom->SetComponentTickEnabled(bVisible);
+}
+
+EGroomDetail UGroomPolicyComponent::GetBestAllowedDetail() const
+{
+	int32 Quality = CVarGroomQuality.GetValueOnGameThread();
+	if (Quality < 0)
+	{
+		// Low effects quality gets mesh, medium cards, high strands, epic and up simulated strands
+		Quality = FMath::Min(Scalability::GetQualityLevels().EffectsQuality, 3);
+	}
+
+	switch (Quality)
+	{
+	case 0: return EGroomDetail::EGD_Mesh;
+	case 1: return EGroomDetail::EGD_Cards;
+	case 2: return EGroomDetail::EGD_Strands;
+	default: return EGroomDetail::EGD_Simulated;
+	}
+}
@@ -0,0 +1,58 @@
+#include "Components/PersistentStateComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+UPersistentStateComponent::UPersistentStateComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+#if WITH_EDITOR
+void UPersistentStateComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	UWorld* World = GetWorld();
+	if (!PersistentGuid.IsValid() && !IsTemplate() && World && !World->IsGameWorld())
+	{
+		Modify();
+		PersistentGuid = FGuid::NewGuid();
+	}
+}
+
+void UPersistentStateComponent::PostEditImport()
+{
+	Super::PostEditImport();
+
+	// Pasted actors come through here with the source actor's guid
+	PersistentGuid = FGuid::NewGuid();
+}
+#endif
+
+bool UPersistentStateComponent::LoadState(FPersistentActorState& OutState) const
+{
+	UActorStateSubsystem* ActorState = GetActorStateSubsystem();
+	return ActorState && PersistentGuid.IsValid() && ActorState->FindState(PersistentGuid, OutState);
+}
+
+void UPersistentStateComponent::SaveState(const FPersistentActorState& State) const
+{
+	if (UActorStateSubsystem* ActorState = GetActorStateSubsystem())
+	{
+		ActorState->SetState(PersistentGuid, State);
+	}
+}
+
+FPersistentActorState UPersistentStateComponent::GetState() const
+{
+	FPersistentActorState State;
+	LoadState(State);
+	return State;
+}
+
+UActorStateSubsystem* UPersistentStateComponent::GetActorStateSubsystem() const
+{
+	UWorld* World = GetWorld();
+	UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UActorStateSubsystem>() : nullptr;
+}
@@ -0,0 +1,244 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/CombatTelemetrySubsystem.h"
+#include "Engine/World.h"
+#include "HAL/FileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+#include "Trace/Trace.inl"
+#include <atomic>
+
+static TAutoConsoleVariable<bool> CVarTelemetryEnabled(
+	TEXT("slash.Telemetry.Enabled"),
+	true,
+	TEXT("Records hits, enemy state changes, deaths and spawns to Saved/Profiling/CombatTelemetry and the SlashCombat trace channel."));
+
+static TAutoConsoleVariable<float> CVarTelemetryFlushInterval(
+	TEXT("slash.Telemetry.FlushInterval"),
+	1.f,
+	TEXT("Seconds between draining the telemetry rings to the file."));
+
+static FAutoConsoleCommandWithWorld TelemetryFlushCommand(
+	TEXT("slash.Telemetry.Flush"),
+	TEXT("Writes every combat event recorded so far to the telemetry file."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UCombatTelemetrySubsystem* Telemetry = World ? World->GetSubsystem<UCombatTelemetrySubsystem>() : nullptr)
+		{
+			Telemetry->Flush();
+		}
+	}));
+
+namespace
+{
+	// Set while some world's subsystem owns the file, with several PIE worlds only the first writes
+	std::atomic<bool> bHasWriter{ false };
+}
+
+#if SLASH_COMBAT_TELEMETRY
+
+UE_TRACE_CHANNEL_DEFINE(SlashCombatChannel)
+
+UE_TRACE_EVENT_BEGIN(SlashCombat, Event)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, Frame)
+	UE_TRACE_EVENT_FIELD(uint32, Subject)
+	UE_TRACE_EVENT_FIELD(uint32, Other)
+	UE_TRACE_EVENT_FIELD(float, X)
+	UE_TRACE_EVENT_FIELD(float, Y)
+	UE_TRACE_EVENT_FIELD(float, Z)
+	UE_TRACE_EVENT_FIELD(float, Value)
+	UE_TRACE_EVENT_FIELD(uint8, Type)
+	UE_TRACE_EVENT_FIELD(uint8, Detail)
+	UE_TRACE_EVENT_FIELD(uint8, PreviousDetail)
+UE_TRACE_EVENT_END()
+
+namespace
+{
+	// Single producer, the owning thread, and single consumer, the flush task
+	struct FThreadRing
+	{
+		static constexpr uint32 Capacity = 4096;
+
+		CombatTelemetry::FRecord Records[Capacity];
+		std::atomic<uint32> Head{ 0 };
+		std::atomic<uint32> Tail{ 0 };
+	};
+
+	static_assert(FMath::IsPowerOfTwo(FThreadRing::Capacity), "Ring indices wrap with a mask");
+
+	// Rings live until exit, a thread that ends leaves its last events to be drained
+	FCriticalSection& GetRingsLock()
+	{
+		static FCriticalSection Lock;
+		return Lock;
+	}
+
+	TArray<TUniquePtr<FThreadRing>>& GetRings()
+	{
+		static TArray<TUniquePtr<FThreadRing>> Rings;
+		return Rings;
+	}
+
+	std::atomic<uint64> NumDropped{ 0 };
+
+	FThreadRing& GetThreadRing()
+	{
+		thread_local FThreadRing* Ring = nullptr;
+		if (Ring == nullptr)
+		{
+			FScopeLock Lock(&GetRingsLock());
+			Ring = GetRings().Add_GetRef(MakeUnique<FThreadRing>()).Get();
+		}
+		return *Ring;
+	}
+
+	void DrainRings(TArray<CombatTelemetry::FRecord>& Out)
+	{
+		FScopeLock Lock(&GetRingsLock());
+		for (const TUniquePtr<FThreadRing>& Ring : GetRings())
+		{
+			const uint32 Tail = Ring->Tail.load(std::memory_order_relaxed);
+			const uint32 Head = Ring->Head.load(std::memory_order_acquire);
+			for (uint32 Index = Tail; Index != Head; ++Index)
+			{
+				Out.Add(Ring->Records[Index & (FThreadRing::Capacity - 1)]);
+			}
+			Ring->Tail.store(Head, std::memory_order_release);
+		}
+	}
+}
+
+#endif
+
+void UCombatTelemetrySubsystem::Record(ECombatEvent Type, const AActor* Subject, const AActor* Other, const FVector& Location, float Value, uint8 Detail, uint8 PreviousDetail)
+{
+#if SLASH_COMBAT_TELEMETRY
+	if (!CVarTelemetryEnabled.GetValueOnAnyThread()) return;
+
+	CombatTelemetry::FRecord Record;
+	Record.Cycles = FPlatformTime::Cycles64();
+	Record.Frame = static_cast<uint32>(GFrameCounter);
+	Record.Subject = Subject ? Subject->GetUniqueID() : 0;
+	Record.Other = Other ? Other->GetUniqueID() : 0;
+	Record.Location = FVector3f(Location);
+	Record.Value = Value;
+	Record.Type = Type;
+	Record.Detail = Detail;
+	Record.PreviousDetail = PreviousDetail;
+	Record.Padding = 0;
+
+	FThreadRing& Ring = GetThreadRing();
+	const uint32 Head = Ring.Head.load(std::memory_order_relaxed);
+	if (Head - Ring.Tail.load(std::memory_order_acquire) < FThreadRing::Capacity)
+	{
+		Ring.Records[Head & (FThreadRing::Capacity - 1)] = Record;
+		Ring.Head.store(Head + 1, std::memory_order_release);
+	}
+	else
+	{
+		NumDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	UE_TRACE_LOG(SlashCombat, Event, SlashCombatChannel)
+		<< Event.Cycle(Record.Cycles)
+		<< Event.Frame(Record.Frame)
+		<< Event.Subject(Record.Subject)
+		<< Event.Other(Record.Other)
+		<< Event.X(Record.Location.X)
+		<< Event.Y(Record.Location.Y)
+		<< Event.Z(Record.Location.Z)
+		<< Event.Value(Record.Value)
+		<< Event.Type(static_cast<uint8>(Record.Type))
+		<< Event.Detail(Record.Detail)
+		<< Event.PreviousDetail(Record.PreviousDetail);
+#endif
+}
+
+bool UCombatTelemetrySubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return SLASH_COMBAT_TELEMETRY && Super::ShouldCreateSubsystem(Outer);
+}
+
+void UCombatTelemetrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	bool bExpected = false;
+	bWriter = bHasWriter.compare_exchange_strong(bExpected, true);
+	Path = FPaths::Combine(FPaths::ProfilingDir(), TEXT("CombatTelemetry"),
+		FString::Printf(TEXT("Combat_%s.bin"), *FDateTime::Now().ToString()));
+}
+
+void UCombatTelemetrySubsystem::Deinitialize()
+{
+	if (bWriter)
+	{
+		Flush();
+		File.Reset();
+#if SLASH_COMBAT_TELEMETRY
+		UE_LOG(LogTemp, Display, TEXT("Telemetry: %llu combat events in %s, %llu dropped on full rings"),
+			NumWritten, *Path, NumDropped.exchange(0));
+#endif
+		// Hand the rings to whichever world comes next
+		bWriter = false;
+		bHasWriter = false;
+	}
+	Super::Deinitialize();
+}
+
+void UCombatTelemetrySubsystem::Tick(float DeltaTime)
+{
+	TimeSinceFlush += DeltaTime;
+	if (!bWriter || TimeSinceFlush < CVarTelemetryFlushInterval.GetValueOnGameThread() || !FlushTask.IsCompleted()) return;
+	TimeSinceFlush = 0.f;
+
+	// Keep the disk off the game thread
+	FlushTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this]() { WriteRecords(); });
+}
+
+void UCombatTelemetrySubsystem::Flush()
+{
+	if (!bWriter) return;
+	FlushTask.Wait();
+	WriteRecords();
+}
+
+bool UCombatTelemetrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCombatTelemetrySubsystem::WriteRecords()
+{
+#if SLASH_COMBAT_TELEMETRY
+	Drained.Reset();
+	DrainRings(Drained);
+	if (Drained.Num() == 0) return;
+
+	if (!File.IsValid())
+	{
+		File.Reset(IFileManager::Get().CreateFileWriter(*Path));
+		if (!File.IsValid())
+		{
+			UE_LOG(LogTemp, Error, TEXT("Telemetry: couldn't write %s"), *Path);
+			return;
+		}
+		CombatTelemetry::FHeader Header;
+		Header.Magic = CombatTelemetry::Magic;
+		Header.Version = CombatTelemetry::Version;
+		Header.RecordSize = sizeof(CombatTelemetry::FRecord);
+		Header.SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+		File->Serialize(&Header, sizeof(Header));
+	}
+	File->Serialize(Drained.GetData(), Drained.Num() * sizeof(CombatTelemetry::FRecord));
+	File->Flush();
+	NumWritten += Drained.Num();
+#endif
+}
+
+TStatId UCombatTelemetrySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatTelemetrySubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Async/Async.h"
+#include "Breakable/DestructionSubsystem.h"
+#include "Components/BoxComponent.h"
+#include "Enemy/Enemy.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Items/Weapons/Weapon.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Spawning/SpawnDirectorSubsystem.h"
+#include "UObject/UObjectGlobals.h"
+
+static TAutoConsoleVariable<float> CVarHitchThresholdMs(
+	TEXT("slash.Hitch.ThresholdMs"),
+	50.f,
+	TEXT("Frames longer than this are written to Saved/Hitches with the last few seconds before them, 0 turns it off."));
+
+static TAutoConsoleVariable<float> CVarHitchCooldown(
+	TEXT("slash.Hitch.Cooldown"),
+	10.f,
+	TEXT("Seconds after a hitch dump before another one is written."));
+
+static TAutoConsoleVariable<int32> CVarHitchMaxDumps(
+	TEXT("slash.Hitch.MaxDumps"),
+	20,
+	TEXT("Hitch dumps written per map at most."));
+
+uint64 UHitchDetectorSubsystem::FrameCycles[static_cast<int32>(EHitchSystem::Count)] = {};
+uint32 UHitchDetectorSubsystem::FrameSpawns = 0;
+double UHitchDetectorSubsystem::FrameGCSeconds = 0.0;
+
+namespace
+{
+	const TCHAR* GetSystemName(EHitchSystem System)
+	{
+		switch (System)
+		{
+		case EHitchSystem::AI: return TEXT("AI");
+		case EHitchSystem::Melee: return TEXT("Melee");
+		case EHitchSystem::Movement: return TEXT("Movement");
+		case EHitchSystem::Destruction: return TEXT("Destruction");
+		case EHitchSystem::Spawning: return TEXT("Spawning");
+		case EHitchSystem::LagComp: return TEXT("LagComp");
+		case EHitchSystem::Corpses: return TEXT("Corpses");
+		default: return TEXT("Unknown");
+		}
+	}
+}
+
+void UHitchDetectorSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Ring.SetNum(RingSize);
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UHitchDetectorSubsystem::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UHitchDetectorSubsystem::OnPostGarbageCollect);
+}
+
+void UHitchDetectorSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+	Super::Deinitialize();
+}
+
+bool UHitchDetectorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHitchDetectorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitchDetectorSubsystem, STATGROUP_Tickables);
+}
+
+void UHitchDetectorSubsystem::AddSystemCycles(EHitchSystem System, uint64 Cycles)
+{
+	if (IsInGameThread())
+	{
+		FrameCycles[static_cast<int32>(System)] += Cycles;
+	}
+}
+
+void UHitchDetectorSubsystem::NoteSpawn()
+{
+	if (IsInGameThread())
+	{
+		++FrameSpawns;
+	}
+}
+
+void UHitchDetectorSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Everything since the last tick, GC after it included, belongs to the frame closing now
+	const double Now = FPlatformTime::Seconds();
+	const bool bFirstTick = LastTickTime == 0.0;
+	const double FrameMs = (Now - LastTickTime) * 1000.0;
+	LastTickTime = Now;
+
+	FHitchFrame& Frame = Ring[RingHead];
+	RingHead = (RingHead + 1) % RingSize;
+	RingCount = FMath::Min(RingCount + 1, RingSize);
+	CloseFrame(Frame, bFirstTick ? 0.0 : FrameMs);
+
+	const float Threshold = CVarHitchThresholdMs.GetValueOnGameThread();
+	if (bFirstTick || Threshold <= 0.f || Frame.FrameMs < Threshold) return;
+	if (Now - LastDumpTime < CVarHitchCooldown.GetValueOnGameThread() || NumDumps >= CVarHitchMaxDumps.GetValueOnGameThread()) return;
+
+	LastDumpTime = Now;
+	++NumDumps;
+	DumpHitch(Frame);
+}
+
+void UHitchDetectorSubsystem::CloseFrame(FHitchFrame& Frame, double FrameMs)
+{
+	Frame.FrameNumber = GFrameCounter;
+	Frame.FrameMs = static_cast<float>(FrameMs);
+	Frame.GCMs = static_cast<float>(FrameGCSeconds * 1000.0);
+	Frame.Spawns = FrameSpawns;
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(FrameCycles); ++Index)
+	{
+		Frame.SystemMs[Index] = static_cast<float>(FPlatformTime::ToMilliseconds64(FrameCycles[Index]));
+		FrameCycles[Index] = 0;
+	}
+	FrameSpawns = 0;
+	FrameGCSeconds = 0.0;
+}
+
+void UHitchDetectorSubsystem::DumpHitch(const FHitchFrame& Hitch)
+{
+	FString Text = DescribeContext(Hitch);
+
+	Text += TEXT("frame,frame_ms,gc_ms,spawns");
+	for (int32 Index = 0; Index < static_cast<int32>(EHitchSystem::Count); ++Index)
+	{
+		Text += TEXT(",");
+		Text += GetSystemName(static_cast<EHitchSystem>(Index));
+	}
+	Text += TEXT("\n");
+
+	// Oldest first, ending with the hitch
+	for (int32 Offset = RingCount; Offset > 0; --Offset)
+	{
+		const FHitchFrame& Frame = Ring[(RingHead - Offset + RingSize) % RingSize];
+		Text += FString::Printf(TEXT("%llu,%.2f,%.2f,%u"), Frame.FrameNumber, Frame.FrameMs, Frame.GCMs, Frame.Spawns);
+		for (const float SystemMs : Frame.SystemMs)
+		{
+			Text += FString::Printf(TEXT(",%.2f"), SystemMs);
+		}
+		Text += TEXT("\n");
+	}
+
+	const FString Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Hitches"),
+		FString::Printf(TEXT("Hitch_%s_%llu.txt"), *FDateTime::Now().ToString(), Hitch.FrameNumber));
+	UE_LOG(LogTemp, Warning, TEXT("Hitch: %.1f ms frame, details in %s"), Hitch.FrameMs, *Path);
+
+	// Keep the disk off the game thread, this is already a slow frame
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [Text = MoveTemp(Text), Path]()
+	{
+		FFileHelper::SaveStringToFile(Text, *Path);
+	});
+}
+
+FString UHitchDetectorSubsystem::DescribeContext(const FHitchFrame& Hitch) const
+{
+	UWorld* World = GetWorld();
+	FString Text = FString::Printf(TEXT("Hitch at frame %llu: %.1f ms on %s, threshold %.0f ms\n"),
+		Hitch.FrameNumber, Hitch.FrameMs, *World->GetMapName(), CVarHitchThresholdMs.GetValueOnGameThread());
+
+	const UEnum* EnemyStateEnum = StaticEnum<EEnemyState>();
+	TMap<EEnemyState, int32> EnemiesByState;
+	for (TActorIterator<AEnemy> It(World); It; ++It)
+	{
+		++EnemiesByState.FindOrAdd(It->GetEnemyState());
+	}
+	Text += TEXT("enemies:");
+	for (const TPair<EEnemyState, int32>& Count : EnemiesByState)
+	{
+		Text += FString::Printf(TEXT(" %s=%d"), *EnemyStateEnum->GetNameStringByValue(static_cast<int64>(Count.Key)), Count.Value);
+	}
+	Text += TEXT("\n");
+
+	int32 ActiveSwings = 0;
+	for (TActorIterator<AWeapon> It(World); It; ++It)
+	{
+		if (It->GetWeaponBox() && It->GetWeaponBox()->IsCollisionEnabled()) ++ActiveSwings;
+	}
+	Text += FString::Printf(TEXT("active swings: %d\n"), ActiveSwings);
+
+	if (const UDestructionSubsystem* Destruction = World->GetSubsystem<UDestructionSubsystem>())
+	{
+		Text += FString::Printf(TEXT("fracturing breakables: %d, %d rigid bodies\n"), Destruction->GetNumActiveFractures(), Destruction->GetNumActiveRigidBodies());
+	}
+
+	const USpawnDirectorSubsystem* SpawnDirector = World->GetSubsystem<USpawnDirectorSubsystem>();
+	Text += FString::Printf(TEXT("spawns this frame: %u, backlog %d\n"), Hitch.Spawns, SpawnDirector ? SpawnDirector->GetBacklog() : 0);
+	Text += FString::Printf(TEXT("gc: %.2f ms\n"), Hitch.GCMs);
+	return Text;
+}
+
+void UHitchDetectorSubsystem::OnPreGarbageCollect()
+{
+	GCStartTime = FPlatformTime::Seconds();
+}
+
+void UHitchDetectorSubsystem::OnPostGarbageCollect()
+{
+	if (GCStartTime > 0.0)
+	{
+		FrameGCSeconds += FPlatformTime::Seconds() - GCStartTime;
+		GCStartTime = 0.0;
+	}
+}
@@ -0,0 +1,258 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/InputLatencySubsystem.h"
+#include "Characters/SlashCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+static TAutoConsoleVariable<float> CVarSyntheticInputInterval(
+	TEXT("slash.InputLatency.SyntheticInterval"),
+	0.f,
+	TEXT("Seconds between synthetic attack, E and move presses for the local player, 0 turns them off."));
+
+static FAutoConsoleCommandWithWorld InputLatencyReportCommand(
+	TEXT("slash.InputLatency.Report"),
+	TEXT("Logs the input to action latency histograms of the local player."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UInputLatencySubsystem* InputLatency = World ? World->GetSubsystem<UInputLatencySubsystem>() : nullptr)
+		{
+			InputLatency->LogReport();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs InputLatencyCsvCommand(
+	TEXT("slash.InputLatency.Csv"),
+	TEXT("Writes the input latency histograms to a CSV, Saved/Profiling/InputLatency.csv unless a path is given."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UInputLatencySubsystem* InputLatency = World ? World->GetSubsystem<UInputLatencySubsystem>() : nullptr)
+		{
+			InputLatency->WriteCsv(Args.Num() > 0 ? Args[0] : FString());
+		}
+	}));
+
+namespace
+{
+	// An input whose effect never came (an attack that wasn't allowed) stops waiting after this
+	constexpr double MaxPendingSeconds = 1.0;
+	constexpr float SyntheticMoveSeconds = 0.25f;
+}
+
+void UInputLatencySubsystem::FHistogram::Add(double LatencyMs)
+{
+	const int32 Bucket = FMath::Min(FMath::FloorToInt32(LatencyMs / BucketMs), NumBuckets - 1);
+	++Buckets[FMath::Max(Bucket, 0)];
+	++Count;
+	TotalMs += LatencyMs;
+	MaxMs = FMath::Max(MaxMs, LatencyMs);
+}
+
+double UInputLatencySubsystem::FHistogram::GetPercentile(double Percentile) const
+{
+	if (Count == 0) return 0.0;
+
+	// Upper edge of the bucket the percentile lands in
+	const uint32 Target = FMath::Max<uint32>(1, FMath::CeilToInt32(Count * Percentile));
+	uint32 Seen = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Seen += Buckets[Bucket];
+		if (Seen >= Target)
+		{
+			return Bucket == NumBuckets - 1 ? MaxMs : (Bucket + 1) * BucketMs;
+		}
+	}
+	return MaxMs;
+}
+
+void UInputLatencySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	FParse::Value(FCommandLine::Get(), TEXT("InputLatencyCsv="), ExitCsvPath);
+}
+
+void UInputLatencySubsystem::Deinitialize()
+{
+	if (!ExitCsvPath.IsEmpty())
+	{
+		LogReport();
+		WriteCsv(ExitCsvPath);
+	}
+	Super::Deinitialize();
+}
+
+bool UInputLatencySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UInputLatencySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UInputLatencySubsystem, STATGROUP_Tickables);
+}
+
+void UInputLatencySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now = FPlatformTime::Seconds();
+	for (double& InputTime : PendingInputTime)
+	{
+		if (InputTime > 0.0 && Now - InputTime > MaxPendingSeconds)
+		{
+			InputTime = 0.0;
+		}
+	}
+
+	// Movement has no single place it starts, look for the first frame with velocity
+	const APawn* Pawn = TrackedPawn.Get();
+	if (Pawn && PendingInputTime[static_cast<int32>(ELatencyEffect::Movement)] > 0.0 && Pawn->GetVelocity().SizeSquared2D() > 1.0)
+	{
+		NoteEffect(Pawn, ELatencyEffect::Movement);
+	}
+
+	DriveSyntheticInput(DeltaTime);
+}
+
+UInputLatencySubsystem* UInputLatencySubsystem::GetForPawn(const APawn* Pawn)
+{
+	if (Pawn == nullptr || !Pawn->IsLocallyControlled()) return nullptr;
+	UWorld* World = Pawn->GetWorld();
+	return World ? World->GetSubsystem<UInputLatencySubsystem>() : nullptr;
+}
+
+void UInputLatencySubsystem::NoteInput(const APawn* Pawn, ELatencyInput Input)
+{
+	UInputLatencySubsystem* InputLatency = GetForPawn(Pawn);
+	if (InputLatency == nullptr) return;
+
+	InputLatency->TrackedPawn = Pawn;
+	const double Now = FPlatformTime::Seconds();
+	switch (Input)
+	{
+	case ELatencyInput::Attack:
+		InputLatency->StartTiming(ELatencyEffect::AttackMontage, Now);
+		InputLatency->StartTiming(ELatencyEffect::AttackCollision, Now);
+		break;
+	case ELatencyInput::EKey:
+		InputLatency->StartTiming(ELatencyEffect::EquipMontage, Now);
+		break;
+	case ELatencyInput::Move:
+		// Move comes in every frame the stick is held, only a fresh press is timed
+		if (InputLatency->LastMoveInputFrame + 1 < GFrameCounter)
+		{
+			InputLatency->StartTiming(ELatencyEffect::Movement, Now);
+		}
+		InputLatency->LastMoveInputFrame = GFrameCounter;
+		break;
+	}
+}
+
+void UInputLatencySubsystem::NoteEffect(const APawn* Pawn, ELatencyEffect Effect)
+{
+	UInputLatencySubsystem* InputLatency = GetForPawn(Pawn);
+	if (InputLatency == nullptr) return;
+
+	double& InputTime = InputLatency->PendingInputTime[static_cast<int32>(Effect)];
+	if (InputTime <= 0.0) return;
+
+	InputLatency->Histograms[static_cast<int32>(Effect)].Add((FPlatformTime::Seconds() - InputTime) * 1000.0);
+	InputTime = 0.0;
+}
+
+void UInputLatencySubsystem::StartTiming(ELatencyEffect Effect, double Now)
+{
+	// Held buttons keep triggering, the first press is the one that counts
+	double& InputTime = PendingInputTime[static_cast<int32>(Effect)];
+	if (InputTime <= 0.0)
+	{
+		InputTime = Now;
+	}
+}
+
+void UInputLatencySubsystem::DriveSyntheticInput(float DeltaTime)
+{
+	const float Interval = CVarSyntheticInputInterval.GetValueOnGameThread();
+	if (Interval <= 0.f) return;
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	ASlashCharacter* Player = PlayerController ? Cast<ASlashCharacter>(PlayerController->GetPawn()) : nullptr;
+	if (Player == nullptr) return;
+
+	// Goes through the same handlers the bound input actions call
+	if (SyntheticMoveTimeLeft > 0.f)
+	{
+		SyntheticMoveTimeLeft -= DeltaTime;
+		Player->ReplayInput(ESessionInput::Move, FVector2D(0.0, 1.0));
+	}
+
+	TimeSinceSyntheticInput += DeltaTime;
+	if (TimeSinceSyntheticInput < Interval) return;
+	TimeSinceSyntheticInput = 0.f;
+
+	switch (NextSyntheticInput++ % 3)
+	{
+	case 0:
+		Player->ReplayInput(ESessionInput::Attack, FVector2D::ZeroVector);
+		break;
+	case 1:
+		Player->ReplayInput(ESessionInput::EKey, FVector2D::ZeroVector);
+		break;
+	case 2:
+		SyntheticMoveTimeLeft = SyntheticMoveSeconds;
+		break;
+	}
+}
+
+const TCHAR* UInputLatencySubsystem::GetEffectName(ELatencyEffect Effect)
+{
+	switch (Effect)
+	{
+	case ELatencyEffect::AttackMontage: return TEXT("AttackMontage");
+	case ELatencyEffect::AttackCollision: return TEXT("AttackCollision");
+	case ELatencyEffect::EquipMontage: return TEXT("EquipMontage");
+	case ELatencyEffect::Movement: return TEXT("Movement");
+	default: return TEXT("Unknown");
+	}
+}
+
+void UInputLatencySubsystem::LogReport() const
+{
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Histograms); ++Index)
+	{
+		const FHistogram& Histogram = Histograms[Index];
+		UE_LOG(LogTemp, Display, TEXT("InputLatency: %s %u samples, avg %.1f ms, p50 %.0f ms, p95 %.0f ms, p99 %.0f ms, max %.1f ms"),
+			GetEffectName(static_cast<ELatencyEffect>(Index)), Histogram.Count,
+			Histogram.Count > 0 ? Histogram.TotalMs / Histogram.Count : 0.0,
+			Histogram.GetPercentile(0.5), Histogram.GetPercentile(0.95), Histogram.GetPercentile(0.99), Histogram.MaxMs);
+	}
+}
+
+bool UInputLatencySubsystem::WriteCsv(const FString& Path) const
+{
+	const FString CsvPath = Path.IsEmpty() ? FPaths::Combine(FPaths::ProfilingDir(), TEXT("InputLatency.csv")) : Path;
+
+	FString Csv = TEXT("effect,bucket_start_ms,bucket_end_ms,count\n");
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Histograms); ++Index)
+	{
+		const FHistogram& Histogram = Histograms[Index];
+		for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+		{
+			// The open ended last bucket is written with its end at the largest sample
+			const double BucketEnd = Bucket == NumBuckets - 1 ? FMath::Max(Histogram.MaxMs, Bucket * BucketMs) : (Bucket + 1) * BucketMs;
+			Csv += FString::Printf(TEXT("%s,%.0f,%.0f,%u\n"), GetEffectName(static_cast<ELatencyEffect>(Index)), Bucket * BucketMs, BucketEnd, Histogram.Buckets[Bucket]);
+		}
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("InputLatency: couldn't write %s"), *CsvPath);
+		return false;
+	}
+	UE_LOG(LogTemp, Display, TEXT("InputLatency: wrote %s"), *CsvPath);
+	return true;
+}
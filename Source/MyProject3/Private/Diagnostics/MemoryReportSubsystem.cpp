@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/MemoryReportSubsystem.h"
+#include "Blueprint/UserWidget.h"
+#include "Breakable/BreakableActor.h"
+#include "Characters/BaseCharacter.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/WidgetComponent.h"
+#include "Engine/SkinnedAsset.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Controller.h"
+#include "GeometryCollection/GeometryCollectionComponent.h"
+#include "GeometryCollection/GeometryCollectionObject.h"
+#include "HAL/FileManager.h"
+#include "Interfaces/PreloadInterface.h"
+#include "Items/Item.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+#include "UObject/UObjectHash.h"
+
+static FAutoConsoleCommandWithWorld MemoryReportCommand(
+	TEXT("slash.Memory.Report"),
+	TEXT("Logs instance counts and the estimated memory per instance of the gameplay classes."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UMemoryReportSubsystem* MemoryReport = World ? World->GetSubsystem<UMemoryReportSubsystem>() : nullptr)
+		{
+			MemoryReport->LogReport();
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs MemoryCsvCommand(
+	TEXT("slash.Memory.Csv"),
+	TEXT("Appends the memory per instance of the gameplay classes to a CSV, Saved/Profiling/MemoryReport.csv unless a path is given."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UMemoryReportSubsystem* MemoryReport = World ? World->GetSubsystem<UMemoryReportSubsystem>() : nullptr)
+		{
+			MemoryReport->WriteCsv(Args.Num() > 0 ? Args[0] : FString());
+		}
+	}));
+
+namespace
+{
+	constexpr double BytesPerKB = 1024.0;
+
+	SIZE_T GetObjectBytes(UObject* Object)
+	{
+		return Object->GetClass()->GetStructureSize() + Object->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+	}
+
+	// The actor and everything it owns as subobjects: components, their anim instances, widgets
+	SIZE_T GetActorBytes(AActor* Actor)
+	{
+		TArray<UObject*> Objects;
+		GetObjectsWithOuter(Actor, Objects, true);
+		Objects.Add(Actor);
+
+		// Widget components create their user widget outside the actor
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			const UWidgetComponent* WidgetComponent = Cast<UWidgetComponent>(Component);
+			UUserWidget* Widget = WidgetComponent ? WidgetComponent->GetUserWidgetObject() : nullptr;
+			if (Widget && Widget->GetOuter() != Actor)
+			{
+				TArray<UObject*> WidgetObjects;
+				GetObjectsWithOuter(Widget, WidgetObjects, true);
+				Objects.Add(Widget);
+				Objects.Append(WidgetObjects);
+			}
+		}
+
+		SIZE_T Bytes = 0;
+		for (UObject* Object : Objects)
+		{
+			Bytes += GetObjectBytes(Object);
+		}
+		return Bytes;
+	}
+
+	// Assets the actor uses that every instance of its class shares
+	void GatherSharedAssets(AActor* Actor, TArray<UObject*>& OutAssets)
+	{
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (const USkinnedMeshComponent* SkinnedMesh = Cast<USkinnedMeshComponent>(Component))
+			{
+				OutAssets.Add(SkinnedMesh->GetSkinnedAsset());
+			}
+			else if (const UStaticMeshComponent* StaticMesh = Cast<UStaticMeshComponent>(Component))
+			{
+				OutAssets.Add(StaticMesh->GetStaticMesh());
+			}
+			else if (const UNiagaraComponent* Niagara = Cast<UNiagaraComponent>(Component))
+			{
+				OutAssets.Add(Niagara->GetAsset());
+			}
+			else if (const UGeometryCollectionComponent* GeometryCollection = Cast<UGeometryCollectionComponent>(Component))
+			{
+				// Only read for its size, GetResourceSizeEx just isn't const
+				OutAssets.Add(const_cast<UGeometryCollection*>(GeometryCollection->GetRestCollection()));
+			}
+		}
+
+		if (const IPreloadInterface* Preloadable = Cast<IPreloadInterface>(Actor))
+		{
+			Preloadable->GetPrewarmAssets(OutAssets);
+		}
+	}
+
+	bool IsReportedClass(const AActor* Actor)
+	{
+		return Actor->IsA<ABaseCharacter>() || Actor->IsA<AItem>() || Actor->IsA<ABreakableActor>();
+	}
+}
+
+double UMemoryReportSubsystem::FClassFootprint::GetPerInstanceKB() const
+{
+	if (Count == 0) return 0.0;
+	return (InstanceBytes + AttachedBytes + SharedBytes) / (Count * BytesPerKB);
+}
+
+void UMemoryReportSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (FParse::Value(FCommandLine::Get(), TEXT("MemoryReportCsv="), ExitCsvPath))
+	{
+		// By Deinitialize the actors have ended play and let go of their widgets and controllers
+		TearDownHandle = FWorldDelegates::OnWorldBeginTearDown.AddUObject(this, &UMemoryReportSubsystem::OnWorldBeginTearDown);
+	}
+}
+
+void UMemoryReportSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldBeginTearDown.Remove(TearDownHandle);
+	Super::Deinitialize();
+}
+
+bool UMemoryReportSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UMemoryReportSubsystem::OnWorldBeginTearDown(UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		WriteCsv(ExitCsvPath);
+	}
+}
+
+void UMemoryReportSubsystem::GatherFootprints(TArray<FClassFootprint>& OutFootprints) const
+{
+	TMap<UClass*, int32> ClassIndices;
+	TArray<UObject*> Assets;
+	TArray<AActor*> AttachedActors;
+
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		AActor* Actor = *It;
+		if (!IsReportedClass(Actor)) continue;
+
+		int32& Index = ClassIndices.FindOrAdd(Actor->GetClass(), INDEX_NONE);
+		if (Index == INDEX_NONE)
+		{
+			Index = OutFootprints.AddDefaulted();
+			OutFootprints[Index].ClassName = Actor->GetClass()->GetName();
+		}
+		FClassFootprint& Footprint = OutFootprints[Index];
+		++Footprint.Count;
+		Footprint.InstanceBytes += GetActorBytes(Actor);
+
+		// What an enemy drags in with it: the weapon in its hand and its AI controller
+		Assets.Reset();
+		GatherSharedAssets(Actor, Assets);
+		AttachedActors.Reset();
+		Actor->GetAttachedActors(AttachedActors, true, true);
+		if (const APawn* Pawn = Cast<APawn>(Actor))
+		{
+			if (Pawn->GetController() && !Pawn->IsPlayerControlled())
+			{
+				AttachedActors.Add(Pawn->GetController());
+			}
+		}
+		for (AActor* Attached : AttachedActors)
+		{
+			Footprint.AttachedBytes += GetActorBytes(Attached);
+			GatherSharedAssets(Attached, Assets);
+		}
+
+		for (UObject* Asset : Assets)
+		{
+			if (Asset == nullptr) continue;
+
+			bool bAlreadyCounted = false;
+			Footprint.SharedAssets.Add(FObjectKey(Asset), &bAlreadyCounted);
+			if (!bAlreadyCounted)
+			{
+				Footprint.SharedBytes += Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+			}
+		}
+	}
+
+	OutFootprints.Sort([](const FClassFootprint& A, const FClassFootprint& B) { return A.GetPerInstanceKB() > B.GetPerInstanceKB(); });
+}
+
+void UMemoryReportSubsystem::LogReport() const
+{
+	TArray<FClassFootprint> Footprints;
+	GatherFootprints(Footprints);
+
+	UE_LOG(LogTemp, Display, TEXT("Memory: %d gameplay classes on %s, estimated KB per instance"), Footprints.Num(), *GetWorld()->GetMapName());
+	for (const FClassFootprint& Footprint : Footprints)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Memory: %-32s x%-4d %8.1f KB each (own %.1f, attached %.1f, shared assets %.1f KB total)"),
+			*Footprint.ClassName, Footprint.Count, Footprint.GetPerInstanceKB(),
+			Footprint.InstanceBytes / (Footprint.Count * BytesPerKB), Footprint.AttachedBytes / (Footprint.Count * BytesPerKB), Footprint.SharedBytes / BytesPerKB);
+	}
+}
+
+bool UMemoryReportSubsystem::WriteCsv(const FString& Path) const
+{
+	const FString CsvPath = Path.IsEmpty() ? FPaths::Combine(FPaths::ProfilingDir(), TEXT("MemoryReport.csv")) : Path;
+
+	TArray<FClassFootprint> Footprints;
+	GatherFootprints(Footprints);
+
+	// Appended so one file tracks the same map across builds
+	FString Csv;
+	if (!IFileManager::Get().FileExists(*CsvPath))
+	{
+		Csv = TEXT("build,map,class,count,own_kb,attached_kb,shared_kb,per_instance_kb\n");
+	}
+	const FString MapName = GetWorld()->GetMapName();
+	for (const FClassFootprint& Footprint : Footprints)
+	{
+		Csv += FString::Printf(TEXT("%s,%s,%s,%d,%.1f,%.1f,%.1f,%.1f\n"), FApp::GetBuildVersion(), *MapName, *Footprint.ClassName, Footprint.Count,
+			Footprint.InstanceBytes / (Footprint.Count * BytesPerKB), Footprint.AttachedBytes / (Footprint.Count * BytesPerKB), Footprint.SharedBytes / BytesPerKB, Footprint.GetPerInstanceKB());
+	}
+
+	if (!FFileHelper::SaveStringToFile(Csv, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Memory: couldn't write %s"), *CsvPath);
+		return false;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Memory: wrote %d classes to %s"), Footprints.Num(), *CsvPath);
+	return true;
+}
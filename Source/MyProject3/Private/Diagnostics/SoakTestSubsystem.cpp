@@ -0,0 +1,355 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Diagnostics/SoakTestSubsystem.h"
+#include "AIController.h"
+#include "Breakable/BreakableActor.h"
+#include "Characters/SlashCharacter.h"
+#include "Enemy/Enemy.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/DamageType.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Interfaces/HitInterface.h"
+#include "Items/Treasure.h"
+#include "Items/Weapons/Weapon.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Spawning/SpawnDirectorSubsystem.h"
+
+static TAutoConsoleVariable<float> CVarSoakSampleInterval(
+	TEXT("slash.Soak.SampleInterval"),
+	60.f,
+	TEXT("Seconds between soak samples, each one collects garbage first."));
+
+static TAutoConsoleVariable<float> CVarSoakWarmup(
+	TEXT("slash.Soak.Warmup"),
+	300.f,
+	TEXT("Seconds at the start of a soak left out of the trend, while pools and caches fill."));
+
+static TAutoConsoleVariable<float> CVarSoakTolerance(
+	TEXT("slash.Soak.Tolerance"),
+	0.05f,
+	TEXT("How much a sampled value may grow over the soak, as a fraction of its average, before it fails."));
+
+static TAutoConsoleVariable<float> CVarSoakStallTime(
+	TEXT("slash.Soak.StallTime"),
+	20.f,
+	TEXT("Seconds the soak autopilot spends on one target before it forces the kill, break or pickup."));
+
+namespace
+{
+	constexpr double ReachDistance = 150.0;
+	constexpr float ActionInterval = 0.5f;
+	// Spawns go through the director, give a wave a moment to land before calling the map clear
+	constexpr double MinWaveSeconds = 2.0;
+
+	bool IsLiveEnemy(const AActor* Actor)
+	{
+		const AEnemy* Enemy = Cast<AEnemy>(Actor);
+		return Enemy && Enemy->GetEnemyState() != EEnemyState::EES_Dead;
+	}
+}
+
+bool USoakTestSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return Super::ShouldCreateSubsystem(Outer) && FParse::Param(FCommandLine::Get(), TEXT("SlashSoak"));
+}
+
+void USoakTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	float Hours = 2.f;
+	FParse::Value(FCommandLine::Get(), TEXT("SlashSoakHours="), Hours);
+	Duration = Hours * 3600.0;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("SlashSoakCsv="), CsvPath))
+	{
+		CsvPath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("Soak.csv"));
+	}
+}
+
+void USoakTestSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// What the map starts with is what every wave brings back
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		if (It->IsA<AEnemy>() || It->IsA<ABreakableActor>())
+		{
+			SpawnPoints.Add({ TSoftClassPtr<AActor>(It->GetClass()), It->GetActorTransform() });
+		}
+	}
+
+	StartTime = LastSampleTime = LastTickTime = LastWaveTime = FPlatformTime::Seconds();
+	FFileHelper::SaveStringToFile(TEXT("seconds,wave,uobjects,actors,used_mb,frame_ms\n"), *CsvPath);
+	UE_LOG(LogTemp, Display, TEXT("Soak: %.1f hours on %s, %d spawn points, samples to %s"), Duration / 3600.0, *InWorld.GetMapName(), SpawnPoints.Num(), *CsvPath);
+}
+
+bool USoakTestSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USoakTestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USoakTestSubsystem, STATGROUP_Tickables);
+}
+
+void USoakTestSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (bFinished || StartTime == 0.0) return;
+
+	const double Now = FPlatformTime::Seconds();
+	FrameSecondsSinceSample += Now - LastTickTime;
+	++FramesSinceSample;
+	LastTickTime = Now;
+
+	if (bSampleAfterGC)
+	{
+		TakeSample(Now);
+	}
+	else if (Now - LastSampleTime >= CVarSoakSampleInterval.GetValueOnGameThread())
+	{
+		// Sampled next frame, after the collection at the end of this one
+		GEngine->ForceGarbageCollection(true);
+		bSampleAfterGC = true;
+	}
+
+	if (Now - StartTime >= Duration)
+	{
+		Finish();
+		return;
+	}
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (ASlashCharacter* Player = PlayerController ? Cast<ASlashCharacter>(PlayerController->GetPawn()) : nullptr)
+	{
+		DriveAutopilot(Player, DeltaTime);
+	}
+}
+
+void USoakTestSubsystem::DriveAutopilot(ASlashCharacter* Player, float DeltaTime)
+{
+	// Hours of fighting shouldn't end with the player dead on the floor
+	Player->SetCanBeDamaged(false);
+	TimeSinceAction += DeltaTime;
+
+	AActor* NewTarget = ChooseTarget(Player);
+	if (NewTarget != Target.Get())
+	{
+		Target = NewTarget;
+		TimeOnTarget = 0.f;
+	}
+
+	if (NewTarget == nullptr)
+	{
+		USpawnDirectorSubsystem* SpawnDirector = GetWorld()->GetSubsystem<USpawnDirectorSubsystem>();
+		const bool bSpawnsLanded = SpawnDirector == nullptr || SpawnDirector->GetBacklog() == 0;
+		if (bSpawnsLanded && FPlatformTime::Seconds() - LastWaveTime >= MinWaveSeconds)
+		{
+			SpawnWave();
+		}
+		return;
+	}
+
+	TimeOnTarget += DeltaTime;
+	if (TimeOnTarget >= CVarSoakStallTime.GetValueOnGameThread())
+	{
+		// Stuck on geometry or chasing an enemy that keeps backing off, the loop matters more than the fight
+		ForceResolve(NewTarget, Player);
+		Target = nullptr;
+		return;
+	}
+
+	const FVector ToTarget = NewTarget->GetActorLocation() - Player->GetActorLocation();
+	if (AController* Controller = Player->GetController())
+	{
+		Controller->SetControlRotation(FRotator(0.f, ToTarget.Rotation().Yaw, 0.f));
+	}
+
+	// Items are picked up by walking into them, enemies and pots are hit from arm's length
+	const bool bInReach = ToTarget.Size2D() <= ReachDistance;
+	if (!bInReach || NewTarget->IsA<AItem>())
+	{
+		Player->ReplayInput(ESessionInput::Move, FVector2D(0.f, 1.f));
+	}
+	if (TimeSinceAction < ActionInterval) return;
+
+	const bool bArmed = Player->GetCharaterState() != ECharacterState::ECS_Unequipped;
+	if (NewTarget->IsA<AWeapon>() ? bInReach : !bArmed)
+	{
+		// Picks up the weapon, or with none left on the map arms the one on our back
+		TimeSinceAction = 0.f;
+		Player->ReplayInput(ESessionInput::EKey, FVector2D::ZeroVector);
+	}
+	else if (bInReach && !NewTarget->IsA<AItem>())
+	{
+		TimeSinceAction = 0.f;
+		Player->ReplayInput(ESessionInput::Attack, FVector2D::ZeroVector);
+	}
+}
+
+AActor* USoakTestSubsystem::ChooseTarget(const ASlashCharacter* Player) const
+{
+	const bool bArmed = Player->GetCharaterState() != ECharacterState::ECS_Unequipped;
+	const FVector PlayerLocation = Player->GetActorLocation();
+
+	// Armed it goes for enemies, then pots, then loot. Unarmed it picks up a weapon first
+	auto GetPriority = [bArmed](const AActor* Actor) -> int32
+	{
+		if (const AItem* Item = Cast<AItem>(Actor))
+		{
+			if (Item->GetItemState() != EItemState::EIS_Hovering) return INDEX_NONE;
+			if (Actor->IsA<AWeapon>()) return bArmed ? INDEX_NONE : 0;
+			return Actor->IsA<ATreasure>() ? 3 : INDEX_NONE;
+		}
+		if (IsLiveEnemy(Actor)) return 1;
+		if (const ABreakableActor* Breakable = Cast<ABreakableActor>(Actor))
+		{
+			return Breakable->IsBroken() ? INDEX_NONE : 2;
+		}
+		return INDEX_NONE;
+	};
+
+	AActor* Best = nullptr;
+	int32 BestPriority = MAX_int32;
+	double BestDistanceSquared = DBL_MAX;
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It)
+	{
+		const int32 Priority = GetPriority(*It);
+		if (Priority == INDEX_NONE || Priority > BestPriority) continue;
+
+		const double DistanceSquared = FVector::DistSquared(PlayerLocation, It->GetActorLocation());
+		if (Priority < BestPriority || DistanceSquared < BestDistanceSquared)
+		{
+			Best = *It;
+			BestPriority = Priority;
+			BestDistanceSquared = DistanceSquared;
+		}
+	}
+	return Best;
+}
+
+void USoakTestSubsystem::ForceResolve(AActor* InTarget, ASlashCharacter* Player)
+{
+	if (IsLiveEnemy(InTarget))
+	{
+		UGameplayStatics::ApplyDamage(InTarget, 1000000.f, Player->GetController(), Player, UDamageType::StaticClass());
+		IHitInterface::Execute_GetHit(InTarget, InTarget->GetActorLocation(), Player);
+	}
+	else if (InTarget->IsA<ABreakableActor>())
+	{
+		IHitInterface::Execute_GetHit(InTarget, InTarget->GetActorLocation(), Player);
+	}
+	else if (InTarget->IsA<AItem>())
+	{
+		// Walking over it is what picks it up
+		InTarget->SetActorLocation(Player->GetActorLocation());
+		if (InTarget->IsA<AWeapon>())
+		{
+			Player->ReplayInput(ESessionInput::EKey, FVector2D::ZeroVector);
+		}
+	}
+}
+
+void USoakTestSubsystem::SpawnWave()
+{
+	USpawnDirectorSubsystem* SpawnDirector = GetWorld()->GetSubsystem<USpawnDirectorSubsystem>();
+	if (SpawnDirector == nullptr) return;
+
+	++Wave;
+	LastWaveTime = FPlatformTime::Seconds();
+	for (const FSpawnPoint& SpawnPoint : SpawnPoints)
+	{
+		FSpawnRequest Request;
+		Request.Class = SpawnPoint.Class;
+		Request.Transform = SpawnPoint.Transform;
+		Request.CollisionHandling = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		Request.OnSpawned = [](AActor* Spawned)
+		{
+			// Only placed enemies are possessed automatically
+			APawn* Pawn = Cast<APawn>(Spawned);
+			if (Pawn && Pawn->GetController() == nullptr)
+			{
+				Pawn->SpawnDefaultController();
+			}
+		};
+		SpawnDirector->RequestSpawn(MoveTemp(Request));
+	}
+}
+
+void USoakTestSubsystem::TakeSample(double Now)
+{
+	bSampleAfterGC = false;
+	LastSampleTime = Now;
+
+	FSample& Sample = Samples.AddDefaulted_GetRef();
+	Sample.Seconds = Now - StartTime;
+	Sample.Wave = Wave;
+	Sample.UObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+	Sample.Actors = GetWorld()->GetActorCount();
+	Sample.UsedMB = FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+	Sample.FrameMs = FramesSinceSample > 0 ? FrameSecondsSinceSample * 1000.0 / FramesSinceSample : 0.0;
+	FrameSecondsSinceSample = 0.0;
+	FramesSinceSample = 0;
+
+	// Written as it goes, a run that dies halfway still leaves its series behind
+	const FString Row = FString::Printf(TEXT("%.0f,%d,%d,%d,%.1f,%.2f\n"), Sample.Seconds, Sample.Wave, Sample.UObjects, Sample.Actors, Sample.UsedMB, Sample.FrameMs);
+	FFileHelper::SaveStringToFile(Row, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
+
+bool USoakTestSubsystem::CheckTrend(const TCHAR* Name, TFunctionRef<double(const FSample&)> GetValue) const
+{
+	// Least squares line through the samples after the warmup, its rise over the run against the average
+	const double Warmup = CVarSoakWarmup.GetValueOnGameThread();
+	double SumT = 0.0, SumV = 0.0, SumTT = 0.0, SumTV = 0.0;
+	double FirstT = DBL_MAX, LastT = 0.0;
+	int32 Count = 0;
+	for (const FSample& Sample : Samples)
+	{
+		if (Sample.Seconds < Warmup) continue;
+		const double Value = GetValue(Sample);
+		SumT += Sample.Seconds;
+		SumV += Value;
+		SumTT += Sample.Seconds * Sample.Seconds;
+		SumTV += Sample.Seconds * Value;
+		FirstT = FMath::Min(FirstT, Sample.Seconds);
+		LastT = FMath::Max(LastT, Sample.Seconds);
+		++Count;
+	}
+
+	if (Count < 3)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Soak: %s has %d samples after the warmup, not enough for a trend"), Name, Count);
+		return true;
+	}
+
+	const double Denominator = Count * SumTT - SumT * SumT;
+	const double Slope = Denominator > 0.0 ? (Count * SumTV - SumT * SumV) / Denominator : 0.0;
+	const double Average = SumV / Count;
+	const double Growth = Average > 0.0 ? Slope * (LastT - FirstT) / Average : 0.0;
+	const bool bPassed = Growth <= CVarSoakTolerance.GetValueOnGameThread();
+
+	UE_LOG(LogTemp, Display, TEXT("Soak: %-8s average %.1f, grew %+.1f%% over the run %s"), Name, Average, Growth * 100.0, bPassed ? TEXT("ok") : TEXT("FAILED"));
+	return bPassed;
+}
+
+void USoakTestSubsystem::Finish()
+{
+	bFinished = true;
+
+	bool bPassed = CheckTrend(TEXT("uobjects"), [](const FSample& Sample) { return static_cast<double>(Sample.UObjects); });
+	bPassed &= CheckTrend(TEXT("actors"), [](const FSample& Sample) { return static_cast<double>(Sample.Actors); });
+	bPassed &= CheckTrend(TEXT("memory"), [](const FSample& Sample) { return Sample.UsedMB; });
+	bPassed &= CheckTrend(TEXT("frame"), [](const FSample& Sample) { return Sample.FrameMs; });
+
+	UE_LOG(LogTemp, Display, TEXT("Soak: %s after %d waves and %d samples, series in %s"), bPassed ? TEXT("passed") : TEXT("failed"), Wave, Samples.Num(), *CsvPath);
+	FPlatformMisc::RequestExitWithStatus(false, bPassed ? 0 : 1);
+}
@@ -0,0 +1,17 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/AnimNotify_EnemyFootstep.h"
+#include "Enemy/EnemyAudioComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+
+void UAnimNotify_EnemyFootstep::Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference)
+{
+	Super::Notify(MeshComp, Animation, EventReference);
+
+	const AActor* Owner = MeshComp ? MeshComp->GetOwner() : nullptr;
+	if (UEnemyAudioComponent* Audio = Owner ? Owner->FindComponentByClass<UEnemyAudioComponent>() : nullptr)
+	{
+		Audio->PlayFootstep();
+	}
+}
@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/AttackTokenSubsystem.h"
+#include "Enemy/Enemy.h"
+#include "Engine/World.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Attack Tokens Held"), STAT_SlashAttackTokensHeld, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Attack Token Waiting"), STAT_SlashAttackTokenWaiting, STATGROUP_Slash);
+
+static TAutoConsoleVariable<int32> CVarAttackTokensPerTarget(
+	TEXT("slash.AttackTokens.PerTarget"),
+	2,
+	TEXT("Enemies allowed to attack the same target at once."));
+
+static TAutoConsoleVariable<int32> CVarAttackTokensMax(
+	TEXT("slash.AttackTokens.Max"),
+	6,
+	TEXT("Enemies allowed to attack at once across the world, caps the attack montages and weapon traces running together."));
+
+static TAutoConsoleVariable<float> CVarAttackTokenLease(
+	TEXT("slash.AttackTokens.Lease"),
+	6.f,
+	TEXT("Seconds a token is kept by an enemy that isn't attacking with it before someone asking can take it."));
+
+bool UAttackTokenSubsystem::RequestToken(AEnemy* Attacker, AActor* Target)
+{
+	if (Attacker == nullptr || Target == nullptr) return false;
+
+	RemoveStale();
+	if (FTargetTokens* Tokens = Targets.Find(Target))
+	{
+		for (FHolder& Holder : Tokens->Holders)
+		{
+			if (Holder.Enemy == Attacker)
+			{
+				Holder.RenewTime = GetWorld()->GetTimeSeconds();
+				return true;
+			}
+		}
+	}
+
+	// A token or place in line for another target goes first
+	ReleaseToken(Attacker);
+
+	FTargetTokens& Tokens = Targets.FindOrAdd(Target);
+	Tokens.Target = Target;
+	if (CanGrant(Tokens) || ReclaimExpired(Tokens))
+	{
+		Grant(Tokens, Attacker);
+		return true;
+	}
+
+	Tokens.Waiting.AddUnique(Attacker);
+	return false;
+}
+
+void UAttackTokenSubsystem::ReleaseToken(AEnemy* Attacker)
+{
+	bool bFreed = false;
+	for (auto It = Targets.CreateIterator(); It; ++It)
+	{
+		FTargetTokens& Tokens = It.Value();
+		const int32 NumRemoved = Tokens.Holders.RemoveAll([Attacker](const FHolder& Holder) { return Holder.Enemy == Attacker; });
+		NumTokensHeld -= NumRemoved;
+		bFreed |= NumRemoved > 0;
+		Tokens.Waiting.Remove(Attacker);
+
+		if (Tokens.Holders.Num() == 0 && Tokens.Waiting.Num() == 0)
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (bFreed)
+	{
+		GrantToWaiting();
+	}
+}
+
+bool UAttackTokenSubsystem::HasToken(const AEnemy* Attacker) const
+{
+	for (const TPair<TObjectKey<AActor>, FTargetTokens>& Pair : Targets)
+	{
+		for (const FHolder& Holder : Pair.Value.Holders)
+		{
+			if (Holder.Enemy == Attacker) return true;
+		}
+	}
+	return false;
+}
+
+bool UAttackTokenSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UAttackTokenSubsystem::Grant(FTargetTokens& Tokens, AEnemy* Attacker)
+{
+	Tokens.Holders.Add({ Attacker, GetWorld()->GetTimeSeconds() });
+	Tokens.Waiting.Remove(Attacker);
+	++NumTokensHeld;
+	SET_DWORD_STAT(STAT_SlashAttackTokensHeld, NumTokensHeld);
+}
+
+void UAttackTokenSubsystem::GrantToWaiting()
+{
+	RemoveStale();
+
+	// Enemies are told after the tokens are handed out, they ask for tokens again from the callback
+	TArray<TWeakObjectPtr<AEnemy>, TInlineAllocator<4>> Granted;
+	for (;;)
+	{
+		FTargetTokens* BestTokens = nullptr;
+		AEnemy* BestEnemy = nullptr;
+		float BestPriority = TNumericLimits<float>::Max();
+		for (TPair<TObjectKey<AActor>, FTargetTokens>& Pair : Targets)
+		{
+			FTargetTokens& Tokens = Pair.Value;
+			if (!CanGrant(Tokens)) continue;
+
+			for (const TWeakObjectPtr<AEnemy>& Waiting : Tokens.Waiting)
+			{
+				const float Priority = GetPriority(Waiting.Get(), Tokens.Target.Get());
+				if (Priority < BestPriority)
+				{
+					BestPriority = Priority;
+					BestTokens = &Tokens;
+					BestEnemy = Waiting.Get();
+				}
+			}
+		}
+		if (BestEnemy == nullptr) break;
+
+		Grant(*BestTokens, BestEnemy);
+		Granted.Add(BestEnemy);
+	}
+
+	for (const TWeakObjectPtr<AEnemy>& Enemy : Granted)
+	{
+		if (Enemy.IsValid() && HasToken(Enemy.Get()))
+		{
+			Enemy->OnAttackTokenGranted();
+		}
+	}
+}
+
+bool UAttackTokenSubsystem::ReclaimExpired(FTargetTokens& Tokens)
+{
+	const double ExpireTime = GetWorld()->GetTimeSeconds() - CVarAttackTokenLease.GetValueOnGameThread();
+	for (int32 Index = 0; Index < Tokens.Holders.Num(); ++Index)
+	{
+		const AEnemy* Holder = Tokens.Holders[Index].Enemy.Get();
+		const EEnemyState State = Holder->GetEnemyState();
+		if (Tokens.Holders[Index].RenewTime < ExpireTime && State != EEnemyState::EES_Attacking && State != EEnemyState::EES_Engaged)
+		{
+			Tokens.Holders.RemoveAtSwap(Index);
+			--NumTokensHeld;
+			return true;
+		}
+	}
+	return false;
+}
+
+void UAttackTokenSubsystem::RemoveStale()
+{
+	NumTokensHeld = 0;
+	int32 NumWaiting = 0;
+	for (auto It = Targets.CreateIterator(); It; ++It)
+	{
+		FTargetTokens& Tokens = It.Value();
+		if (!Tokens.Target.IsValid())
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		Tokens.Holders.RemoveAll([](const FHolder& Holder) { return !Holder.Enemy.IsValid(); });
+		Tokens.Waiting.RemoveAll([](const TWeakObjectPtr<AEnemy>& Enemy) { return !Enemy.IsValid(); });
+		if (Tokens.Holders.Num() == 0 && Tokens.Waiting.Num() == 0)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		NumTokensHeld += Tokens.Holders.Num();
+		NumWaiting += Tokens.Waiting.Num();
+	}
+	SET_DWORD_STAT(STAT_SlashAttackTokensHeld, NumTokensHeld);
+	SET_DWORD_STAT(STAT_SlashAttackTokenWaiting, NumWaiting);
+}
+
+bool UAttackTokenSubsystem::CanGrant(const FTargetTokens& Tokens) const
+{
+	return Tokens.Holders.Num() < CVarAttackTokensPerTarget.GetValueOnGameThread() && NumTokensHeld < CVarAttackTokensMax.GetValueOnGameThread();
+}
+
+float UAttackTokenSubsystem::GetPriority(const AEnemy* Attacker, const AActor* Target)
+{
+	// Lower goes first. Distance counts for up to double when the enemy is behind the target
+	const FVector ToAttacker = Attacker->GetActorLocation() - Target->GetActorLocation();
+	const float Distance = static_cast<float>(ToAttacker.Size());
+	const float Facing = static_cast<float>(FVector::DotProduct(Target->GetActorForwardVector(), ToAttacker.GetSafeNormal()));
+	return Distance * (1.5f - 0.5f * Facing);
+}
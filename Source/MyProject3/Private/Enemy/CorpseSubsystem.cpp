@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/CorpseSubsystem.h"
+#include "Enemy/Enemy.h"
+#include "Animation/AnimInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Corpses"), STAT_SlashCorpses, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Frozen Corpses"), STAT_SlashFrozenCorpses, STATGROUP_Slash);
+
+static TAutoConsoleVariable<int32> CVarMaxCorpses(
+	TEXT("slash.Corpse.Max"),
+	8,
+	TEXT("Corpses kept at once, the oldest is removed past this."));
+
+static TAutoConsoleVariable<float> CVarCorpseSettleTime(
+	TEXT("slash.Corpse.SettleTime"),
+	1.f,
+	TEXT("Seconds after death before a corpse can freeze, it freezes once its montage is done."));
+
+static TAutoConsoleVariable<float> CVarCorpseMaxSettleTime(
+	TEXT("slash.Corpse.MaxSettleTime"),
+	5.f,
+	TEXT("Seconds after death a corpse freezes even if a montage is still playing."));
+
+static TAutoConsoleVariable<bool> CVarCorpsePoseSnapshot(
+	TEXT("slash.Corpse.PoseSnapshot"),
+	true,
+	TEXT("Swap frozen corpses to a poseable mesh holding the final pose instead of a paused skeletal mesh."));
+
+void UCorpseSubsystem::Tick(float DeltaTime)
+{
+	SLASH_HITCH_SCOPE(Corpses);
+	Super::Tick(DeltaTime);
+
+	Corpses.RemoveAll([](const FCorpse& Corpse) { return !Corpse.Enemy.IsValid(); });
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const float SettleTime = CVarCorpseSettleTime.GetValueOnGameThread();
+	const float MaxSettleTime = CVarCorpseMaxSettleTime.GetValueOnGameThread();
+
+	for (FCorpse& Corpse : Corpses)
+	{
+		if (Corpse.bFrozen) continue;
+
+		const double Age = Now - Corpse.DeathTime;
+		if (Age < SettleTime) continue;
+
+		const UAnimInstance* AnimInstance = Corpse.Enemy->GetMesh()->GetAnimInstance();
+		if (Age >= MaxSettleTime || AnimInstance == nullptr || !AnimInstance->IsAnyMontagePlaying())
+		{
+			FreezeCorpse(Corpse);
+		}
+	}
+	UpdateStats();
+}
+
+TStatId UCorpseSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCorpseSubsystem, STATGROUP_Tickables);
+}
+
+bool UCorpseSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCorpseSubsystem::AddCorpse(AEnemy* Enemy)
+{
+	if (Enemy == nullptr || Corpses.ContainsByPredicate([Enemy](const FCorpse& Corpse) { return Corpse.Enemy == Enemy; })) return;
+
+	FCorpse& Corpse = Corpses.AddDefaulted_GetRef();
+	Corpse.Enemy = Enemy;
+	Corpse.DeathTime = GetWorld()->GetTimeSeconds();
+
+	const int32 MaxCorpses = FMath::Max(0, CVarMaxCorpses.GetValueOnGameThread());
+	while (Corpses.Num() > MaxCorpses)
+	{
+		RecycleOldest();
+	}
+	UpdateStats();
+}
+
+void UCorpseSubsystem::FreezeCorpse(FCorpse& Corpse)
+{
+	// Dedicated servers never draw the snapshot, pausing the body is all they need
+	const bool bPoseSnapshot = CVarCorpsePoseSnapshot.GetValueOnGameThread() && FApp::CanEverRender();
+	Corpse.Enemy->FreezeCorpse(bPoseSnapshot);
+	Corpse.bFrozen = true;
+}
+
+void UCorpseSubsystem::RecycleOldest()
+{
+	if (Corpses.Num() == 0) return;
+
+	FCorpse Oldest = Corpses[0];
+	Corpses.RemoveAt(0);
+
+	AEnemy* Enemy = Oldest.Enemy.Get();
+	if (Enemy == nullptr) return;
+
+	// The server's destroy replicates, clients only hide the ones they hold past their own budget
+	if (Enemy->HasAuthority())
+	{
+		Enemy->Destroy();
+	}
+	else
+	{
+		if (!Oldest.bFrozen)
+		{
+			FreezeCorpse(Oldest);
+		}
+		Enemy->SetActorHiddenInGame(true);
+	}
+}
+
+void UCorpseSubsystem::UpdateStats()
+{
+	int32 NumFrozen = 0;
+	for (const FCorpse& Corpse : Corpses)
+	{
+		if (Corpse.bFrozen) ++NumFrozen;
+	}
+	SET_DWORD_STAT(STAT_SlashCorpses, Corpses.Num());
+	SET_DWORD_STAT(STAT_SlashFrozenCorpses, NumFrozen);
+}
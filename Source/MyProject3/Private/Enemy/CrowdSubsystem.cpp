@@ -0,0 +1,411 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/CrowdSubsystem.h"
+#include "Enemy/Enemy.h"
+#include "Enemy/EnemyAIController.h"
+#include "Enemy/EnemyMovementComponent.h"
+#include "Enemy/PathRequestSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Navigation/CrowdFollowingComponent.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_CYCLE_STAT(TEXT("Crowd Tiers"), STAT_SlashCrowdTiers, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Agents"), STAT_SlashCrowdAgents, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Crowd Agents Simulated"), STAT_SlashCrowdAgentsSimulated, STATGROUP_Slash);
+
+static TAutoConsoleVariable<bool> CVarCrowdEnabled(
+	TEXT("slash.Crowd.Enabled"),
+	true,
+	TEXT("Enemies follow paths as crowd agents. Applies to controllers possessing after the change."));
+
+static TAutoConsoleVariable<int32> CVarCrowdMaxSimulated(
+	TEXT("slash.Crowd.MaxSimulated"),
+	40,
+	TEXT("Budget for the per frame crowd update. Agents nearest the players up to this many are simulated with tiered avoidance, the rest get the cheapest and become obstacles, moving ones have their move sent again to switch."));
+
+static TAutoConsoleVariable<float> CVarCrowdHighDistance(
+	TEXT("slash.Crowd.HighDistance"),
+	800.f,
+	TEXT("Agents closer than this to a player get high quality avoidance."));
+
+static TAutoConsoleVariable<float> CVarCrowdGoodDistance(
+	TEXT("slash.Crowd.GoodDistance"),
+	1500.f,
+	TEXT("Agents closer than this to a player get good quality avoidance."));
+
+static TAutoConsoleVariable<float> CVarCrowdMediumDistance(
+	TEXT("slash.Crowd.MediumDistance"),
+	3000.f,
+	TEXT("Agents closer than this to a player get medium quality avoidance, further ones low."));
+
+static TAutoConsoleVariable<float> CVarCrowdTierInterval(
+	TEXT("slash.Crowd.TierInterval"),
+	0.25f,
+	TEXT("Seconds between re-ranking the crowd agents."));
+
+static FAutoConsoleCommandWithWorldAndArgs CrowdBenchCommand(
+	TEXT("slash.Crowd.Bench"),
+	TEXT("slash.Crowd.Bench [Enemies=120] [Seconds=10]. Sends that many enemies at the player with the crowd off, then on, and reports frame time and penetration resolves."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UCrowdSubsystem* Crowd = World ? World->GetSubsystem<UCrowdSubsystem>() : nullptr)
+		{
+			const int32 NumEnemies = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 120;
+			const float Seconds = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 10.f;
+			Crowd->StartBench(FMath::Max(1, NumEnemies), FMath::Max(1.f, Seconds));
+		}
+	}));
+
+namespace
+{
+	// Long enough for the spawn hitch and the first path requests to be out of the numbers
+	constexpr double BenchWarmUpSeconds = 2.0;
+	// The ring is inside the combat radius, further out the enemies lose interest on their first check
+	constexpr double BenchMinSpawnRadiusScale = 0.6;
+	constexpr double BenchMaxSpawnRadiusScale = 0.95;
+}
+
+void UCrowdSubsystem::Tick(float DeltaTime)
+{
+	TimeSinceTierUpdate += DeltaTime;
+	if (TimeSinceTierUpdate >= CVarCrowdTierInterval.GetValueOnGameThread())
+	{
+		TimeSinceTierUpdate = 0.f;
+		UpdateTiers();
+	}
+
+	if (Bench.Phase != EBenchPhase::Idle)
+	{
+		TickBench();
+	}
+}
+
+void UCrowdSubsystem::RegisterAgent(AEnemyAIController* Controller)
+{
+	UCrowdFollowingComponent* CrowdFollowing = Controller ? Controller->GetCrowdFollowing() : nullptr;
+	if (CrowdFollowing == nullptr) return;
+
+	// Only allowed while the agent isn't moving, which it isn't right after possession
+	CrowdFollowing->SetCrowdSimulationState(IsCrowdEnabled() ? ECrowdSimulationState::Enabled : ECrowdSimulationState::Disabled);
+	if (IsCrowdEnabled())
+	{
+		Agents.Add({ Controller, ETier::None });
+	}
+}
+
+void UCrowdSubsystem::UnregisterAgent(AEnemyAIController* Controller)
+{
+	Agents.RemoveAll([Controller](const FAgent& Agent) { return Agent.Controller == Controller; });
+}
+
+bool UCrowdSubsystem::IsCrowdEnabled() const
+{
+	return Bench.Phase != EBenchPhase::Idle ? Bench.bCrowdEnabled : CVarCrowdEnabled.GetValueOnGameThread();
+}
+
+bool UCrowdSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UCrowdSubsystem::UpdateTiers()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlashCrowdTiers);
+	Agents.RemoveAll([](const FAgent& Agent) { return !Agent.Controller.IsValid() || Agent.Controller->GetPawn() == nullptr; });
+	SET_DWORD_STAT(STAT_SlashCrowdAgents, Agents.Num());
+	if (Agents.Num() == 0) return;
+
+	TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APawn* PlayerPawn = It->Get() ? It->Get()->GetPawn() : nullptr)
+		{
+			PlayerLocations.Add(PlayerPawn->GetActorLocation());
+		}
+	}
+
+	TArray<TPair<double, int32>> Ranked;
+	Ranked.Reserve(Agents.Num());
+	for (int32 Index = 0; Index < Agents.Num(); ++Index)
+	{
+		const FVector Location = Agents[Index].Controller->GetPawn()->GetActorLocation();
+		double DistanceSquared = TNumericLimits<double>::Max();
+		for (const FVector& PlayerLocation : PlayerLocations)
+		{
+			DistanceSquared = FMath::Min(DistanceSquared, FVector::DistSquared(PlayerLocation, Location));
+		}
+		Ranked.Emplace(DistanceSquared, Index);
+	}
+	Ranked.Sort([](const TPair<double, int32>& A, const TPair<double, int32>& B) { return A.Key < B.Key; });
+
+	const int32 MaxSimulated = CVarCrowdMaxSimulated.GetValueOnGameThread();
+	const double HighDistanceSquared = FMath::Square(CVarCrowdHighDistance.GetValueOnGameThread());
+	const double GoodDistanceSquared = FMath::Square(CVarCrowdGoodDistance.GetValueOnGameThread());
+	const double MediumDistanceSquared = FMath::Square(CVarCrowdMediumDistance.GetValueOnGameThread());
+	for (int32 Rank = 0; Rank < Ranked.Num(); ++Rank)
+	{
+		const double DistanceSquared = Ranked[Rank].Key;
+		ETier Tier = ETier::Low;
+		if (Rank >= MaxSimulated) Tier = ETier::Budget;
+		else if (DistanceSquared <= HighDistanceSquared) Tier = ETier::High;
+		else if (DistanceSquared <= GoodDistanceSquared) Tier = ETier::Good;
+		else if (DistanceSquared <= MediumDistanceSquared) Tier = ETier::Medium;
+
+		FAgent& Agent = Agents[Ranked[Rank].Value];
+		if (Agent.Tier != Tier)
+		{
+			Agent.bSimulationPending = !ApplyTier(Agent.Controller.Get(), Tier);
+			Agent.Tier = Tier;
+		}
+		else if (Agent.bSimulationPending)
+		{
+			Agent.bSimulationPending = !ApplySimulationState(Agent.Controller.Get(), Tier);
+		}
+	}
+	SET_DWORD_STAT(STAT_SlashCrowdAgentsSimulated, FMath::Min(Agents.Num(), MaxSimulated));
+}
+
+bool UCrowdSubsystem::ApplyTier(AEnemyAIController* Controller, ETier Tier)
+{
+	UCrowdFollowingComponent* CrowdFollowing = Controller->GetCrowdFollowing();
+	if (CrowdFollowing == nullptr) return true;
+
+	const UCrowdFollowingComponent* Defaults = GetDefault<UCrowdFollowingComponent>();
+	const bool bBudget = Tier == ETier::Budget;
+	switch (Tier)
+	{
+	case ETier::High: CrowdFollowing->SetCrowdAvoidanceQuality(ECrowdAvoidanceQuality::High); break;
+	case ETier::Good: CrowdFollowing->SetCrowdAvoidanceQuality(ECrowdAvoidanceQuality::Good); break;
+	case ETier::Medium: CrowdFollowing->SetCrowdAvoidanceQuality(ECrowdAvoidanceQuality::Medium); break;
+	default: CrowdFollowing->SetCrowdAvoidanceQuality(ECrowdAvoidanceQuality::Low); break;
+	}
+
+	// Past the budget it only looks at its nearest neighbours and stops smoothing its path
+	CrowdFollowing->SetCrowdCollisionQueryRange(Defaults->GetCrowdCollisionQueryRange() * (bBudget ? 0.5f : 1.f));
+	CrowdFollowing->SetCrowdOptimizeVisibility(!bBudget);
+
+	return ApplySimulationState(Controller, Tier);
+}
+
+bool UCrowdSubsystem::ApplySimulationState(AEnemyAIController* Controller, ETier Tier)
+{
+	UCrowdFollowingComponent* CrowdFollowing = Controller->GetCrowdFollowing();
+	if (CrowdFollowing == nullptr) return true;
+
+	const bool bSimulate = Tier != ETier::Budget;
+	if (CrowdFollowing->IsCrowdSimulationEnabled() == bSimulate) return true;
+
+	// Switching simulation state isn't allowed mid move. A moving agent is stopped, switched and sent
+	// on to the same goal, or the chasers, which are most of the crowd, would never leave the budget
+	FAIMoveRequest MoveRequest;
+	EPathPriority Priority = EPathPriority::Patrol;
+	const bool bMoving = CrowdFollowing->GetStatus() != EPathFollowingStatus::Idle;
+	if (bMoving)
+	{
+		const FNavPathSharedPtr& Path = CrowdFollowing->GetPath();
+		const AEnemy* Enemy = Cast<AEnemy>(Controller->GetPawn());
+		if (!Path.IsValid() || Enemy == nullptr) return false;
+
+		if (const AActor* GoalActor = Path->GetGoalActor())
+		{
+			MoveRequest.SetGoalActor(GoalActor);
+		}
+		else
+		{
+			MoveRequest.SetGoalLocation(Path->GetEndLocation());
+		}
+		MoveRequest.SetAcceptanceRadius(CrowdFollowing->GetAcceptanceRadius());
+		if (Enemy->GetEnemyState() == EEnemyState::EES_Chasing) Priority = EPathPriority::Chase;
+		else if (Enemy->GetEnemyState() == EEnemyState::EES_Strafing) Priority = EPathPriority::Strafe;
+
+		// Keeps its velocity so it coasts on until the new path comes back
+		CrowdFollowing->AbortMove(*this, FPathFollowingResultFlags::NewRequest, FAIRequestID::CurrentRequest, EPathFollowingVelocityMode::Keep);
+		if (CrowdFollowing->GetStatus() != EPathFollowingStatus::Idle) return false;
+	}
+
+	CrowdFollowing->SetCrowdSimulationState(bSimulate ? ECrowdSimulationState::Enabled : ECrowdSimulationState::ObstacleOnly);
+
+	if (bMoving)
+	{
+		if (UPathRequestSubsystem* PathRequests = GetWorld()->GetSubsystem<UPathRequestSubsystem>())
+		{
+			PathRequests->RequestMove(Controller, MoveRequest, Priority);
+		}
+		else
+		{
+			Controller->MoveTo(MoveRequest);
+		}
+	}
+	return true;
+}
+
+void UCrowdSubsystem::StartBench(int32 NumEnemies, float Seconds)
+{
+	if (Bench.Phase != EBenchPhase::Idle)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CrowdBench: already running"));
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	APawn* Player = PlayerController ? PlayerController->GetPawn() : nullptr;
+	if (World->GetNetMode() == NM_Client || Player == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CrowdBench: needs a local player on the server or in standalone"));
+		return;
+	}
+
+	// Any enemy in the map stands in for the rest
+	TActorIterator<AEnemy> It(World);
+	if (!It)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CrowdBench: no enemy in the map to copy"));
+		return;
+	}
+
+	Bench = FBench();
+	Bench.Player = Player;
+	Bench.EnemyClass = It->GetClass();
+	Bench.NumEnemies = NumEnemies;
+	Bench.Seconds = Seconds;
+	// The player shouldn't die halfway through and tokens keep only a couple swinging anyway
+	Bench.bPlayerCouldBeDamaged = Player->CanBeDamaged();
+	Player->SetCanBeDamaged(false);
+
+	UE_LOG(LogTemp, Display, TEXT("CrowdBench: %d enemies for %.0f s, crowd off then on"), NumEnemies, Seconds);
+	StartBenchPass(false);
+}
+
+void UCrowdSubsystem::TickBench()
+{
+	APawn* Player = Bench.Player.Get();
+	if (Player == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("CrowdBench: player went away, stopping"));
+		ClearBenchEnemies();
+		Bench.Phase = EBenchPhase::Idle;
+		return;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Bench.Phase == EBenchPhase::WarmUp)
+	{
+		if (Now - Bench.PhaseStartTime >= BenchWarmUpSeconds)
+		{
+			Bench.Phase = EBenchPhase::Measure;
+			Bench.PhaseStartTime = Now;
+			Bench.StartPenetrationResolves = UEnemyMovementComponent::GetTotalPenetrationResolves();
+		}
+		return;
+	}
+
+	const double FrameTime = FApp::GetDeltaTime();
+	++Bench.NumFrames;
+	Bench.TotalFrameTime += FrameTime;
+	Bench.WorstFrameTime = FMath::Max(Bench.WorstFrameTime, FrameTime);
+
+	if (Now - Bench.PhaseStartTime >= Bench.Seconds)
+	{
+		FinishBenchPass();
+	}
+}
+
+void UCrowdSubsystem::StartBenchPass(bool bCrowdEnabled)
+{
+	UWorld* World = GetWorld();
+	APawn* Player = Bench.Player.Get();
+	Bench.bCrowdEnabled = bCrowdEnabled;
+	Bench.Phase = EBenchPhase::WarmUp;
+	Bench.PhaseStartTime = World->GetTimeSeconds();
+	Bench.NumFrames = 0;
+	Bench.TotalFrameTime = 0.0;
+	Bench.WorstFrameTime = 0.0;
+
+	// Same ring both passes so the runs are comparable
+	FRandomStream Random(Bench.NumEnemies);
+	const FVector Center = Player->GetActorLocation();
+	const double CombatRadius = Bench.EnemyClass->GetDefaultObject<AEnemy>()->GetCombatRadius();
+	for (int32 Index = 0; Index < Bench.NumEnemies; ++Index)
+	{
+		const double Angle = 2.0 * PI * Index / Bench.NumEnemies;
+		const double Radius = Random.FRandRange(CombatRadius * BenchMinSpawnRadiusScale, CombatRadius * BenchMaxSpawnRadiusScale);
+		const FVector Location = Center + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0) * Radius;
+		const FTransform Transform(FRotator(0.0, FMath::RadiansToDegrees(Angle) + 180.0, 0.0), Location);
+
+		AEnemy* Enemy = World->SpawnActorDeferred<AEnemy>(Bench.EnemyClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+		if (Enemy == nullptr) continue;
+
+		// Placed enemies are the only ones possessed on their own, this one needs its controller before begin play
+		Enemy->AutoPossessAI = EAutoPossessAI::Spawned;
+		Enemy->FinishSpawning(Transform);
+		Enemy->EngageTarget(Player);
+		Bench.Enemies.Add(Enemy);
+	}
+}
+
+void UCrowdSubsystem::FinishBenchPass()
+{
+	const uint64 Resolves = UEnemyMovementComponent::GetTotalPenetrationResolves() - Bench.StartPenetrationResolves;
+	const double Seconds = FMath::Max(GetWorld()->GetTimeSeconds() - Bench.PhaseStartTime, UE_SMALL_NUMBER);
+	const double AverageMs = Bench.NumFrames > 0 ? Bench.TotalFrameTime / Bench.NumFrames * 1000.0 : 0.0;
+	const double WorstMs = Bench.WorstFrameTime * 1000.0;
+	const TCHAR* Mode = Bench.bCrowdEnabled ? TEXT("on") : TEXT("off");
+
+	UE_LOG(LogTemp, Display, TEXT("CrowdBench: crowd %s, %d enemies, %.2f ms average frame, %.2f ms worst, %llu penetration resolves (%.0f/s), %d crowd agents"),
+		Mode, Bench.Enemies.Num(), AverageMs, WorstMs, Resolves, Resolves / Seconds, Agents.Num());
+
+	const FString CsvPath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("CrowdBench.csv"));
+	FString Csv;
+	if (!IFileManager::Get().FileExists(*CsvPath))
+	{
+		Csv = TEXT("build,map,crowd,enemies,seconds,avg_frame_ms,worst_frame_ms,penetration_resolves,resolves_per_second\n");
+	}
+	Csv += FString::Printf(TEXT("%s,%s,%s,%d,%.1f,%.3f,%.3f,%llu,%.1f\n"),
+		FApp::GetBuildVersion(), *GetWorld()->GetMapName(), Mode, Bench.Enemies.Num(), Seconds, AverageMs, WorstMs, Resolves, Resolves / Seconds);
+	if (!FFileHelper::SaveStringToFile(Csv, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append))
+	{
+		UE_LOG(LogTemp, Error, TEXT("CrowdBench: couldn't write %s"), *CsvPath);
+	}
+
+	ClearBenchEnemies();
+	if (!Bench.bCrowdEnabled)
+	{
+		StartBenchPass(true);
+		return;
+	}
+
+	if (APawn* Player = Bench.Player.Get())
+	{
+		Player->SetCanBeDamaged(Bench.bPlayerCouldBeDamaged);
+	}
+	Bench.Phase = EBenchPhase::Idle;
+}
+
+void UCrowdSubsystem::ClearBenchEnemies()
+{
+	for (const TWeakObjectPtr<AEnemy>& Enemy : Bench.Enemies)
+	{
+		if (Enemy.IsValid())
+		{
+			if (AController* Controller = Enemy->GetController())
+			{
+				Controller->Destroy();
+			}
+			Enemy->Destroy();
+		}
+	}
+	Bench.Enemies.Empty();
+}
+
+TStatId UCrowdSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCrowdSubsystem, STATGROUP_Tickables);
+}
@@ -3,17 +3,39 @@
 
 #include "Enemy/Enemy.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "Components/PoseableMeshComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Perception/PawnSensingComponent.h"
 #include "Components/AttributeComponent.h"
+#include "Components/PersistentStateComponent.h"
+#include "Diagnostics/CombatTelemetrySubsystem.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "CombatCore/CombatCoreConversions.h"
+#include "Enemy/AttackTokenSubsystem.h"
+#include "Enemy/EnemyAudioComponent.h"
+#include "Enemy/CorpseSubsystem.h"
+#include "Enemy/EnemyAIController.h"
+#include "Enemy/EnemyMovementComponent.h"
+#include "Enemy/PathRequestSubsystem.h"
+#include "Enemy/ProximitySubsystem.h"
 #include "HUD/HealthBarComponent.h"
+#include "Persistence/SaveGameSubsystem.h"
 #include "AIController.h"
+#include "Engine/GameInstance.h"
 #include "Items/Weapons/Weapon.h"
 #include "Navigation/PathFollowingComponent.h"
-
-AEnemy::AEnemy()
-{
-	PrimaryActorTick.bCanEverTick = true;
+#include "Spawning/AsyncSpawnSubsystem.h"
+#include "Spawning/SpawnDirectorSubsystem.h"
+#include "Replay/GameplayRandomSubsystem.h"
+#include "Net/UnrealNetwork.h"
+#include "MyProject3/MyProject3.h"
+
+AEnemy::AEnemy(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UEnemyMovementComponent>(ACharacter::CharacterMovementComponentName))
+{
+	LLM_SCOPE_BYTAG(Slash_Enemies);
+	// The AI runs off proximity events, timers and damage, there's nothing to do every frame
+	PrimaryActorTick.bCanEverTick = false;
 	GetMesh()->SetCollisionObjectType(ECollisionChannel::ECC_WorldDynamic);
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Visibility, ECollisionResponse::ECR_Block);
 	GetMesh()->SetCollisionResponseToChannel(ECollisionChannel::ECC_Camera, ECollisionResponse::ECR_Ignore);
@@ -30,31 +52,28 @@ AEnemy::AEnemy()
 	PawnSensing = CreateDefaultSubobject<UPawnSensingComponent>(TEXT("PawnSensing"));
 	PawnSensing->SightRadius = 4000.f;
 	PawnSensing->SetPeripheralVisionAngle(45.f);
-}
 
-void AEnemy::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
+	PersistentState = CreateDefaultSubobject<UPersistentStateComponent>(TEXT("PersistentState"));
 
-	if (IsDead()) return;
-	if (EnemyState > EEnemyState::EES_Patrolling)
-	{
-		CheckCombatTarget();
-	}
-	else
-	{
-		CheckPatrolTarget();
-	}
+	Audio = CreateDefaultSubobject<UEnemyAudioComponent>(TEXT("Audio"));
+
+	AIControllerClass = AEnemyAIController::StaticClass();
 }
 
 // We inherit this from Actor.h, and when apply damage is called from something else on the enemy, now this TakeDamage func will get called
 float AEnemy::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
+	SetIdleDormancy(false);
 	HandleDamage(DamageAmount);
 	CombatTarget = EventInstigator->GetPawn();
+	WatchCombatTarget();
 	if (IsInsideAttackRadius())
 	{
-		EnemyState = EEnemyState::EES_Attacking;
+		// Hitting back still takes a token, or every enemy in reach of the player would swing at once
+		if (!IsAttacking() && !IsEngaged())
+		{
+			TryStartAttack();
+		}
 	}
 	else  if (IsOutsideAttackRadius())
 	{
@@ -71,6 +90,35 @@ void AEnemy::Destroyed()
 	}
 }
 
+void AEnemy::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Streaming out doesn't call Destroyed, and the spawned weapon lives in the persistent level
+	if (EndPlayReason == EEndPlayReason::RemovedFromWorld && EquippedWeapon)
+	{
+		EquippedWeapon->Destroy();
+		EquippedWeapon = nullptr;
+	}
+	ClearPatrolTimer();
+	ClearAttackTimer();
+	GetWorldTimerManager().ClearTimer(StrafeTimer);
+	StopWatching();
+	ReleaseAttackToken();
+	CancelMove();
+	if (Attributes)
+	{
+		Attributes->OnHealthChanged.RemoveAll(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AEnemy::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AEnemy, EnemyState);
+	DOREPLIFETIME(AEnemy, DeathPose);
+}
+
 void AEnemy::GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter)
 {
 	Super::GetHit_Implementation(ImpactPoint, Hitter);
@@ -78,38 +126,96 @@ void AEnemy::GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter)
 	ClearPatrolTimer();
 	ClearAttackTimer();
 	SetWeaponCollisionEnabled(ECollisionEnabled::NoCollision);
+	if (UEnemyMovementComponent* EnemyMovement = GetEnemyMovement())
+	{
+		EnemyMovement->SetReducedMovementAllowed(false);
+	}
 
 	StopAttackMontage();
 }
 
+void AEnemy::GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const
+{
+	OutAssets.Add(WeaponClass.ToSoftObjectPath());
+}
+
+void AEnemy::GetPrewarmAssets(TArray<UObject*>& OutAssets) const
+{
+	Super::GetPrewarmAssets(OutAssets);
+	if (Audio)
+	{
+		Audio->GetSoundAssets(OutAssets);
+	}
+}
+
 void AEnemy::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Slash_Enemies);
 	Super::BeginPlay();
-	if (PawnSensing)
+	Tags.Add(FName("Enemy"));
+
+	if (!HasAuthority())
 	{
-		PawnSensing->OnSeePawn.AddDynamic(this, &AEnemy::PawnSeen);
+		HideHealthBar();
+		if (Attributes)
+		{
+			Attributes->OnHealthChanged.AddUObject(this, &AEnemy::OnReplicatedHealthChanged);
+		}
+		return;
 	}
 
-	InitializeEnemy();
-	Tags.Add(FName("Enemy"));
+	if (!ApplyPersistentState()) return;
 
+	InitializeEnemy();
 }
 
 void AEnemy::Die()
 {
-	EnemyState = EEnemyState::EES_Dead;
+	StopStrafing();
+	SetEnemyState(EEnemyState::EES_Dead);
+	if (UEnemyMovementComponent* EnemyMovement = GetEnemyMovement())
+	{
+		EnemyMovement->SetReducedMovementAllowed(false);
+	}
+	if (PersistentState)
+	{
+		FPersistentActorState State = PersistentState->GetState();
+		State.Flags |= EPersistentStateFlags::Dead;
+		PersistentState->SaveState(State);
+	}
 	PlayDeathMontage();
+	if (Audio)
+	{
+		Audio->PlayVocal(EEnemyVocal::EEV_Death);
+	}
+	ClearPatrolTimer();
 	ClearAttackTimer();
+	StopWatching();
+	ReleaseAttackToken();
+	CancelMove();
+	if (PawnSensing)
+	{
+		PawnSensing->OnSeePawn.RemoveAll(this);
+	}
 	DisableCapsule();
 	SetLifeSpan(DeathLifeSpan);
 	HideHealthBar();
 	GetCharacterMovement()->bOrientRotationToMovement = false;
 	SetWeaponCollisionEnabled(ECollisionEnabled::NoCollision);
+	// Tick only runs the AI, the corpse subsystem takes care of the rest once the pose settles
+	SetActorTickEnabled(false);
+	if (UCorpseSubsystem* Corpses = GetWorld()->GetSubsystem<UCorpseSubsystem>())
+	{
+		Corpses->AddCorpse(this);
+	}
+
+	// Nothing changes on a corpse, the final state goes out before it turns dormant
+	SetIdleDormancy(true);
 }
 
 void AEnemy::Attack()
 {
-	EnemyState = EEnemyState::EES_Engaged;
+	SetEnemyState(EEnemyState::EES_Engaged);
 	Super::Attack();
 	PlayAttackMontage();
 }
@@ -121,7 +227,11 @@ bool AEnemy::CanAttack()
 
 void AEnemy::AttackEnd()
 {
-	EnemyState = EEnemyState::EES_NoState;
+	// Called from the attack montage on every machine
+	if (!HasAuthority()) return;
+	SetEnemyState(EEnemyState::EES_NoState);
+	// Whoever has been waiting longest in reach gets the next swing, this one asks again below
+	ReleaseAttackToken();
 	CheckCombatTarget();
 }
 
@@ -132,6 +242,16 @@ void AEnemy::HandleDamage(float DamageAmount)
 	{
 		HealthBarWidget->SetHealthPercent(Attributes->GetHealthPercent());
 	}
+	if (Audio && IsAlive())
+	{
+		Audio->PlayVocal(EEnemyVocal::EEV_Pain);
+	}
+	if (Attributes && PersistentState && PersistentState->HasPersistentGuid())
+	{
+		FPersistentActorState State = PersistentState->GetState();
+		State.SetHealthPercent(Attributes->GetHealthPercent());
+		PersistentState->SaveState(State);
+	}
 }
 
 int32 AEnemy::PlayDeathMontage()
@@ -148,12 +268,69 @@ int32 AEnemy::PlayDeathMontage()
 	return Selection;
 }
 
+// Returns false if the enemy already died before it streamed out
+bool AEnemy::ApplyPersistentState()
+{
+	if (PersistentState == nullptr) return true;
+
+	// Where a loaded save left it, the AI starts over from there
+	USaveGameSubsystem* SaveGame = GetGameInstance() ? GetGameInstance()->GetSubsystem<USaveGameSubsystem>() : nullptr;
+	SaveFile::FEnemy Saved;
+	if (SaveGame && SaveGame->ConsumeEnemy(PersistentState->GetPersistentGuid(), Saved))
+	{
+		SetActorLocationAndRotation(FVector(Saved.Location), FRotator(0.f, Saved.Yaw, 0.f), false, nullptr, ETeleportType::TeleportPhysics);
+	}
+
+	FPersistentActorState State;
+	if (!PersistentState->LoadState(State)) return true;
+
+	if (State.HasFlag(EPersistentStateFlags::Dead))
+	{
+		Destroy();
+		return false;
+	}
+	if (Attributes)
+	{
+		Attributes->SetHealthPercent(State.GetHealthPercent());
+		if (HealthBarWidget)
+		{
+			HealthBarWidget->SetHealthPercent(Attributes->GetHealthPercent());
+		}
+	}
+	return true;
+}
+
 void AEnemy::InitializeEnemy()
 {
 	EnemyController = Cast<AAIController>(GetController());
-	MoveToTarget(PatrolTarget);
+	if (UEnemyMovementComponent* EnemyMovement = GetEnemyMovement())
+	{
+		EnemyMovement->SetReducedMovementAllowed(EnemyState == EEnemyState::EES_Patrolling);
+	}
 	HideHealthBar();
-	SpawnDefaultWeapon();
+
+	// The path request, the weapon spawn and sensing are spread over frames by the spawn director,
+	// so a map full of enemies or a wave doesn't do them all at once. Each may find the enemy
+	// already fighting or dead by the time it runs.
+	USpawnDirectorSubsystem::QueueInitStep(this, [this]()
+	{
+		if (EnemyState == EEnemyState::EES_Patrolling && EnemyController && !EnemyController->IsFollowingAPath())
+		{
+			MoveToTarget(PatrolTarget);
+			WatchPatrolTarget();
+		}
+	});
+	USpawnDirectorSubsystem::QueueInitStep(this, [this]()
+	{
+		if (!IsDead()) SpawnDefaultWeapon();
+	});
+	USpawnDirectorSubsystem::QueueInitStep(this, [this]()
+	{
+		if (PawnSensing && !IsDead())
+		{
+			PawnSensing->OnSeePawn.AddDynamic(this, &AEnemy::PawnSeen);
+		}
+	});
 }
 
 void AEnemy::CheckPatrolTarget()
@@ -161,40 +338,57 @@ void AEnemy::CheckPatrolTarget()
 	if (InTargetRange(PatrolTarget, PatrolRadius))
 	{
 		PatrolTarget = ChoosePatrolTarget();
-		const float WaitTime = FMath::RandRange(MinPatrolWaitTime, MaxPatrolWaitTime);
+		const float WaitTime = UGameplayRandomSubsystem::GetStream(this, EGameplayRandom::Patrol).FRandRange(MinPatrolWaitTime, MaxPatrolWaitTime);
 		// PatrolTimerFinished just waits and moves
 		GetWorldTimerManager().SetTimer(PatrolTimer, this, &AEnemy::PatrolTimerFinished, WaitTime);
+		StopWatching();
+		SetIdleDormancy(true);
 	}
 }
 
 void AEnemy::CheckCombatTarget()
 {
-	if (IsOutsideCombatRadius())
+	const float DistanceSquared = CombatTarget
+		? CombatCore::LengthSquared(CombatCore::ToCore(CombatTarget->GetActorLocation() - GetActorLocation()))
+		: TNumericLimits<float>::Max();
+
+	// Strafing holds its distance like chasing does until a token frees up
+	uint8 Flags = 0;
+	if (IsChasing() || IsStrafing()) Flags |= CombatCore::CombatFlags::Chasing;
+	if (IsAttacking()) Flags |= CombatCore::CombatFlags::Attacking;
+	if (IsEngaged()) Flags |= CombatCore::CombatFlags::Engaged;
+	if (IsDead()) Flags |= CombatCore::CombatFlags::Dead;
+
+	switch (CombatCore::DecideCombat(DistanceSquared, static_cast<float>(CombatRadius), static_cast<float>(AttackRadius), Flags))
 	{
+	case CombatCore::ECombatDecision::LoseInterest:
 		ClearAttackTimer();
 		LoseInterest();
-		if (!IsEngaged())
-		{
-			StartPatrolling();
-		}
-	}
-	else if (IsOutsideAttackRadius() && !IsChasing()) // Dont spam setting chasing state
-	{
+		break;
+	case CombatCore::ECombatDecision::Patrol:
 		ClearAttackTimer();
-		if (!IsEngaged())
-		{
-			ChaseTarget();
-		}
-	}
-	else if (CanAttack()) // Dont spam setting attacking state
-	{
-		StartAttackTimer();
+		LoseInterest();
+		StartPatrolling();
+		break;
+	case CombatCore::ECombatDecision::StopAttacking:
+		ClearAttackTimer();
+		break;
+	case CombatCore::ECombatDecision::Chase:
+		ClearAttackTimer();
+		ChaseTarget();
+		break;
+	case CombatCore::ECombatDecision::Attack:
+		TryStartAttack();
+		break;
+	case CombatCore::ECombatDecision::None:
+		break;
 	}
 }
 
 void AEnemy::PatrolTimerFinished()
 {
 	MoveToTarget(PatrolTarget);
+	WatchPatrolTarget();
 }
 
 void AEnemy::HideHealthBar()
@@ -207,38 +401,176 @@ void AEnemy::HideHealthBar()
 
 void AEnemy::ShowHealthBar()
 {
-	UE_LOG(LogTemp, Warning, TEXT("SHB called"));
 	if (HealthBarWidget)
 	{
-		UE_LOG(LogTemp, Warning, TEXT("Setting to true"));
 		HealthBarWidget->SetVisibility(true);
 	}
-	else {
-		UE_LOG(LogTemp, Warning, TEXT("HBar wasnt a valid ptr"));
-	}
-	UE_LOG(LogTemp, Warning, TEXT("----------------------"));
 }
 
 void AEnemy::LoseInterest()
 {
 	HideHealthBar();
 	CombatTarget = nullptr;
+	StopStrafing();
+	StopWatching();
+	ReleaseAttackToken();
 }
 
 void AEnemy::StartPatrolling()
 {
-	EnemyState = EEnemyState::EES_Patrolling;
+	SetEnemyState(EEnemyState::EES_Patrolling);
 	GetCharacterMovement()->MaxWalkSpeed = PatrollingSpeed;
+	if (UEnemyMovementComponent* EnemyMovement = GetEnemyMovement())
+	{
+		EnemyMovement->SetReducedMovementAllowed(true);
+	}
 	MoveToTarget(PatrolTarget);
+	WatchPatrolTarget();
 }
 
 void AEnemy::ChaseTarget()
 {
-	EnemyState = EEnemyState::EES_Chasing;
+	StopStrafing();
+	SetEnemyState(EEnemyState::EES_Chasing);
 	GetCharacterMovement()->MaxWalkSpeed = ChasingSpeed;
+	if (UEnemyMovementComponent* EnemyMovement = GetEnemyMovement())
+	{
+		EnemyMovement->SetReducedMovementAllowed(false);
+	}
 	MoveToTarget(CombatTarget);
 }
 
+void AEnemy::TryStartAttack()
+{
+	UAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UAttackTokenSubsystem>();
+	if (AttackTokens == nullptr || AttackTokens->RequestToken(this, CombatTarget))
+	{
+		StopStrafing();
+		StartAttackTimer();
+	}
+	else if (!IsStrafing())
+	{
+		StartStrafing();
+	}
+}
+
+void AEnemy::OnAttackTokenGranted()
+{
+	// Only strafers wait in line, anyone else got hit or moved on since asking
+	if (!IsStrafing() || CombatTarget == nullptr)
+	{
+		ReleaseAttackToken();
+		return;
+	}
+
+	// Attacks straight away if still in reach, otherwise the attack radius crossing does it
+	ChaseTarget();
+	CheckCombatTarget();
+}
+
+void AEnemy::StartStrafing()
+{
+	SetEnemyState(EEnemyState::EES_Strafing);
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	Movement->MaxWalkSpeed = StrafingSpeed;
+	Movement->bOrientRotationToMovement = false;
+	Movement->bUseControllerDesiredRotation = true;
+	if (EnemyController)
+	{
+		EnemyController->SetFocus(CombatTarget);
+	}
+	StrafeStep();
+}
+
+void AEnemy::StopStrafing()
+{
+	GetWorldTimerManager().ClearTimer(StrafeTimer);
+	if (!IsStrafing()) return;
+
+	UCharacterMovementComponent* Movement = GetCharacterMovement();
+	Movement->bOrientRotationToMovement = true;
+	Movement->bUseControllerDesiredRotation = false;
+	if (EnemyController)
+	{
+		EnemyController->ClearFocus(EAIFocusPriority::Gameplay);
+	}
+}
+
+void AEnemy::StrafeStep()
+{
+	if (CombatTarget == nullptr || EnemyController == nullptr) return;
+
+	// A short hop around the ring every few seconds, no per frame steering
+	FRandomStream& Random = UGameplayRandomSubsystem::GetStream(this, EGameplayRandom::Combat);
+	FVector FromTarget = (GetActorLocation() - CombatTarget->GetActorLocation()).GetSafeNormal2D();
+	if (FromTarget.IsNearlyZero())
+	{
+		FromTarget = -GetActorForwardVector();
+	}
+	const float Step = Random.FRandRange(30.f, 60.f) * (Random.RandRange(0, 1) ? 1.f : -1.f);
+	const FVector Goal = CombatTarget->GetActorLocation() + FromTarget.RotateAngleAxis(Step, FVector::UpVector) * StrafeRadius;
+
+	SetIdleDormancy(false);
+	FAIMoveRequest MoveRequest(Goal);
+	MoveRequest.SetAcceptanceRadius(25.f);
+	RequestMove(MoveRequest, EPathPriority::Strafe);
+
+	GetWorldTimerManager().SetTimer(StrafeTimer, this, &AEnemy::StrafeStep, Random.FRandRange(StrafeMinTime, StrafeMaxTime));
+}
+
+void AEnemy::ReleaseAttackToken()
+{
+	if (UAttackTokenSubsystem* AttackTokens = GetWorld()->GetSubsystem<UAttackTokenSubsystem>())
+	{
+		AttackTokens->ReleaseToken(this);
+	}
+}
+
+int32 AEnemy::WatchCombatTarget()
+{
+	UProximitySubsystem* Proximity = GetWorld()->GetSubsystem<UProximitySubsystem>();
+	if (Proximity == nullptr || CombatTarget == nullptr) return INDEX_NONE;
+
+	const float Radii[] = { static_cast<float>(AttackRadius), static_cast<float>(CombatRadius) };
+	return Proximity->Watch(this, CombatTarget, Radii, FOnProximityCrossed::CreateUObject(this, &AEnemy::OnCombatBandCrossed));
+}
+
+void AEnemy::WatchPatrolTarget()
+{
+	UProximitySubsystem* Proximity = GetWorld()->GetSubsystem<UProximitySubsystem>();
+	if (Proximity == nullptr || PatrolTarget == nullptr) return;
+
+	const float Radii[] = { static_cast<float>(PatrolRadius) };
+	if (Proximity->Watch(this, PatrolTarget, Radii, FOnProximityCrossed::CreateUObject(this, &AEnemy::OnPatrolBandCrossed)) == 0)
+	{
+		CheckPatrolTarget();
+	}
+}
+
+void AEnemy::StopWatching()
+{
+	if (UProximitySubsystem* Proximity = GetWorld()->GetSubsystem<UProximitySubsystem>())
+	{
+		Proximity->Unwatch(this);
+	}
+}
+
+void AEnemy::OnCombatBandCrossed(int32 Band, bool bEntered)
+{
+	LLM_SCOPE_BYTAG(Slash_AI);
+	if (IsDead() || EnemyState <= EEnemyState::EES_Patrolling) return;
+	CheckCombatTarget();
+}
+
+void AEnemy::OnPatrolBandCrossed(int32 Band, bool bEntered)
+{
+	LLM_SCOPE_BYTAG(Slash_AI);
+	if (bEntered && !IsDead() && EnemyState <= EEnemyState::EES_Patrolling)
+	{
+		CheckPatrolTarget();
+	}
+}
+
 bool AEnemy::IsOutsideCombatRadius()
 {
 	return !InTargetRange(CombatTarget, CombatRadius);
@@ -259,6 +591,11 @@ bool AEnemy::IsChasing()
 	return EnemyState == EEnemyState::EES_Chasing;
 }
 
+bool AEnemy::IsStrafing()
+{
+	return EnemyState == EEnemyState::EES_Strafing;
+}
+
 bool AEnemy::IsAttacking()
 {
 	return EnemyState == EEnemyState::EES_Attacking;
@@ -281,8 +618,8 @@ void AEnemy::ClearPatrolTimer()
 
 void AEnemy::StartAttackTimer()
 {
-	EnemyState = EEnemyState::EES_Attacking;
-	const float AttackTime = FMath::RandRange(AttackMin, AttackMax);
+	SetEnemyState(EEnemyState::EES_Attacking);
+	const float AttackTime = UGameplayRandomSubsystem::GetStream(this, EGameplayRandom::Combat).FRandRange(AttackMin, AttackMax);
 	GetWorldTimerManager().SetTimer(AttackTimer, this, &AEnemy::Attack, AttackTime);
 }
 
@@ -294,17 +631,39 @@ void AEnemy::ClearAttackTimer()
 bool AEnemy::InTargetRange(AActor* Target, double Radius)
 {
 	if (Target == nullptr) return false;
-	const double DistanceToTarget = (Target->GetActorLocation() - GetActorLocation()).Size();
-	return DistanceToTarget <= Radius;
+	return CombatCore::IsInRange(CombatCore::ToCore(Target->GetActorLocation() - GetActorLocation()), static_cast<float>(Radius));
 }
 
 void AEnemy::MoveToTarget(AActor* Target)
 {
+	LLM_SCOPE_BYTAG(Slash_AI);
 	if (EnemyController == nullptr || Target == nullptr) return;
+	SetIdleDormancy(false);
 	FAIMoveRequest MoveRequest;
 	MoveRequest.SetGoalActor(Target);
 	MoveRequest.SetAcceptanceRadius(50.f);
-	EnemyController->MoveTo(MoveRequest);
+	RequestMove(MoveRequest, Target == CombatTarget ? EPathPriority::Chase : EPathPriority::Patrol);
+}
+
+void AEnemy::RequestMove(const FAIMoveRequest& MoveRequest, EPathPriority Priority)
+{
+	if (UPathRequestSubsystem* PathRequests = GetWorld()->GetSubsystem<UPathRequestSubsystem>())
+	{
+		PathRequests->RequestMove(EnemyController, MoveRequest, Priority);
+	}
+	else
+	{
+		EnemyController->MoveTo(MoveRequest);
+	}
+}
+
+void AEnemy::CancelMove()
+{
+	UPathRequestSubsystem* PathRequests = GetWorld()->GetSubsystem<UPathRequestSubsystem>();
+	if (PathRequests && EnemyController)
+	{
+		PathRequests->CancelMove(EnemyController);
+	}
 }
 
 AActor* AEnemy::ChoosePatrolTarget()
@@ -320,7 +679,7 @@ AActor* AEnemy::ChoosePatrolTarget()
 
 	if (ValidTargets.Num() > 0)
 	{
-		const int32 Selection = FMath::RandRange(0, ValidTargets.Num() - 1);
+		const int32 Selection = UGameplayRandomSubsystem::GetStream(this, EGameplayRandom::Patrol).RandRange(0, ValidTargets.Num() - 1);
 		return ValidTargets[Selection];
 	}
 	return nullptr;
@@ -329,27 +688,170 @@ AActor* AEnemy::ChoosePatrolTarget()
 void AEnemy::SpawnDefaultWeapon()
 {
 	UWorld* World = GetWorld();
-	if (World && WeaponClass)
+	UAsyncSpawnSubsystem* AsyncSpawn = World ? World->GetSubsystem<UAsyncSpawnSubsystem>() : nullptr;
+	if (AsyncSpawn && !WeaponClass.IsNull())
 	{
-		AWeapon* DefaultWeapon = World->SpawnActor<AWeapon>(WeaponClass);
-		DefaultWeapon->Equip(this->GetMesh(), FName("RightHandSocket"), this, this);
-		EquippedWeapon = DefaultWeapon;
+		// Usually already preloaded and this spawns right away, otherwise it waits for the load
+		TWeakObjectPtr<AEnemy> WeakThis(this);
+		AsyncSpawn->SpawnActorAsync(WeaponClass, FTransform::Identity, FActorSpawnParameters(), [WeakThis](AActor* Spawned)
+		{
+			AEnemy* Enemy = WeakThis.Get();
+			AWeapon* DefaultWeapon = Cast<AWeapon>(Spawned);
+			if (Enemy == nullptr || Enemy->IsDead() || DefaultWeapon == nullptr)
+			{
+				Spawned->Destroy();
+				return;
+			}
+			DefaultWeapon->Equip(Enemy->GetMesh(), FName("RightHandSocket"), Enemy, Enemy);
+			Enemy->EquippedWeapon = DefaultWeapon;
+		});
+	}
+}
+
+void AEnemy::FreezeCorpse(bool bUsePoseSnapshot)
+{
+	SetActorTickEnabled(false);
+	if (UCharacterMovementComponent* Movement = GetCharacterMovement())
+	{
+		Movement->StopMovementImmediately();
+		Movement->DisableMovement();
+		Movement->SetComponentTickEnabled(false);
+	}
+	if (PawnSensing)
+	{
+		PawnSensing->OnSeePawn.RemoveAll(this);
+		PawnSensing->SetSensingUpdatesEnabled(false);
+	}
+	if (HealthBarWidget)
+	{
+		HealthBarWidget->DestroyComponent();
+		HealthBarWidget = nullptr;
+	}
+	if (HasAuthority() && EnemyController)
+	{
+		EnemyController->UnPossess();
+		EnemyController->Destroy();
+		EnemyController = nullptr;
+	}
+
+	USkeletalMeshComponent* Body = GetMesh();
+	if (bUsePoseSnapshot && Body->GetSkeletalMeshAsset())
+	{
+		// Holds the last evaluated pose with no anim instance behind it
+		UPoseableMeshComponent* PoseSnapshot = NewObject<UPoseableMeshComponent>(this, TEXT("CorpsePose"));
+		PoseSnapshot->SetupAttachment(Body);
+		PoseSnapshot->SetSkinnedAssetAndUpdate(Body->GetSkeletalMeshAsset());
+		PoseSnapshot->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		for (int32 Index = 0; Index < Body->GetNumMaterials(); ++Index)
+		{
+			PoseSnapshot->SetMaterial(Index, Body->GetMaterial(Index));
+		}
+		PoseSnapshot->RegisterComponent();
+		PoseSnapshot->CopyPoseFromSkeletalComponent(Body);
+
+		// The weapon hangs off the body's socket, only the body itself goes
+		Body->SetVisibility(false, false);
+	}
+
+	// Without the snapshot the paused body keeps showing its last pose
+	Body->bPauseAnims = true;
+	Body->SetComponentTickEnabled(false);
+}
+
+UEnemyMovementComponent* AEnemy::GetEnemyMovement() const
+{
+	return Cast<UEnemyMovementComponent>(GetCharacterMovement());
+}
+
+void AEnemy::SetEnemyState(EEnemyState NewState)
+{
+	SLASH_COMBAT_EVENT(StateChange, this, CombatTarget, GetActorLocation(), 0.f, static_cast<uint8>(NewState), static_cast<uint8>(EnemyState));
+	EnemyState = NewState;
+}
+
+void AEnemy::SetIdleDormancy(bool bIdle)
+{
+	// A corpse stays dormant
+	if (!HasAuthority() || (IsDead() && !bIdle)) return;
+	SetNetDormancy(bIdle ? ENetDormancy::DORM_DormantAll : ENetDormancy::DORM_Awake);
+}
+
+void AEnemy::OnReplicatedHealthChanged(float HealthPercent)
+{
+	if (HealthBarWidget)
+	{
+		HealthBarWidget->SetHealthPercent(HealthPercent);
+	}
+	if (!IsDead() && HealthPercent < 1.f)
+	{
+		ShowHealthBar();
+	}
+	if (Audio && HealthPercent > 0.f && HealthPercent < LastReplicatedHealthPercent)
+	{
+		Audio->PlayVocal(EEnemyVocal::EEV_Pain);
+	}
+	LastReplicatedHealthPercent = HealthPercent;
+}
+
+void AEnemy::OnRep_EnemyState(EEnemyState OldState)
+{
+	if (IsDead())
+	{
+		if (Audio && OldState != EEnemyState::EES_Dead)
+		{
+			Audio->PlayVocal(EEnemyVocal::EEV_Death);
+		}
+		HideHealthBar();
+		DisableCapsule();
+		GetCharacterMovement()->bOrientRotationToMovement = false;
+		SetActorTickEnabled(false);
+		if (UCorpseSubsystem* Corpses = GetWorld()->GetSubsystem<UCorpseSubsystem>())
+		{
+			Corpses->AddCorpse(this);
+		}
+	}
+	else if (EnemyState == EEnemyState::EES_Patrolling)
+	{
+		HideHealthBar();
+	}
+	else if (Audio && EnemyState == EEnemyState::EES_Chasing && OldState == EEnemyState::EES_Patrolling)
+	{
+		Audio->PlayVocal(EEnemyVocal::EEV_Aggro);
 	}
 }
 
 void AEnemy::PawnSeen(APawn* SeenPawn)
 {
+	if (SeenPawn->ActorHasTag(FName("EngageableTarget")))
+	{
+		EngageTarget(SeenPawn);
+	}
+}
+
+void AEnemy::EngageTarget(APawn* Target)
+{
+	LLM_SCOPE_BYTAG(Slash_AI);
 	const bool shouldChaseTarget =
+		Target &&
 		EnemyState != EEnemyState::EES_Dead &&
 		EnemyState != EEnemyState::EES_Chasing &&
-		EnemyState < EEnemyState::EES_Attacking &&
-		SeenPawn->ActorHasTag(FName("EngageableTarget"));
+		EnemyState != EEnemyState::EES_Strafing &&
+		EnemyState < EEnemyState::EES_Attacking;
 	if (shouldChaseTarget)
 	{
-		CombatTarget = SeenPawn;
+		if (Audio && EnemyState == EEnemyState::EES_Patrolling)
+		{
+			Audio->PlayVocal(EEnemyVocal::EEV_Aggro);
+		}
+		CombatTarget = Target;
 		ClearPatrolTimer();
 		ChaseTarget();
-
+		// Already in reach or past the combat radius, no crossing is coming for either
+		const int32 Band = WatchCombatTarget();
+		if (Band != 1)
+		{
+			CheckCombatTarget();
+		}
 	}
 }
 
@@ -0,0 +1,36 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/EnemyAIController.h"
+#include "Enemy/CrowdSubsystem.h"
+#include "Navigation/CrowdFollowingComponent.h"
+
+AEnemyAIController::AEnemyAIController(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UCrowdFollowingComponent>(TEXT("PathFollowingComponent")))
+{
+}
+
+UCrowdFollowingComponent* AEnemyAIController::GetCrowdFollowing() const
+{
+	return Cast<UCrowdFollowingComponent>(GetPathFollowingComponent());
+}
+
+void AEnemyAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	if (UCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UCrowdSubsystem>())
+	{
+		Crowd->RegisterAgent(this);
+	}
+}
+
+void AEnemyAIController::OnUnPossess()
+{
+	if (UCrowdSubsystem* Crowd = GetWorld()->GetSubsystem<UCrowdSubsystem>())
+	{
+		Crowd->UnregisterAgent(this);
+	}
+
+	Super::OnUnPossess();
+}
@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/EnemyAudioComponent.h"
+#include "Enemy/EnemyAudioSubsystem.h"
+#include "Replay/GameplayRandomSubsystem.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Sound/SoundBase.h"
+
+UEnemyAudioComponent::UEnemyAudioComponent()
+{
+	// Only ticks while audible, the enemy audio subsystem turns it on
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UEnemyAudioComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Seeded off the gameplay seed and the owner's name, so a replay shuffles the same sounds
+	const UGameplayRandomSubsystem* GameplayRandom = GetWorld()->GetSubsystem<UGameplayRandomSubsystem>();
+	const uint32 Seed = GameplayRandom ? GameplayRandom->GetSeed() : FPlatformTime::Cycles();
+	Random.Initialize(static_cast<int32>(HashCombine(Seed, GetTypeHash(GetOwner()->GetFName()))));
+	if (UEnemyAudioSubsystem* EnemyAudio = GetWorld()->GetSubsystem<UEnemyAudioSubsystem>())
+	{
+		EnemyAudio->Register(this);
+	}
+}
+
+void UEnemyAudioComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UEnemyAudioSubsystem* EnemyAudio = GetWorld()->GetSubsystem<UEnemyAudioSubsystem>())
+	{
+		EnemyAudio->Unregister(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void UEnemyAudioComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	if (Character == nullptr || !Character->GetCharacterMovement() || !Character->GetCharacterMovement()->IsMovingOnGround())
+	{
+		DistanceSinceStep = 0.f;
+		return;
+	}
+
+	const float Speed = static_cast<float>(Character->GetVelocity().Size2D());
+	if (Speed < MinStepSpeed)
+	{
+		// The first step after standing is half a stride in
+		DistanceSinceStep = StrideLength * 0.5f;
+		return;
+	}
+
+	DistanceSinceStep += Speed * DeltaTime;
+	if (DistanceSinceStep >= StrideLength)
+	{
+		DistanceSinceStep = FMath::Fmod(DistanceSinceStep, StrideLength);
+		PlayFootstep();
+	}
+}
+
+void UEnemyAudioComponent::PlayFootstep()
+{
+	if (!bAudible) return;
+
+	UEnemyAudioSubsystem* EnemyAudio = GetWorld()->GetSubsystem<UEnemyAudioSubsystem>();
+	if (EnemyAudio && FootstepSounds.Num() > 0)
+	{
+		EnemyAudio->TryPlay(PickSound(FootstepSounds, FootstepBag), GetFootLocation(), EEnemySoundKind::Footstep);
+	}
+}
+
+void UEnemyAudioComponent::PlayVocal(EEnemyVocal Vocal)
+{
+	// Dying is worth hearing even if the subsystem hasn't caught up with the enemy being close yet
+	if (!bAudible && Vocal != EEnemyVocal::EEV_Death) return;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	if (Vocal != EEnemyVocal::EEV_Death && Now - LastVocalTime < VocalCooldown) return;
+
+	UEnemyAudioSubsystem* EnemyAudio = GetWorld()->GetSubsystem<UEnemyAudioSubsystem>();
+	if (EnemyAudio == nullptr) return;
+
+	USoundBase* Sound = nullptr;
+	switch (Vocal)
+	{
+	case EEnemyVocal::EEV_Aggro: Sound = PickSound(AggroSounds, AggroBag); break;
+	case EEnemyVocal::EEV_Pain: Sound = PickSound(PainSounds, PainBag); break;
+	case EEnemyVocal::EEV_Death: Sound = PickSound(DeathSounds, DeathBag); break;
+	}
+
+	if (EnemyAudio->TryPlay(Sound, GetOwner()->GetActorLocation(), EEnemySoundKind::Vocal))
+	{
+		LastVocalTime = Now;
+	}
+}
+
+void UEnemyAudioComponent::SetAudible(bool bInAudible)
+{
+	if (bAudible == bInAudible) return;
+	bAudible = bInAudible;
+	SetComponentTickEnabled(bAudible && !bFootstepsFromNotifies && FootstepSounds.Num() > 0);
+}
+
+float UEnemyAudioComponent::GetAudibleDistance() const
+{
+	float Distance = 0.f;
+	for (const TArray<USoundBase*>* Sounds : { &FootstepSounds, &AggroSounds, &PainSounds, &DeathSounds })
+	{
+		for (const USoundBase* Sound : *Sounds)
+		{
+			if (Sound) Distance = FMath::Max(Distance, Sound->GetMaxDistance());
+		}
+	}
+	return Distance;
+}
+
+void UEnemyAudioComponent::GetSoundAssets(TArray<UObject*>& OutAssets) const
+{
+	OutAssets.Append(FootstepSounds);
+	OutAssets.Append(AggroSounds);
+	OutAssets.Append(PainSounds);
+	OutAssets.Append(DeathSounds);
+}
+
+USoundBase* UEnemyAudioComponent::PickSound(const TArray<USoundBase*>& Sounds, FShuffleBag& Bag)
+{
+	if (Sounds.Num() == 0) return nullptr;
+	if (Sounds.Num() == 1) return Sounds[0];
+
+	if (Bag.Order.Num() != Sounds.Num() || Bag.Next >= Bag.Order.Num())
+	{
+		const int32 Last = Bag.Order.IsValidIndex(Bag.Next - 1) ? Bag.Order[Bag.Next - 1] : INDEX_NONE;
+		Bag.Order.SetNum(Sounds.Num());
+		for (int32 Index = 0; Index < Bag.Order.Num(); ++Index)
+		{
+			Bag.Order[Index] = Index;
+		}
+		for (int32 Index = Bag.Order.Num() - 1; Index > 0; --Index)
+		{
+			Bag.Order.Swap(Index, Random.RandRange(0, Index));
+		}
+		// The new round can't start with what ended the last one
+		if (Bag.Order[0] == Last)
+		{
+			Bag.Order.Swap(0, Random.RandRange(1, Bag.Order.Num() - 1));
+		}
+		Bag.Next = 0;
+	}
+	return Sounds[Bag.Order[Bag.Next++]];
+}
+
+FVector UEnemyAudioComponent::GetFootLocation() const
+{
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	const UCapsuleComponent* Capsule = Character ? Character->GetCapsuleComponent() : nullptr;
+	return GetOwner()->GetActorLocation() - FVector(0.f, 0.f, Capsule ? Capsule->GetScaledCapsuleHalfHeight() : 0.f);
+}
@@ -0,0 +1,162 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/EnemyAudioSubsystem.h"
+#include "Enemy/EnemyAudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Loading/LevelPrewarmSubsystem.h"
+#include "Sound/SoundBase.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Audible Enemies"), STAT_SlashAudibleEnemies, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Sounds Played"), STAT_SlashEnemySoundsPlayed, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Sounds Culled"), STAT_SlashEnemySoundsCulled, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Sounds Capped"), STAT_SlashEnemySoundsCapped, STATGROUP_Slash);
+
+static TAutoConsoleVariable<float> CVarAudioMaxDistance(
+	TEXT("slash.Audio.MaxDistance"),
+	3000.f,
+	TEXT("Enemy sounds further than this from every listener are never created, even if their attenuation reaches further."));
+
+static TAutoConsoleVariable<int32> CVarAudioMaxFootsteps(
+	TEXT("slash.Audio.MaxFootsteps"),
+	6,
+	TEXT("Enemy footsteps playing at once per listener."));
+
+static TAutoConsoleVariable<int32> CVarAudioMaxVocals(
+	TEXT("slash.Audio.MaxVocals"),
+	3,
+	TEXT("Enemy vocals playing at once per listener."));
+
+static TAutoConsoleVariable<float> CVarAudioCullInterval(
+	TEXT("slash.Audio.CullInterval"),
+	0.5f,
+	TEXT("Seconds between deciding which enemies are close enough to a listener to make sounds."));
+
+bool UEnemyAudioSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// Nobody is listening on a dedicated server
+	return Super::ShouldCreateSubsystem(Outer) && !IsRunningDedicatedServer();
+}
+
+void UEnemyAudioSubsystem::Tick(float DeltaTime)
+{
+	UpdateListeners();
+
+	TimeSinceCull += DeltaTime;
+	if (TimeSinceCull < CVarAudioCullInterval.GetValueOnGameThread()) return;
+	TimeSinceCull = 0.f;
+
+	Components.RemoveAll([](const TWeakObjectPtr<UEnemyAudioComponent>& Component) { return !Component.IsValid(); });
+	const float MaxDistance = CVarAudioMaxDistance.GetValueOnGameThread();
+	int32 NumAudible = 0;
+	for (const TWeakObjectPtr<UEnemyAudioComponent>& Component : Components)
+	{
+		const AActor* Owner = Component->GetOwner();
+		double DistanceSquared = 0.0;
+		// Clamped like TryPlay, sounds without attenuation would make every enemy in the map audible
+		const bool bAudible = Owner
+			&& FindNearestListener(Owner->GetActorLocation(), DistanceSquared) != INDEX_NONE
+			&& DistanceSquared <= FMath::Square(FMath::Min(Component->GetAudibleDistance(), MaxDistance));
+		Component->SetAudible(bAudible);
+		NumAudible += bAudible ? 1 : 0;
+	}
+	SET_DWORD_STAT(STAT_SlashAudibleEnemies, NumAudible);
+}
+
+void UEnemyAudioSubsystem::Register(UEnemyAudioComponent* Component)
+{
+	Components.AddUnique(Component);
+}
+
+void UEnemyAudioSubsystem::Unregister(UEnemyAudioComponent* Component)
+{
+	Components.Remove(Component);
+}
+
+bool UEnemyAudioSubsystem::TryPlay(USoundBase* Sound, const FVector& Location, EEnemySoundKind Kind)
+{
+	if (Sound == nullptr) return false;
+
+	double DistanceSquared = 0.0;
+	const int32 ListenerIndex = FindNearestListener(Location, DistanceSquared);
+	const float MaxDistance = FMath::Min(Sound->GetMaxDistance(), CVarAudioMaxDistance.GetValueOnGameThread());
+	if (ListenerIndex == INDEX_NONE || DistanceSquared > FMath::Square(MaxDistance))
+	{
+		INC_DWORD_STAT(STAT_SlashEnemySoundsCulled);
+		return false;
+	}
+
+	FListener& Listener = Listeners[ListenerIndex];
+	TArray<double>& Playing = Kind == EEnemySoundKind::Footstep ? Listener.FootstepsPlaying : Listener.VocalsPlaying;
+	const int32 MaxPlaying = Kind == EEnemySoundKind::Footstep ? CVarAudioMaxFootsteps.GetValueOnGameThread() : CVarAudioMaxVocals.GetValueOnGameThread();
+	if (Playing.Num() >= MaxPlaying)
+	{
+		INC_DWORD_STAT(STAT_SlashEnemySoundsCapped);
+		return false;
+	}
+
+	ULevelPrewarmSubsystem::NoteAssetUse(this, Sound);
+	UGameplayStatics::PlaySoundAtLocation(this, Sound, Location);
+	INC_DWORD_STAT(STAT_SlashEnemySoundsPlayed);
+
+	// Looping sounds aren't used here, count them as a second so they can't hold a slot forever
+	const float Duration = Sound->GetDuration();
+	Playing.Add(GetWorld()->GetTimeSeconds() + (Duration < INDEFINITELY_LOOPING_DURATION ? Duration : 1.f));
+	return true;
+}
+
+bool UEnemyAudioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEnemyAudioSubsystem::UpdateListeners()
+{
+	int32 NumListeners = 0;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController == nullptr || !PlayerController->IsLocalController()) continue;
+
+		if (!Listeners.IsValidIndex(NumListeners))
+		{
+			Listeners.AddDefaulted();
+		}
+		FVector FrontDir;
+		FVector RightDir;
+		PlayerController->GetAudioListenerPosition(Listeners[NumListeners].Location, FrontDir, RightDir);
+		++NumListeners;
+	}
+	Listeners.SetNum(NumListeners);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	for (FListener& Listener : Listeners)
+	{
+		Listener.FootstepsPlaying.RemoveAllSwap([Now](double EndTime) { return EndTime <= Now; });
+		Listener.VocalsPlaying.RemoveAllSwap([Now](double EndTime) { return EndTime <= Now; });
+	}
+}
+
+int32 UEnemyAudioSubsystem::FindNearestListener(const FVector& Location, double& OutDistanceSquared) const
+{
+	int32 Nearest = INDEX_NONE;
+	OutDistanceSquared = TNumericLimits<double>::Max();
+	for (int32 Index = 0; Index < Listeners.Num(); ++Index)
+	{
+		const double DistanceSquared = FVector::DistSquared(Listeners[Index].Location, Location);
+		if (DistanceSquared < OutDistanceSquared)
+		{
+			OutDistanceSquared = DistanceSquared;
+			Nearest = Index;
+		}
+	}
+	return Nearest;
+}
+
+TStatId UEnemyAudioSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemyAudioSubsystem, STATGROUP_Tickables);
+}
@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/EnemyMovementComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/PlayerController.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Movement Sweeps"), STAT_SlashEnemyMovementSweeps, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Floor Checks"), STAT_SlashEnemyFloorChecks, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemy Penetration Resolves"), STAT_SlashEnemyPenetrationResolves, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Enemies At Full Movement"), STAT_SlashEnemiesFullMovement, STATGROUP_Slash);
+
+static TAutoConsoleVariable<int32> CVarEnemyMovementLOD(
+	TEXT("slash.EnemyMovement.LOD"),
+	1,
+	TEXT("1 lets patrolling enemies drop to navmesh walking when far or offscreen, 0 keeps every enemy on full walking."));
+
+static uint64 TotalPenetrationResolves = 0;
+
+UEnemyMovementComponent::UEnemyMovementComponent()
+{
+	// Keeps nav walking on the navmesh surface and eases over its height changes
+	bProjectNavMeshWalking = true;
+}
+
+void UEnemyMovementComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	SLASH_HITCH_SCOPE(Movement);
+
+	// Simulated proxies follow the movement mode the server replicates
+	TimeSinceLODCheck += DeltaTime;
+	if (TimeSinceLODCheck >= LODCheckInterval && CharacterOwner && CharacterOwner->HasAuthority())
+	{
+		TimeSinceLODCheck = 0.f;
+		SetMovementLOD(ChooseMovementLOD());
+	}
+
+	const double CapsuleZ = UpdatedComponent ? UpdatedComponent->GetComponentLocation().Z : 0.0;
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (MovementLOD == EEnemyMovementLOD::EML_Full)
+	{
+		INC_DWORD_STAT(STAT_SlashEnemiesFullMovement);
+	}
+
+	// The first move in the new mode settles onto the real floor or the navmesh, hide that step
+	if (bModeSwitched && UpdatedComponent)
+	{
+		bModeSwitched = false;
+		const double Step = UpdatedComponent->GetComponentLocation().Z - CapsuleZ - Velocity.Z * DeltaTime;
+		MeshOffsetZ = FMath::Clamp(MeshOffsetZ - Step, -MaxStepHeight, MaxStepHeight);
+	}
+	UpdateMeshOffset(DeltaTime);
+}
+
+void UEnemyMovementComponent::FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult) const
+{
+	INC_DWORD_STAT(STAT_SlashEnemyFloorChecks);
+	Super::FindFloor(CapsuleLocation, OutFloorResult, bCanUseCachedLocation, DownwardSweepResult);
+}
+
+void UEnemyMovementComponent::SetReducedMovementAllowed(bool bAllowed)
+{
+	bReducedMovementAllowed = bAllowed;
+	if (!bAllowed)
+	{
+		SetMovementLOD(EEnemyMovementLOD::EML_Full);
+	}
+}
+
+bool UEnemyMovementComponent::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+{
+	if (bSweep && !Delta.IsNearlyZero())
+	{
+		INC_DWORD_STAT(STAT_SlashEnemyMovementSweeps);
+	}
+	return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+}
+
+bool UEnemyMovementComponent::ResolvePenetrationImpl(const FVector& Adjustment, const FHitResult& Hit, const FQuat& NewRotation)
+{
+	INC_DWORD_STAT(STAT_SlashEnemyPenetrationResolves);
+	++TotalPenetrationResolves;
+	return Super::ResolvePenetrationImpl(Adjustment, Hit, NewRotation);
+}
+
+uint64 UEnemyMovementComponent::GetTotalPenetrationResolves()
+{
+	return TotalPenetrationResolves;
+}
+
+EEnemyMovementLOD UEnemyMovementComponent::ChooseMovementLOD() const
+{
+	if (!bReducedMovementAllowed || CVarEnemyMovementLOD.GetValueOnGameThread() == 0 || CharacterOwner == nullptr) return EEnemyMovementLOD::EML_Full;
+
+	// Falling, flying and the rest of the special modes keep the full simulation
+	if (MovementMode != MOVE_Walking && MovementMode != MOVE_NavWalking) return EEnemyMovementLOD::EML_Full;
+
+	// Only a standalone game knows what was rendered, a server has to go by distance to every player
+	if (GetNetMode() == NM_Standalone && !CharacterOwner->WasRecentlyRendered(OffscreenTime)) return EEnemyMovementLOD::EML_Offscreen;
+
+	const FVector Location = GetActorLocation();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController == nullptr) continue;
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		if (FVector::DistSquared(ViewLocation, Location) <= FMath::Square(NavWalkingDistance))
+		{
+			return EEnemyMovementLOD::EML_Full;
+		}
+	}
+	return EEnemyMovementLOD::EML_NavWalking;
+}
+
+void UEnemyMovementComponent::SetMovementLOD(EEnemyMovementLOD NewLOD)
+{
+	if (NewLOD == MovementLOD) return;
+
+	const EMovementMode NewMode = NewLOD == EEnemyMovementLOD::EML_Full ? MOVE_Walking : MOVE_NavWalking;
+	// Switches right away on the ground, otherwise it's picked up on landing
+	bModeSwitched = IsMovingOnGround() && NewMode != MovementMode;
+	SetGroundMovementMode(NewMode);
+
+	// Nobody sees an offscreen enemy bump into things, so it skips the sweep and moves less often
+	bSweepWhileNavWalking = NewLOD != EEnemyMovementLOD::EML_Offscreen;
+	SetComponentTickInterval(NewLOD == EEnemyMovementLOD::EML_Offscreen ? OffscreenTickInterval : 0.f);
+
+	MovementLOD = NewLOD;
+}
+
+void UEnemyMovementComponent::UpdateMeshOffset(float DeltaTime)
+{
+	if (CharacterOwner == nullptr || CharacterOwner->GetMesh() == nullptr) return;
+	if (MeshOffsetZ == 0.f) return;
+
+	MeshOffsetZ = FMath::FInterpTo(MeshOffsetZ, 0.f, DeltaTime, MeshOffsetInterpSpeed);
+	if (FMath::Abs(MeshOffsetZ) < KINDA_SMALL_NUMBER)
+	{
+		MeshOffsetZ = 0.f;
+	}
+
+	USkeletalMeshComponent* Mesh = CharacterOwner->GetMesh();
+	FVector MeshLocation = Mesh->GetRelativeLocation();
+	MeshLocation.Z = CharacterOwner->GetBaseTranslationOffset().Z + MeshOffsetZ;
+	Mesh->SetRelativeLocation(MeshLocation);
+}
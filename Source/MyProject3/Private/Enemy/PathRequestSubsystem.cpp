@@ -0,0 +1,305 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/PathRequestSubsystem.h"
+#include "AIController.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Navigation/PathFollowingComponent.h"
+#include "NavigationSystem.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_CYCLE_STAT(TEXT("Path Requests Tick"), STAT_SlashPathRequestsTick, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Path Queue Depth"), STAT_SlashPathQueueDepth, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Paths In Flight"), STAT_SlashPathsInFlight, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Paths Dispatched"), STAT_SlashPathsDispatched, STATGROUP_Slash);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Latency Average (ms)"), STAT_SlashPathLatencyAverage, STATGROUP_Slash);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Path Latency Max (ms)"), STAT_SlashPathLatencyMax, STATGROUP_Slash);
+
+static TAutoConsoleVariable<float> CVarPathsBudgetMs(
+	TEXT("slash.Paths.BudgetMs"),
+	0.5f,
+	TEXT("Game thread time per frame spent sending path queries. At least one goes out every frame."));
+
+static TAutoConsoleVariable<int32> CVarPathsMaxInFlight(
+	TEXT("slash.Paths.MaxInFlight"),
+	16,
+	TEXT("Path queries allowed to be running at once, the rest wait in the queue."));
+
+static TAutoConsoleVariable<bool> CVarPathsAsync(
+	TEXT("slash.Paths.Async"),
+	true,
+	TEXT("0 sends every move straight to MoveTo like before, for comparing."));
+
+static FAutoConsoleCommandWithWorld PathsReportCommand(
+	TEXT("slash.Paths.Report"),
+	TEXT("Prints the path request queue depth, latency and totals."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UPathRequestSubsystem* PathRequests = World ? World->GetSubsystem<UPathRequestSubsystem>() : nullptr)
+		{
+			PathRequests->Report();
+		}
+	}));
+
+namespace
+{
+	// Location goals this close count as the same goal
+	constexpr double SameGoalDistance = 50.0;
+	// How quickly the average latency follows new samples
+	constexpr double LatencySmoothing = 0.1;
+}
+
+void UPathRequestSubsystem::Tick(float DeltaTime)
+{
+	SET_DWORD_STAT(STAT_SlashPathQueueDepth, Pending.Num());
+	SET_DWORD_STAT(STAT_SlashPathsInFlight, InFlight.Num());
+	if (Pending.Num() == 0) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SlashPathRequestsTick);
+	SLASH_HITCH_SCOPE(AI);
+
+	SortPending();
+
+	const double BudgetSeconds = CVarPathsBudgetMs.GetValueOnGameThread() / 1000.0;
+	const int32 MaxInFlight = FMath::Max(1, CVarPathsMaxInFlight.GetValueOnGameThread());
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumSent = 0;
+	while (NumSent < Pending.Num() && InFlight.Num() < MaxInFlight)
+	{
+		Dispatch(MoveTemp(Pending[NumSent]));
+		++NumSent;
+		if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds) break;
+	}
+	Pending.RemoveAt(0, NumSent, false);
+	INC_DWORD_STAT_BY(STAT_SlashPathsDispatched, NumSent);
+}
+
+void UPathRequestSubsystem::RequestMove(AAIController* Controller, const FAIMoveRequest& MoveRequest, EPathPriority Priority)
+{
+	if (Controller == nullptr) return;
+	++NumRequested;
+
+	if (!CVarPathsAsync.GetValueOnGameThread())
+	{
+		CancelMove(Controller);
+		Controller->MoveTo(MoveRequest);
+		return;
+	}
+
+	if (IsFollowingPathTo(Controller, MoveRequest))
+	{
+		++NumReused;
+		return;
+	}
+
+	for (FRequest& Request : Pending)
+	{
+		if (Request.Controller != Controller) continue;
+
+		if (IsSameGoal(Request.MoveRequest, MoveRequest))
+		{
+			++NumDeduped;
+			Request.Priority = FMath::Min(Request.Priority, Priority);
+		}
+		else
+		{
+			// Keeps its place in line, only what it wants changed
+			++NumReplaced;
+			Request.MoveRequest = MoveRequest;
+			Request.Priority = Priority;
+		}
+		return;
+	}
+
+	for (auto It = InFlight.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Controller != Controller) continue;
+
+		if (IsSameGoal(It.Value().MoveRequest, MoveRequest))
+		{
+			++NumDeduped;
+			return;
+		}
+		// Its answer is thrown away when it comes back
+		++NumReplaced;
+		It.RemoveCurrent();
+		break;
+	}
+
+	FRequest& Request = Pending.AddDefaulted_GetRef();
+	Request.Controller = Controller;
+	Request.MoveRequest = MoveRequest;
+	Request.Priority = Priority;
+	Request.RequestTime = FPlatformTime::Seconds();
+}
+
+void UPathRequestSubsystem::CancelMove(const AAIController* Controller)
+{
+	Pending.RemoveAll([Controller](const FRequest& Request) { return Request.Controller == Controller; });
+	for (auto It = InFlight.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Controller == Controller)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void UPathRequestSubsystem::Report() const
+{
+	UE_LOG(LogTemp, Display, TEXT("Paths: %d queued, %d in flight, latency %.1f ms average, %.1f ms max"),
+		Pending.Num(), InFlight.Num(), AverageLatencyMs, MaxLatencyMs);
+	UE_LOG(LogTemp, Display, TEXT("Paths: %llu requested, %llu dispatched, %llu reused a path, %llu deduped, %llu replaced, %llu failed, %llu stale"),
+		NumRequested, NumDispatched, NumReused, NumDeduped, NumReplaced, NumFailed, NumStale);
+}
+
+bool UPathRequestSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UPathRequestSubsystem::IsSameGoal(const FAIMoveRequest& A, const FAIMoveRequest& B)
+{
+	if (A.IsMoveToActorRequest() || B.IsMoveToActorRequest())
+	{
+		return A.IsMoveToActorRequest() && B.IsMoveToActorRequest() && A.GetGoalActor() == B.GetGoalActor();
+	}
+	return FVector::DistSquared(A.GetGoalLocation(), B.GetGoalLocation()) <= FMath::Square(SameGoalDistance);
+}
+
+bool UPathRequestSubsystem::IsFollowingPathTo(const AAIController* Controller, const FAIMoveRequest& MoveRequest) const
+{
+	const UPathFollowingComponent* PathFollowing = Controller->GetPathFollowingComponent();
+	if (PathFollowing == nullptr || PathFollowing->GetStatus() != EPathFollowingStatus::Moving) return false;
+
+	const FNavPathSharedPtr& Path = PathFollowing->GetPath();
+	if (!Path.IsValid() || !Path->IsValid() || Path->IsPartial()) return false;
+
+	// A path to an actor is kept up to date as the actor moves
+	if (MoveRequest.IsMoveToActorRequest())
+	{
+		return MoveRequest.GetGoalActor() && Path->GetGoalActor() == MoveRequest.GetGoalActor();
+	}
+	return Path->GetGoalActor() == nullptr
+		&& FVector::DistSquared(Path->GetEndLocation(), MoveRequest.GetGoalLocation()) <= FMath::Square(SameGoalDistance);
+}
+
+void UPathRequestSubsystem::Dispatch(FRequest&& Request)
+{
+	AAIController* Controller = Request.Controller.Get();
+	if (Controller == nullptr || Controller->GetPawn() == nullptr) return;
+
+	UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	FPathFindingQuery Query;
+	if (NavSys == nullptr || !Controller->BuildPathfindingQuery(Request.MoveRequest, Query))
+	{
+		MoveDirectly(Request);
+		return;
+	}
+
+	const uint32 QueryId = NavSys->FindPathAsync(Controller->GetNavAgentPropertiesRef(), Query,
+		FNavPathQueryDelegate::CreateUObject(this, &UPathRequestSubsystem::OnPathFound), EPathFindingMode::Regular);
+	if (QueryId == INVALID_NAVQUERYID)
+	{
+		MoveDirectly(Request);
+		return;
+	}
+
+	++NumDispatched;
+	InFlight.Add(QueryId, MoveTemp(Request));
+}
+
+void UPathRequestSubsystem::OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{
+	FRequest Request;
+	if (!InFlight.RemoveAndCopyValue(QueryId, Request))
+	{
+		// Replaced or cancelled while it was running
+		++NumStale;
+		return;
+	}
+	if (!Request.Controller.IsValid()) return;
+
+	NoteLatency(Request);
+	if (Result == ENavigationQueryResult::Success && Path.IsValid())
+	{
+		ApplyPath(Request, Path);
+	}
+	else
+	{
+		++NumFailed;
+	}
+}
+
+void UPathRequestSubsystem::ApplyPath(const FRequest& Request, FNavPathSharedPtr Path)
+{
+	AAIController* Controller = Request.Controller.Get();
+	if (Controller == nullptr || Controller->GetPawn() == nullptr) return;
+
+	// Same as MoveTo sets up for the paths it finds itself
+	if (Request.MoveRequest.IsMoveToActorRequest())
+	{
+		AActor* GoalActor = Request.MoveRequest.GetGoalActor();
+		if (GoalActor == nullptr) return;
+		Path->SetGoalActorObservation(*GoalActor, 100.f);
+	}
+	Path->EnableRecalculationOnInvalidation(true);
+	Controller->RequestMove(Request.MoveRequest, Path);
+}
+
+void UPathRequestSubsystem::MoveDirectly(const FRequest& Request)
+{
+	if (AAIController* Controller = Request.Controller.Get())
+	{
+		NoteLatency(Request);
+		Controller->MoveTo(Request.MoveRequest);
+	}
+}
+
+void UPathRequestSubsystem::NoteLatency(const FRequest& Request)
+{
+	const double LatencyMs = (FPlatformTime::Seconds() - Request.RequestTime) * 1000.0;
+	AverageLatencyMs = AverageLatencyMs > 0.0 ? FMath::Lerp(AverageLatencyMs, LatencyMs, LatencySmoothing) : LatencyMs;
+	MaxLatencyMs = FMath::Max(MaxLatencyMs, LatencyMs);
+	SET_FLOAT_STAT(STAT_SlashPathLatencyAverage, AverageLatencyMs);
+	SET_FLOAT_STAT(STAT_SlashPathLatencyMax, MaxLatencyMs);
+}
+
+void UPathRequestSubsystem::SortPending()
+{
+	TArray<FVector, TInlineAllocator<4>> PlayerLocations;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		if (const APawn* PlayerPawn = It->Get() ? It->Get()->GetPawn() : nullptr)
+		{
+			PlayerLocations.Add(PlayerPawn->GetActorLocation());
+		}
+	}
+
+	for (FRequest& Request : Pending)
+	{
+		const APawn* Pawn = Request.Controller.IsValid() ? Request.Controller->GetPawn() : nullptr;
+		double DistanceSquared = TNumericLimits<float>::Max();
+		if (Pawn)
+		{
+			for (const FVector& PlayerLocation : PlayerLocations)
+			{
+				DistanceSquared = FMath::Min(DistanceSquared, FVector::DistSquared(PlayerLocation, Pawn->GetActorLocation()));
+			}
+		}
+		Request.SortKey = DistanceSquared;
+	}
+
+	// Stable so requests at the same priority and distance keep the order they came in
+	Pending.StableSort([](const FRequest& A, const FRequest& B)
+	{
+		return A.Priority != B.Priority ? A.Priority < B.Priority : A.SortKey < B.SortKey;
+	});
+}
+
+TStatId UPathRequestSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPathRequestSubsystem, STATGROUP_Tickables);
+}
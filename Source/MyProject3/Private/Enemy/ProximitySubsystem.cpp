@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemy/ProximitySubsystem.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_CYCLE_STAT(TEXT("Proximity Tick"), STAT_SlashProximityTick, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Proximity Watches"), STAT_SlashProximityWatches, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Proximity Checks"), STAT_SlashProximityChecks, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Proximity Crossings"), STAT_SlashProximityCrossings, STATGROUP_Slash);
+
+static TAutoConsoleVariable<float> CVarProximityHysteresis(
+	TEXT("slash.Proximity.Hysteresis"),
+	25.f,
+	TEXT("How much further than a band's radius the target has to go before it counts as leaving."));
+
+static TAutoConsoleVariable<float> CVarProximityMaxClosingSpeed(
+	TEXT("slash.Proximity.MaxClosingSpeed"),
+	1500.f,
+	TEXT("Fastest two actors are expected to close or open the distance between them, sets how long a watch can sleep."));
+
+static TAutoConsoleVariable<float> CVarProximityMaxInterval(
+	TEXT("slash.Proximity.MaxInterval"),
+	0.5f,
+	TEXT("Longest a watch sleeps, in case something teleports or moves faster than MaxClosingSpeed."));
+
+void UProximitySubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlashProximityTick);
+	SLASH_HITCH_SCOPE(AI);
+	SET_DWORD_STAT(STAT_SlashProximityWatches, Watches.Num());
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	TArray<FCrossing> Crossings;
+	// Pushed after the pass, a watch right on an edge must not come up again this frame
+	TArray<const FWatch*, TInlineAllocator<16>> Checked;
+
+	while (Scheduled.Num() > 0 && Scheduled.HeapTop().Time <= Now)
+	{
+		FScheduled Due;
+		Scheduled.HeapPop(Due, /*bAllowShrinking*/ false);
+
+		FWatch* Found = Watches.Find(Due.Watcher);
+		if (Found == nullptr || Found->Serial != Due.Serial || Found->NextCheckTime != Due.Time) continue;
+		FWatch& Entry = *Found;
+		if (!Entry.Watcher.IsValid())
+		{
+			Watches.Remove(Due.Watcher);
+			continue;
+		}
+		INC_DWORD_STAT(STAT_SlashProximityChecks);
+
+		const AActor* Target = Entry.Target.Get();
+		const double Distance = Target
+			? FVector::Dist(Target->GetActorLocation(), Entry.Watcher->GetActorLocation())
+			: TNumericLimits<double>::Max();
+		UpdateBand(Entry, Distance, Crossings);
+
+		// Nothing left to cross once the target is gone
+		if (Target == nullptr)
+		{
+			Entry.NextCheckTime = TNumericLimits<double>::Max();
+			continue;
+		}
+		Entry.NextCheckTime = Now + GetRecheckDelay(Entry, Distance);
+		Checked.Add(&Entry);
+	}
+	for (const FWatch* Entry : Checked)
+	{
+		Schedule(*Entry);
+	}
+
+	// Callbacks can set up or drop watches, so they run after the pass
+	INC_DWORD_STAT_BY(STAT_SlashProximityCrossings, Crossings.Num());
+	for (const FCrossing& Crossing : Crossings)
+	{
+		const FWatch* Entry = Watches.Find(Crossing.Watcher);
+		if (Entry && Entry->Serial == Crossing.Serial)
+		{
+			// Copied since the callback may replace the watch it came from
+			const FOnProximityCrossed OnCrossed = Entry->OnCrossed;
+			OnCrossed.ExecuteIfBound(Crossing.Band, Crossing.bEntered);
+		}
+	}
+}
+
+int32 UProximitySubsystem::Watch(AActor* Watcher, AActor* Target, TArrayView<const float> Radii, FOnProximityCrossed OnCrossed)
+{
+	if (Watcher == nullptr) return 0;
+
+	FWatch& Entry = Watches.Add(Watcher);
+	Entry.Watcher = Watcher;
+	Entry.Target = Target;
+	Entry.Radii.Append(Radii.GetData(), Radii.Num());
+	Entry.OnCrossed = MoveTemp(OnCrossed);
+	Entry.Serial = ++NextSerial;
+
+	// Starts in the band it is actually in, hysteresis only applies from here on
+	const double Distance = Target ? FVector::Dist(Target->GetActorLocation(), Watcher->GetActorLocation()) : TNumericLimits<double>::Max();
+	Entry.Band = Radii.Num();
+	while (Entry.Band > 0 && Distance <= Radii[Entry.Band - 1])
+	{
+		--Entry.Band;
+	}
+	Entry.NextCheckTime = Target ? GetWorld()->GetTimeSeconds() + GetRecheckDelay(Entry, Distance) : TNumericLimits<double>::Max();
+	if (Target)
+	{
+		Schedule(Entry);
+	}
+	return Entry.Band;
+}
+
+void UProximitySubsystem::Unwatch(const AActor* Watcher)
+{
+	Watches.Remove(Watcher);
+}
+
+bool UProximitySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProximitySubsystem::Schedule(const FWatch& Entry)
+{
+	Scheduled.HeapPush({ Entry.NextCheckTime, TObjectKey<AActor>(Entry.Watcher.Get()), Entry.Serial });
+}
+
+void UProximitySubsystem::UpdateBand(FWatch& Entry, double Distance, TArray<FCrossing>& OutCrossings) const
+{
+	const float Hysteresis = CVarProximityHysteresis.GetValueOnGameThread();
+	const TObjectKey<AActor> WatcherKey(Entry.Watcher.Get());
+
+	while (Entry.Band > 0 && Distance <= Entry.Radii[Entry.Band - 1])
+	{
+		--Entry.Band;
+		OutCrossings.Add({ WatcherKey, Entry.Serial, Entry.Band, true });
+	}
+	while (Entry.Band < Entry.Radii.Num() && Distance > Entry.Radii[Entry.Band] + Hysteresis)
+	{
+		OutCrossings.Add({ WatcherKey, Entry.Serial, Entry.Band, false });
+		++Entry.Band;
+	}
+}
+
+double UProximitySubsystem::GetRecheckDelay(const FWatch& Entry, double Distance) const
+{
+	// Distance to whichever boundary is closest, going in or out
+	double Margin = TNumericLimits<double>::Max();
+	if (Entry.Band > 0)
+	{
+		Margin = Distance - Entry.Radii[Entry.Band - 1];
+	}
+	if (Entry.Band < Entry.Radii.Num())
+	{
+		Margin = FMath::Min(Margin, Entry.Radii[Entry.Band] + CVarProximityHysteresis.GetValueOnGameThread() - Distance);
+	}
+
+	const double MaxClosingSpeed = FMath::Max(1.f, CVarProximityMaxClosingSpeed.GetValueOnGameThread());
+	return FMath::Clamp(Margin / MaxClosingSpeed, 0.0, static_cast<double>(CVarProximityMaxInterval.GetValueOnGameThread()));
+}
+
+TStatId UProximitySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProximitySubsystem, STATGROUP_Tickables);
+}
@@ -4,10 +4,17 @@
 #include "HUD/HealthBarComponent.h"
 #include "HUD/HealthBar.h"
 #include "Components/ProgressBar.h"
+#include "MyProject3/MyProject3.h"
+
+void UHealthBarComponent::InitWidget()
+{
+	// Every enemy creates its own health bar widget
+	LLM_SCOPE_BYTAG(Slash_HUD);
+	Super::InitWidget();
+}
 
 void UHealthBarComponent::SetHealthPercent(float Percent)
 {
-	UE_LOG(LogTemp, Warning, TEXT("SetHealthPercent"));
 	if (HealthBarWidget == nullptr)
 	{
 		HealthBarWidget = Cast<UHealthBar>(GetUserWidgetObject());
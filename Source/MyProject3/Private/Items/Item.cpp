@@ -3,15 +3,23 @@
 
 #include "Items/Item.h"
 #include "MyProject3/DebugMacros.h"
+#include "MyProject3/MyProject3.h"
 #include "Components/SphereComponent.h"
+#include "Components/PersistentStateComponent.h"
 #include "Characters/SlashCharacter.h"
 #include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
 
 // Sets default values
 AItem::AItem()
 {
+	LLM_SCOPE_BYTAG(Slash_Items);
 	PrimaryActorTick.bCanEverTick = true;
 
+	// Items only replicate when picked up or spawned, lying around they stay dormant
+	bReplicates = true;
+	NetDormancy = ENetDormancy::DORM_Initial;
+
 	ItemMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("ItemMeshComponent"));
 	ItemMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
 	ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -22,17 +30,47 @@ AItem::AItem()
 
 	EmbersEffect = CreateDefaultSubobject<UNiagaraComponent>(TEXT("Embers"));
 	EmbersEffect->SetupAttachment(GetRootComponent());
+
+	PersistentState = CreateDefaultSubobject<UPersistentStateComponent>(TEXT("PersistentState"));
 }
 
 void AItem::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Slash_Items);
 	Super::BeginPlay();
 
+	// Picked up before this cell streamed out
+	FPersistentActorState State;
+	if (HasAuthority() && PersistentState && PersistentState->LoadState(State) && State.HasFlag(EPersistentStateFlags::Collected))
+	{
+		Destroy();
+		return;
+	}
+
 	Sphere->OnComponentBeginOverlap.AddDynamic(this, &AItem::OnSphereOverlap);
 	Sphere->OnComponentEndOverlap.AddDynamic(this, &AItem::OnSphereEndOverlap); 
 	// pee
 }
 
+FPrimaryAssetId AItem::GetPrimaryAssetId() const
+{
+	// Only blueprint class defaults stand for an asset, placed and spawned items don't
+	const FPrimaryAssetType AssetType = GetItemAssetType();
+	if (AssetType.IsValid() && HasAnyFlags(RF_ClassDefaultObject) && !GetClass()->HasAnyClassFlags(CLASS_Native))
+	{
+		return FPrimaryAssetId(AssetType, FPackageName::GetShortFName(GetClass()->GetPackage()->GetFName()));
+	}
+	return Super::GetPrimaryAssetId();
+}
+
+void AItem::GetPrewarmAssets(TArray<UObject*>& OutAssets) const
+{
+	if (EmbersEffect)
+	{
+		OutAssets.Add(EmbersEffect->GetAsset());
+	}
+}
+
 float AItem::TransformedSin()
 {
 	return Amplitude * FMath::Sin(RunningTime * TimeConstant);
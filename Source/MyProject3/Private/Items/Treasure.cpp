@@ -2,7 +2,16 @@
 
 #include "Items/Treasure.h"
 #include "Characters/SlashCharacter.h"
+#include "Components/PersistentStateComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Loading/LevelPrewarmSubsystem.h"
+#include "Sound/SoundBase.h"
+
+void ATreasure::GetPrewarmAssets(TArray<UObject*>& OutAssets) const
+{
+	Super::GetPrewarmAssets(OutAssets);
+	OutAssets.Add(PickupSound);
+}
 
 void ATreasure::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
@@ -11,12 +20,23 @@ void ATreasure::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor
 	{
 		if (PickupSound)
 		{
+			ULevelPrewarmSubsystem::NoteAssetUse(this, PickupSound);
 			UGameplayStatics::PlaySoundAtLocation(
 				this,
 				PickupSound,
 				GetActorLocation()
 			);
 		}
+		// Clients play the sound right away, the server hands out the pickup
+		if (!HasAuthority()) return;
+
+		if (PersistentState)
+		{
+			FPersistentActorState State = PersistentState->GetState();
+			State.Flags |= EPersistentStateFlags::Collected;
+			PersistentState->SaveState(State);
+		}
+		SlashCharacter->AddGold(Gold);
 		Destroy();
 		SlashCharacter->SetOverlappingItem(this);
 	}
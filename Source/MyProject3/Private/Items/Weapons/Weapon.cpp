@@ -8,10 +8,17 @@
 #include "Components/SphereComponent.h"
 #include "Components/BoxComponent.h"
 #include "Interfaces/HitInterface.h"
+#include "Breakable/FieldEmitterSubsystem.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
 #include "NiagaraComponent.h"
+#include "Loading/LevelPrewarmSubsystem.h"
+#include "Net/LagCompensationSubsystem.h"
+#include "Sound/SoundBase.h"
+#include "MyProject3/MyProject3.h"
 
 AWeapon::AWeapon()
 {
+	LLM_SCOPE_BYTAG(Slash_Weapons);
 	WeaponBox = CreateDefaultSubobject<UBoxComponent>(TEXT("Weapon Box"));
 	WeaponBox->SetupAttachment(GetRootComponent());
 	WeaponBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -22,21 +29,39 @@ AWeapon::AWeapon()
 	BoxTraceStart->SetupAttachment(GetRootComponent());
 	BoxTraceEnd = CreateDefaultSubobject<USceneComponent>(TEXT("Box Trace End"));
 	BoxTraceEnd->SetupAttachment(GetRootComponent());
+
+#if WITH_EDITORONLY_DATA
+	// Always loaded, a weapon the player picked up must not stream out with the cell it was placed in
+	bIsSpatiallyLoaded = false;
+#endif
+}
+
+void AWeapon::GetPrewarmAssets(TArray<UObject*>& OutAssets) const
+{
+	Super::GetPrewarmAssets(OutAssets);
+	OutAssets.Add(EquipSound);
 }
 
 void AWeapon::BeginPlay()
 {
+	LLM_SCOPE_BYTAG(Slash_Weapons);
 	Super::BeginPlay();
 	WeaponBox->OnComponentBeginOverlap.AddDynamic(this, &AWeapon::OnBoxOverlap);
 }
 
 void AWeapon::Equip(USceneComponent* InParent, FName InSocketName, AActor* NewOwner, APawn* NewInstigator)
 {
+	LLM_SCOPE_BYTAG(Slash_Weapons);
 	FVector test = this->GetActorScale3D();
 	// for actor
 	SetOwner(NewOwner);
 	// for pawn which is more specific
 	SetInstigator(NewInstigator);
+	// Held weapons send the field multicasts, they can't sit dormant like the ones lying around
+	if (HasAuthority())
+	{
+		SetNetDormancy(ENetDormancy::DORM_Awake);
+	}
 	AttachMeshToSocket(InParent, InSocketName);
 	ItemState = EItemState::EIS_Equipped;
 	DisableSphereCollision();
@@ -64,6 +89,7 @@ void AWeapon::PlayEquipSound(AActor* NewOwner)
 {
 	if (EquipSound && NewOwner->ActorHasTag(FName("Player")))
 	{
+		ULevelPrewarmSubsystem::NoteAssetUse(this, EquipSound);
 		UGameplayStatics::PlaySoundAtLocation(
 			this,
 			EquipSound,
@@ -82,6 +108,17 @@ void AWeapon::AttachMeshToSocket(USceneComponent* InParent, const FName& InSocke
 
 void AWeapon::OnBoxOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	SLASH_HITCH_SCOPE(Melee);
+
+	// The server traces AI and its own players, remote players trace on their client and ask the server to confirm
+	const APawn* Wielder = GetInstigator();
+	const bool bRemotePlayerSwing = Wielder && Wielder->IsPlayerControlled() && !Wielder->IsLocallyControlled();
+	const bool bTracedHere = HasAuthority() ? !bRemotePlayerSwing : Wielder && Wielder->IsLocallyControlled();
+	if (!bTracedHere)
+	{
+		return;
+	}
+
 	if (ActorIsSameType(OtherActor))
 	{
 		return;
@@ -97,31 +134,93 @@ void AWeapon::OnBoxOverlap(UPrimitiveComponent* OverlappedComponent, AActor* Oth
 			return;
 		}
 
-		UGameplayStatics::ApplyDamage(
-			BoxHit.GetActor(),
-			Handedness == EWeaponHanded::EWH_TwoHanded ? Damage * 2.f : Damage,
-			GetInstigator()->GetController(),
-			this,
-			UDamageType::StaticClass() // we just use the standard class for damage in ue5
-		);
-
-		ExecuteGetHit(BoxHit);
-		CreateFields(BoxHit.ImpactPoint);
+		if (HasAuthority())
+		{
+			ApplyHit(BoxHit.GetActor(), BoxHit.ImpactPoint);
+		}
+		else
+		{
+			ServerConfirmHit(BoxHit.GetActor(), BoxTraceStart->GetComponentLocation(), BoxTraceEnd->GetComponentLocation(), ULagCompensationSubsystem::GetClientViewTime(GetWorld()));
+		}
 	};
 }
 
+void AWeapon::ApplyHit(AActor* HitActor, const FVector& ImpactPoint)
+{
+	UGameplayStatics::ApplyDamage(
+		HitActor,
+		Handedness == EWeaponHanded::EWH_TwoHanded ? Damage * 2.f : Damage,
+		GetInstigator()->GetController(),
+		this,
+		UDamageType::StaticClass() // we just use the standard class for damage in ue5
+	);
+
+	ExecuteGetHit(HitActor, ImpactPoint);
+	MulticastCreateFields(ImpactPoint);
+}
+
+void AWeapon::ServerConfirmHit_Implementation(AActor* HitActor, FVector_NetQuantize TraceStart, FVector_NetQuantize TraceEnd, double ClientTime)
+{
+	const APawn* Wielder = GetInstigator();
+	if (HitActor == nullptr || Wielder == nullptr || IgnoreActors.Contains(HitActor) || ActorIsSameType(HitActor)) return;
+
+	// The wielder has to be mid swing here too, the montage turns the box on on every machine
+	if (WeaponBox == nullptr || WeaponBox->GetCollisionEnabled() == ECollisionEnabled::NoCollision) return;
+
+	// The swing has to come from about where we have the wielder, a blade is never that far from its hand
+	if (FVector::DistSquared(TraceStart, Wielder->GetActorLocation()) > FMath::Square(MaxSwingReach)) return;
+
+	// And be no longer than the blade, or a client could sweep a line through anything in front of it
+	const double TraceLength = FVector::Dist(BoxTraceStart->GetComponentLocation(), BoxTraceEnd->GetComponentLocation());
+	if (FVector::DistSquared(TraceStart, TraceEnd) > FMath::Square(TraceLength + TraceLengthTolerance)) return;
+
+	ULagCompensationSubsystem* LagComp = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+	const ACharacter* TargetCharacter = Cast<ACharacter>(HitActor);
+	FVector ImpactPoint;
+	if (LagComp && LagComp->IsTracked(TargetCharacter))
+	{
+		if (!LagComp->ConfirmHit(TargetCharacter, ClientTime, TraceStart, TraceEnd, BoxTraceExtent.GetMax(), ImpactPoint)) return;
+	}
+	else
+	{
+		// Pots and the like don't move, the current world is what the client saw
+		FHitResult BoxHit;
+		TArray<AActor*> ActorsToIgnore = { this };
+		UKismetSystemLibrary::BoxTraceSingle(this, TraceStart, TraceEnd, BoxTraceExtent, BoxTraceStart->GetComponentRotation(),
+			ETraceTypeQuery::TraceTypeQuery1, false, ActorsToIgnore, EDrawDebugTrace::None, BoxHit, true);
+		if (BoxHit.GetActor() != HitActor) return;
+		ImpactPoint = BoxHit.ImpactPoint;
+	}
+
+	IgnoreActors.AddUnique(HitActor);
+	ApplyHit(HitActor, ImpactPoint);
+}
+
 bool AWeapon::ActorIsSameType(AActor* OtherActor)
 {
 	return GetOwner()->ActorHasTag(TEXT("Enemy")) && OtherActor->ActorHasTag(TEXT("Enemy"));
 }
 
-void AWeapon::ExecuteGetHit(FHitResult& BoxHit)
+void AWeapon::ExecuteGetHit(AActor* HitActor, const FVector& ImpactPoint)
 {
-	IHitInterface* HitInterface = Cast<IHitInterface>(BoxHit.GetActor());
+	IHitInterface* HitInterface = Cast<IHitInterface>(HitActor);
 	if (HitInterface)
 	{
 		// The execute_ prefix is there because its a blueprint native event in hitinterface.h
-		HitInterface->Execute_GetHit(BoxHit.GetActor(), BoxHit.ImpactPoint, GetOwner());
+		HitInterface->Execute_GetHit(HitActor, ImpactPoint, GetOwner());
+	}
+}
+
+void AWeapon::MulticastCreateFields_Implementation(FVector_NetQuantize FieldLocation)
+{
+	UFieldEmitterSubsystem* FieldEmitter = GetWorld()->GetSubsystem<UFieldEmitterSubsystem>();
+	if (FieldEmitter && UFieldEmitterSubsystem::IsEnabled())
+	{
+		FieldEmitter->QueueImpact(FieldLocation);
+	}
+	else
+	{
+		CreateFields(FieldLocation);
 	}
 }
 
@@ -134,7 +233,7 @@ void AWeapon::BoxTrace(FHitResult& BoxHit)
 	ActorsToIgnore.Add(this);
 	for (AActor* Actor : IgnoreActors)
 	{
-		ActorsToIgnore.AddUnique(Actor);
+		if (Actor) ActorsToIgnore.AddUnique(Actor);
 	}
 
 	UKismetSystemLibrary::BoxTraceSingle(this,
@@ -148,5 +247,9 @@ void AWeapon::BoxTrace(FHitResult& BoxHit)
 		showBoxDebug ? EDrawDebugTrace::ForDuration : EDrawDebugTrace::None,
 		BoxHit,
 		true);
-	IgnoreActors.AddUnique(BoxHit.GetActor());
+	// A swing through thin air would add a null every frame the box is on
+	if (BoxHit.GetActor())
+	{
+		IgnoreActors.AddUnique(BoxHit.GetActor());
+	}
 }
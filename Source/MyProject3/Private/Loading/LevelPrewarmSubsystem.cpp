@@ -0,0 +1,266 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Loading/LevelPrewarmSubsystem.h"
+#include "Interfaces/PreloadInterface.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimNotifies/AnimNotify_PlayParticleEffect.h"
+#include "Animation/AnimNotifies/AnimNotify_PlaySound.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "NiagaraComponentPool.h"
+#include "NiagaraSystem.h"
+#include "NiagaraWorldManager.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Sound/SoundBase.h"
+
+static TAutoConsoleVariable<int32> CVarParticlePoolSize(
+	TEXT("slash.Prewarm.ParticlePoolSize"),
+	4,
+	TEXT("Pooled components created for each cascade particle system in the prewarm manifest."));
+
+static FAutoConsoleCommandWithWorld DumpPrewarmCommand(
+	TEXT("slash.Prewarm.Dump"),
+	TEXT("Prints the prewarm manifest built for the current map."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (ULevelPrewarmSubsystem* Prewarm = World ? World->GetSubsystem<ULevelPrewarmSubsystem>() : nullptr)
+		{
+			Prewarm->DumpManifest();
+		}
+	}));
+
+void ULevelPrewarmSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (ULevel* Level : InWorld.GetLevels())
+	{
+		GatherFromLevel(Level);
+	}
+	PrimePending();
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &ULevelPrewarmSubsystem::OnLevelAdded);
+
+	// The loading screen goes away after this frame, from then on a first use is a hitch
+	InWorld.GetTimerManager().SetTimerForNextTick(FTimerDelegate::CreateWeakLambda(this, [this]()
+	{
+		bGameStarted = true;
+	}));
+}
+
+void ULevelPrewarmSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	for (const TSharedPtr<FStreamableHandle>& Handle : SoftAssetHandles)
+	{
+		if (Handle.IsValid()) Handle->CancelHandle();
+	}
+	SoftAssetHandles.Empty();
+
+	Super::Deinitialize();
+}
+
+bool ULevelPrewarmSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void ULevelPrewarmSubsystem::NoteAssetUse(const UObject* WorldContextObject, const UObject* Asset)
+{
+#if !UE_BUILD_SHIPPING
+	if (WorldContextObject == nullptr || Asset == nullptr) return;
+
+	UWorld* World = WorldContextObject->GetWorld();
+	ULevelPrewarmSubsystem* Prewarm = World ? World->GetSubsystem<ULevelPrewarmSubsystem>() : nullptr;
+	if (Prewarm == nullptr || !Prewarm->bGameStarted || Prewarm->KnownAssets.Contains(FObjectKey(Asset))) return;
+
+	bool bAlreadyReported = false;
+	Prewarm->ReportedLateAssets.Add(FObjectKey(Asset), &bAlreadyReported);
+	if (!bAlreadyReported)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Prewarm: %s was first used by %s after the game started"), *GetNameSafe(Asset), *GetNameSafe(WorldContextObject));
+	}
+#endif
+}
+
+void ULevelPrewarmSubsystem::DumpManifest() const
+{
+	UE_LOG(LogTemp, Display, TEXT("Prewarm manifest for %s: %d montages, %d sounds, %d particle systems, %d niagara systems"),
+		*GetWorld()->GetMapName(), Manifest.Montages.Num(), Manifest.Sounds.Num(), Manifest.Particles.Num(), Manifest.NiagaraSystems.Num());
+
+	auto DumpAssets = [](const auto& Assets)
+	{
+		for (const UObject* Asset : Assets)
+		{
+			UE_LOG(LogTemp, Display, TEXT("  %s"), *GetPathNameSafe(Asset));
+		}
+	};
+	DumpAssets(Manifest.Montages);
+	DumpAssets(Manifest.Sounds);
+	DumpAssets(Manifest.Particles);
+	DumpAssets(Manifest.NiagaraSystems);
+}
+
+void ULevelPrewarmSubsystem::GatherFromLevel(ULevel* Level)
+{
+	if (Level == nullptr) return;
+
+	TArray<FSoftObjectPath> SoftAssets;
+	for (AActor* Actor : Level->Actors)
+	{
+		GatherFromObject(Actor, SoftAssets);
+	}
+	SoftAssets.RemoveAll([](const FSoftObjectPath& Path) { return Path.IsNull(); });
+	if (SoftAssets.Num() == 0) return;
+
+	// Classes spawned later (weapons, treasure) are loading in the background already, prime what they use once they are in
+	TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		SoftAssets,
+		FStreamableDelegate::CreateUObject(this, &ULevelPrewarmSubsystem::OnSoftAssetsLoaded, SoftAssets));
+	if (Handle.IsValid())
+	{
+		SoftAssetHandles.Add(Handle);
+	}
+}
+
+void ULevelPrewarmSubsystem::GatherFromObject(const UObject* Object, TArray<FSoftObjectPath>& OutSoftAssets)
+{
+	if (const IPreloadInterface* Preloadable = Cast<IPreloadInterface>(Object))
+	{
+		TArray<UObject*> Assets;
+		Preloadable->GetPrewarmAssets(Assets);
+		for (UObject* Asset : Assets)
+		{
+			AddAsset(Asset);
+		}
+		Preloadable->GetPreloadAssets(OutSoftAssets);
+	}
+}
+
+void ULevelPrewarmSubsystem::AddAsset(UObject* Asset)
+{
+	if (Asset == nullptr || KnownAssets.Contains(FObjectKey(Asset))) return;
+	KnownAssets.Add(FObjectKey(Asset));
+
+	if (UAnimMontage* Montage = Cast<UAnimMontage>(Asset))
+	{
+		Manifest.Montages.Add(Montage);
+		AddMontage(Montage);
+	}
+	else if (USoundBase* Sound = Cast<USoundBase>(Asset))
+	{
+		Manifest.Sounds.Add(Sound);
+		PendingPrime.Add(Sound);
+	}
+	else if (UParticleSystem* Particles = Cast<UParticleSystem>(Asset))
+	{
+		Manifest.Particles.Add(Particles);
+		PendingPrime.Add(Particles);
+	}
+	else if (UNiagaraSystem* NiagaraSystem = Cast<UNiagaraSystem>(Asset))
+	{
+		Manifest.NiagaraSystems.Add(NiagaraSystem);
+		PendingPrime.Add(NiagaraSystem);
+	}
+}
+
+void ULevelPrewarmSubsystem::AddMontage(UAnimMontage* Montage)
+{
+	// Montages are loaded with whoever references them, what hitches is the sounds and effects their notifies fire
+	auto AddNotifyAssets = [this](const UAnimSequenceBase* Animation)
+	{
+		for (const FAnimNotifyEvent& NotifyEvent : Animation->Notifies)
+		{
+			if (const UAnimNotify_PlaySound* SoundNotify = Cast<UAnimNotify_PlaySound>(NotifyEvent.Notify))
+			{
+				AddAsset(SoundNotify->Sound);
+			}
+			else if (const UAnimNotify_PlayParticleEffect* ParticleNotify = Cast<UAnimNotify_PlayParticleEffect>(NotifyEvent.Notify))
+			{
+				AddAsset(ParticleNotify->PSTemplate);
+			}
+		}
+	};
+
+	AddNotifyAssets(Montage);
+	for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+	{
+		for (const FAnimSegment& Segment : SlotTrack.AnimTrack.AnimSegments)
+		{
+			if (const UAnimSequenceBase* Animation = Segment.GetAnimReference())
+			{
+				AddNotifyAssets(Animation);
+			}
+		}
+	}
+}
+
+void ULevelPrewarmSubsystem::PrimePending()
+{
+	UWorld* World = GetWorld();
+	const int32 ParticlePoolSize = FMath::Max(0, CVarParticlePoolSize.GetValueOnGameThread());
+	TArray<UParticleSystemComponent*> PooledComponents;
+
+	for (UObject* Asset : PendingPrime)
+	{
+		if (USoundBase* Sound = Cast<USoundBase>(Asset))
+		{
+			UGameplayStatics::PrimeSound(Sound);
+		}
+		else if (UParticleSystem* Particles = Cast<UParticleSystem>(Asset))
+		{
+			// Create them all before releasing any, otherwise the pool hands back the same one
+			PooledComponents.Reset();
+			for (int32 Index = 0; Index < ParticlePoolSize; ++Index)
+			{
+				PooledComponents.Add(UGameplayStatics::SpawnEmitterAtLocation(World, Particles, FVector::ZeroVector, FRotator::ZeroRotator, FVector(1.f), false, EPSCPoolMethod::ManualRelease, false));
+			}
+			for (UParticleSystemComponent* Component : PooledComponents)
+			{
+				if (Component) Component->ReleaseToPool();
+			}
+		}
+		else if (UNiagaraSystem* NiagaraSystem = Cast<UNiagaraSystem>(Asset))
+		{
+			if (FNiagaraWorldManager* WorldManager = FNiagaraWorldManager::Get(World))
+			{
+				WorldManager->GetComponentPool()->PrimePool(NiagaraSystem, World);
+			}
+		}
+	}
+	PendingPrime.Reset();
+}
+
+void ULevelPrewarmSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		GatherFromLevel(Level);
+		PrimePending();
+	}
+}
+
+void ULevelPrewarmSubsystem::OnSoftAssetsLoaded(TArray<FSoftObjectPath> Paths)
+{
+	SoftAssetHandles.RemoveAll([](const TSharedPtr<FStreamableHandle>& Handle) { return !Handle.IsValid() || Handle->HasLoadCompleted(); });
+
+	// Soft references held by these classes are loaded by whoever spawns from them, not prewarmed here
+	TArray<FSoftObjectPath> NestedSoftAssets;
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		UObject* Loaded = Path.ResolveObject();
+		if (const UClass* LoadedClass = Cast<UClass>(Loaded))
+		{
+			GatherFromObject(LoadedClass->GetDefaultObject(), NestedSoftAssets);
+		}
+		else
+		{
+			AddAsset(Loaded);
+		}
+	}
+	PrimePending();
+}
@@ -0,0 +1,328 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/LagCompensationSubsystem.h"
+#include "Characters/SlashCharacter.h"
+#include "Components/CapsuleComponent.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Comp Record"), STAT_SlashLagCompRecord, STATGROUP_Slash);
+DECLARE_CYCLE_STAT(TEXT("Lag Comp Confirm"), STAT_SlashLagCompConfirm, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lag Comp Tracked Characters"), STAT_SlashLagCompTracked, STATGROUP_Slash);
+DECLARE_MEMORY_STAT(TEXT("Lag Comp History"), STAT_SlashLagCompMemory, STATGROUP_Slash);
+
+static TAutoConsoleVariable<float> CVarLagCompMaxRewind(
+	TEXT("slash.LagComp.MaxRewind"),
+	0.4f,
+	TEXT("Furthest back in seconds a client hit can be rewound. Read when the world starts."));
+
+static TAutoConsoleVariable<float> CVarLagCompSampleRate(
+	TEXT("slash.LagComp.SampleRate"),
+	30.f,
+	TEXT("Hitbox snapshots recorded per second. Read when the world starts."));
+
+static TAutoConsoleVariable<int32> CVarLagCompBytesPerCharacter(
+	TEXT("slash.LagComp.BytesPerCharacter"),
+	512,
+	TEXT("Memory budget for one character's hitbox history, caps the history length."));
+
+static TAutoConsoleVariable<float> CVarLagCompMicrosPerCharacter(
+	TEXT("slash.LagComp.MicrosPerCharacter"),
+	2.f,
+	TEXT("CPU budget in microseconds to record one character's snapshot, going over it logs a warning."));
+
+static TAutoConsoleVariable<float> CVarLagCompTolerance(
+	TEXT("slash.LagComp.Tolerance"),
+	15.f,
+	TEXT("Extra distance a rewound hit may miss the capsule by and still count, covers quantization and interpolation."));
+
+static TAutoConsoleVariable<float> CVarLagCompProbeInterval(
+	TEXT("slash.LagComp.ProbeInterval"),
+	0.f,
+	TEXT("On a client, seconds between probes sending where it sees every other character to the server. 0 is off."));
+
+static FAutoConsoleCommandWithWorld DumpLagCompCommand(
+	TEXT("slash.LagComp.Dump"),
+	TEXT("Prints the lag compensation budgets and hit results."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (ULagCompensationSubsystem* LagComp = World ? World->GetSubsystem<ULagCompensationSubsystem>() : nullptr)
+		{
+			LagComp->Dump();
+		}
+	}));
+
+void ULagCompensationSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	const float MaxRewind = FMath::Max(0.f, CVarLagCompMaxRewind.GetValueOnGameThread());
+	const float SampleRate = FMath::Max(1.f, CVarLagCompSampleRate.GetValueOnGameThread());
+	const int32 BudgetFrames = CVarLagCompBytesPerCharacter.GetValueOnGameThread() / (int32)sizeof(FHitboxSnapshot);
+
+	// Two extra frames so a rewind to the very edge of the window still has a pair to interpolate
+	HistoryLength = FMath::Max(2, FMath::Min(FMath::CeilToInt(MaxRewind * SampleRate) + 2, BudgetFrames));
+	FrameTimes.SetNumZeroed(HistoryLength);
+}
+
+void ULagCompensationSubsystem::Deinitialize()
+{
+	if (NumConfirmed + NumRejected + NumProbes > 0)
+	{
+		Dump();
+	}
+	DEC_MEMORY_STAT_BY(STAT_SlashLagCompMemory, Snapshots.GetAllocatedSize());
+	Super::Deinitialize();
+}
+
+void ULagCompensationSubsystem::Tick(float DeltaTime)
+{
+	SLASH_HITCH_SCOPE(LagComp);
+	Super::Tick(DeltaTime);
+
+	if (IsServer())
+	{
+		TimeSinceSample += DeltaTime;
+		if (TimeSinceSample >= 1.f / FMath::Max(1.f, CVarLagCompSampleRate.GetValueOnGameThread()))
+		{
+			TimeSinceSample = 0.f;
+			RecordFrame();
+		}
+	}
+	else if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		const float ProbeInterval = CVarLagCompProbeInterval.GetValueOnGameThread();
+		TimeSinceProbe += DeltaTime;
+		if (ProbeInterval > 0.f && TimeSinceProbe >= ProbeInterval)
+		{
+			TimeSinceProbe = 0.f;
+			SendProbes();
+		}
+	}
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+bool ULagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool ULagCompensationSubsystem::IsServer() const
+{
+	const ENetMode NetMode = GetWorld()->GetNetMode();
+	return NetMode == NM_DedicatedServer || NetMode == NM_ListenServer;
+}
+
+void ULagCompensationSubsystem::RegisterCharacter(ACharacter* Character)
+{
+	if (Character == nullptr || !IsServer() || SlotLookup.Contains(FObjectKey(Character))) return;
+
+	int32 Slot = INDEX_NONE;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(false);
+		SlotCharacters[Slot] = Character;
+		SlotRadii[Slot] = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+	}
+	else
+	{
+		DEC_MEMORY_STAT_BY(STAT_SlashLagCompMemory, Snapshots.GetAllocatedSize());
+		Slot = SlotCharacters.Add(Character);
+		SlotRadii.Add(Character->GetCapsuleComponent()->GetScaledCapsuleRadius());
+		Snapshots.AddDefaulted(HistoryLength);
+		INC_MEMORY_STAT_BY(STAT_SlashLagCompMemory, Snapshots.GetAllocatedSize());
+	}
+	SlotLookup.Add(FObjectKey(Character), Slot);
+
+	// No history yet, every frame it could be rewound to holds where it is now
+	FHitboxSnapshot Current;
+	Current.Location = FVector3f(Character->GetActorLocation());
+	Current.HalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	for (int32 Frame = 0; Frame < HistoryLength; ++Frame)
+	{
+		Snapshots[Slot * HistoryLength + Frame] = Current;
+	}
+	SET_DWORD_STAT(STAT_SlashLagCompTracked, SlotLookup.Num());
+}
+
+void ULagCompensationSubsystem::UnregisterCharacter(ACharacter* Character)
+{
+	int32 Slot = INDEX_NONE;
+	if (SlotLookup.RemoveAndCopyValue(FObjectKey(Character), Slot))
+	{
+		SlotCharacters[Slot] = nullptr;
+		FreeSlots.Add(Slot);
+	}
+	SET_DWORD_STAT(STAT_SlashLagCompTracked, SlotLookup.Num());
+}
+
+bool ULagCompensationSubsystem::IsTracked(const ACharacter* Character) const
+{
+	return SlotLookup.Contains(FObjectKey(Character));
+}
+
+void ULagCompensationSubsystem::RecordFrame()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlashLagCompRecord);
+	if (SlotLookup.Num() == 0) return;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	NewestFrame = (NewestFrame + 1) % HistoryLength;
+	NumFrames = FMath::Min(NumFrames + 1, HistoryLength);
+	FrameTimes[NewestFrame] = GetWorld()->GetTimeSeconds();
+
+	for (int32 Slot = 0; Slot < SlotCharacters.Num(); ++Slot)
+	{
+		const ACharacter* Character = SlotCharacters[Slot].Get();
+		if (Character == nullptr) continue;
+
+		FHitboxSnapshot& Snapshot = Snapshots[Slot * HistoryLength + NewestFrame];
+		Snapshot.Location = FVector3f(Character->GetActorLocation());
+		Snapshot.HalfHeight = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+	}
+
+	// Smoothed so one slow frame doesn't trip the warning
+	const double PerCharacter = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles) / SlotLookup.Num();
+	RecordSecondsPerCharacter = FMath::Lerp(RecordSecondsPerCharacter, PerCharacter, 0.1);
+	if (!bWarnedOverBudget && RecordSecondsPerCharacter * 1e6 > CVarLagCompMicrosPerCharacter.GetValueOnGameThread())
+	{
+		bWarnedOverBudget = true;
+		UE_LOG(LogTemp, Warning, TEXT("LagComp: recording takes %.2f us per character, over the slash.LagComp.MicrosPerCharacter budget"), RecordSecondsPerCharacter * 1e6);
+	}
+}
+
+bool ULagCompensationSubsystem::GetRewoundHitbox(const ACharacter* Character, double Time, FHitboxSnapshot& OutHitbox) const
+{
+	const int32* Slot = SlotLookup.Find(FObjectKey(Character));
+	if (Slot == nullptr || NumFrames == 0) return false;
+
+	const FHitboxSnapshot* History = &Snapshots[*Slot * HistoryLength];
+
+	// Walk back from the newest frame to the first one at or before Time
+	int32 Newer = NewestFrame;
+	for (int32 Step = 0; Step < NumFrames; ++Step)
+	{
+		const int32 Frame = (NewestFrame - Step + HistoryLength) % HistoryLength;
+		if (FrameTimes[Frame] <= Time)
+		{
+			if (Step == 0)
+			{
+				OutHitbox = History[Frame];
+				return true;
+			}
+			const double Span = FrameTimes[Newer] - FrameTimes[Frame];
+			const float Alpha = Span > 0.0 ? (float)((Time - FrameTimes[Frame]) / Span) : 0.f;
+			OutHitbox.Location = FMath::Lerp(History[Frame].Location, History[Newer].Location, Alpha);
+			OutHitbox.HalfHeight = FMath::Lerp(History[Frame].HalfHeight, History[Newer].HalfHeight, Alpha);
+			return true;
+		}
+		Newer = Frame;
+	}
+
+	// Older than the window, use the oldest frame we still have
+	OutHitbox = History[Newer];
+	return true;
+}
+
+bool ULagCompensationSubsystem::SweepCapsule(const FHitboxSnapshot& Hitbox, float Radius, const FVector& Start, const FVector& End, float SweepRadius, FVector& OutImpactPoint)
+{
+	const FVector Center(Hitbox.Location);
+	const FVector AxisExtent(0.f, 0.f, FMath::Max(0.f, Hitbox.HalfHeight - Radius));
+
+	FVector OnAxis;
+	FVector OnSweep;
+	FMath::SegmentDistToSegmentSafe(Center - AxisExtent, Center + AxisExtent, Start, End, OnAxis, OnSweep);
+
+	const float Tolerance = CVarLagCompTolerance.GetValueOnGameThread();
+	if (FVector::DistSquared(OnAxis, OnSweep) > FMath::Square(Radius + SweepRadius + Tolerance)) return false;
+
+	OutImpactPoint = OnAxis + (OnSweep - OnAxis).GetSafeNormal() * Radius;
+	return true;
+}
+
+bool ULagCompensationSubsystem::ConfirmHit(const ACharacter* Target, double Time, const FVector& Start, const FVector& End, float SweepRadius, FVector& OutImpactPoint)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlashLagCompConfirm);
+
+	// Never further back than the window, whatever the client claims
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double RewindTime = FMath::Clamp(Time, Now - CVarLagCompMaxRewind.GetValueOnGameThread(), Now);
+
+	FHitboxSnapshot Hitbox;
+	const int32* Slot = SlotLookup.Find(FObjectKey(Target));
+	const bool bConfirmed = Slot && GetRewoundHitbox(Target, RewindTime, Hitbox) &&
+		SweepCapsule(Hitbox, SlotRadii[*Slot], Start, End, SweepRadius, OutImpactPoint);
+
+	if (bConfirmed)
+	{
+		++NumConfirmed;
+	}
+	else
+	{
+		++NumRejected;
+	}
+	TotalRewindSeconds += Now - RewindTime;
+	return bConfirmed;
+}
+
+void ULagCompensationSubsystem::ProbeHit(const ACharacter* Target, const FVector& SeenLocation, double Time)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	FHitboxSnapshot Hitbox;
+	if (Target == nullptr || !GetRewoundHitbox(Target, FMath::Clamp(Time, Now - CVarLagCompMaxRewind.GetValueOnGameThread(), Now), Hitbox)) return;
+
+	++NumProbes;
+	ProbeErrorRewound += FVector::Dist(FVector(Hitbox.Location), SeenLocation);
+	ProbeErrorCurrent += FVector::Dist(Target->GetActorLocation(), SeenLocation);
+}
+
+void ULagCompensationSubsystem::SendProbes()
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	ASlashCharacter* Prober = PlayerController ? Cast<ASlashCharacter>(PlayerController->GetPawn()) : nullptr;
+	if (Prober == nullptr) return;
+
+	const double ViewTime = GetClientViewTime(GetWorld());
+	for (TActorIterator<ACharacter> It(GetWorld()); It; ++It)
+	{
+		if (*It != Prober && !It->IsLocallyControlled())
+		{
+			Prober->ServerLagCompProbe(*It, It->GetActorLocation(), ViewTime);
+		}
+	}
+}
+
+double ULagCompensationSubsystem::GetClientViewTime(const UWorld* World)
+{
+	// The client's server clock trails the server by the trip the replicated positions also took
+	const AGameStateBase* GameState = World ? World->GetGameState() : nullptr;
+	return GameState ? GameState->GetServerWorldTimeSeconds() : 0.0;
+}
+
+void ULagCompensationSubsystem::Dump() const
+{
+	UE_LOG(LogTemp, Display, TEXT("LagComp: %d tracked, %d frames of history, %d bytes and %.2f us per character"),
+		SlotLookup.Num(), HistoryLength, GetBytesPerCharacter(), RecordSecondsPerCharacter * 1e6);
+
+	const int32 NumHits = NumConfirmed + NumRejected;
+	if (NumHits > 0)
+	{
+		UE_LOG(LogTemp, Display, TEXT("LagComp: %d hits confirmed, %d rejected, average rewind %.1f ms"),
+			NumConfirmed, NumRejected, TotalRewindSeconds / NumHits * 1000.0);
+	}
+	if (NumProbes > 0)
+	{
+		UE_LOG(LogTemp, Display, TEXT("LagComp: %d probes, average error rewound %.1f cm, current %.1f cm"),
+			NumProbes, ProbeErrorRewound / NumProbes, ProbeErrorCurrent / NumProbes);
+	}
+}
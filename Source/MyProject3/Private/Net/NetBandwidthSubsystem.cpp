@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/NetBandwidthSubsystem.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+static TAutoConsoleVariable<float> CVarNetReportInterval(
+	TEXT("slash.Net.ReportInterval"),
+	0.f,
+	TEXT("Seconds between per client bandwidth reports on the server, 0 turns them off."));
+
+static FAutoConsoleCommandWithWorld NetReportCommand(
+	TEXT("slash.Net.Report"),
+	TEXT("Logs the current bandwidth of every client connection."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (UNetBandwidthSubsystem* Bandwidth = World ? World->GetSubsystem<UNetBandwidthSubsystem>() : nullptr)
+		{
+			Bandwidth->LogReport();
+		}
+	}));
+
+void UNetBandwidthSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const float Interval = CVarNetReportInterval.GetValueOnGameThread();
+	if (Interval <= 0.f) return;
+
+	TimeSinceReport += DeltaTime;
+	if (TimeSinceReport >= Interval)
+	{
+		TimeSinceReport = 0.f;
+		LogReport();
+	}
+}
+
+TStatId UNetBandwidthSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNetBandwidthSubsystem, STATGROUP_Tickables);
+}
+
+void UNetBandwidthSubsystem::Deinitialize()
+{
+	LogSummary();
+	Super::Deinitialize();
+}
+
+bool UNetBandwidthSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UNetBandwidthSubsystem::LogReport()
+{
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver == nullptr || !NetDriver->IsServer()) return;
+
+	for (const UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (Connection == nullptr) continue;
+
+		const FString Address = Connection->LowLevelGetRemoteAddress(true);
+		UE_LOG(LogTemp, Display, TEXT("NetReport: %s (%s) out %.2f KB/s, in %.2f KB/s, %d actor channels"),
+			*Address,
+			*GetNameSafe(Connection->PlayerController),
+			Connection->OutBytesPerSecond / 1024.f,
+			Connection->InBytesPerSecond / 1024.f,
+			Connection->ActorChannelsNum());
+
+		FClientTotals& Totals = ClientTotals.FindOrAdd(Address);
+		Totals.OutBytesPerSecond += Connection->OutBytesPerSecond;
+		Totals.InBytesPerSecond += Connection->InBytesPerSecond;
+		++Totals.Samples;
+	}
+}
+
+void UNetBandwidthSubsystem::LogSummary() const
+{
+	for (const TPair<FString, FClientTotals>& Pair : ClientTotals)
+	{
+		const FClientTotals& Totals = Pair.Value;
+		if (Totals.Samples == 0) continue;
+
+		UE_LOG(LogTemp, Display, TEXT("NetReport: average for %s over %d samples, out %.2f KB/s, in %.2f KB/s"),
+			*Pair.Key,
+			Totals.Samples,
+			Totals.OutBytesPerSecond / Totals.Samples / 1024.0,
+			Totals.InBytesPerSecond / Totals.Samples / 1024.0);
+	}
+}
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Net/SlashReplicationGraph.h"
+#include "Breakable/BreakableActor.h"
+#include "Characters/SlashCharacter.h"
+#include "Enemy/Enemy.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/Info.h"
+#include "Items/Item.h"
+#include "ReplicationGraphTypes.h"
+
+static TAutoConsoleVariable<float> CVarRepGraphCellSize(
+	TEXT("slash.RepGraph.CellSize"),
+	10000.f,
+	TEXT("Size of the replication grid cells. Read when the server starts."));
+
+static TAutoConsoleVariable<float> CVarRepGraphEnemyCullDistance(
+	TEXT("slash.RepGraph.EnemyCullDistance"),
+	8000.f,
+	TEXT("Enemies further than this from a client aren't replicated to it. Read when the server starts."));
+
+static TAutoConsoleVariable<float> CVarRepGraphItemCullDistance(
+	TEXT("slash.RepGraph.ItemCullDistance"),
+	5000.f,
+	TEXT("Items and breakables further than this from a client aren't replicated to it. Read when the server starts."));
+
+void USlashReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Things that don't move once placed
+	ClassRepPolicies.Set(ABreakableActor::StaticClass(), ESlashClassRepPolicy::Spatialize_Static);
+
+	// Dormant for long stretches: moving while awake and treated as static while asleep
+	ClassRepPolicies.Set(AEnemy::StaticClass(), ESlashClassRepPolicy::Spatialize_Dormancy);
+	ClassRepPolicies.Set(AItem::StaticClass(), ESlashClassRepPolicy::Spatialize_Dormancy);
+
+	// Players never go dormant
+	ClassRepPolicies.Set(ASlashCharacter::StaticClass(), ESlashClassRepPolicy::Spatialize_Dynamic);
+
+	const float EnemyCullDistance = CVarRepGraphEnemyCullDistance.GetValueOnGameThread();
+	const float ItemCullDistance = CVarRepGraphItemCullDistance.GetValueOnGameThread();
+	InitClassInfo(AEnemy::StaticClass(), EnemyCullDistance);
+	InitClassInfo(ASlashCharacter::StaticClass(), EnemyCullDistance);
+	InitClassInfo(AItem::StaticClass(), ItemCullDistance);
+	InitClassInfo(ABreakableActor::StaticClass(), ItemCullDistance);
+}
+
+void USlashReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = FMath::Max(1000.f, CVarRepGraphCellSize.GetValueOnGameThread());
+	// Keeps the cell coordinates positive for any map within the default world bounds
+	GridNode->SpatialBias = FVector2D(-UE_OLD_HALF_WORLD_MAX, -UE_OLD_HALF_WORLD_MAX);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void USlashReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// Adds the connection's own controller and view target, everything owner only lives there
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnection = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnection, RepGraphConnection);
+}
+
+void USlashReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch (GetClassPolicy(ActorInfo.Class))
+	{
+	case ESlashClassRepPolicy::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+	case ESlashClassRepPolicy::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+	case ESlashClassRepPolicy::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+	case ESlashClassRepPolicy::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+void USlashReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch (GetClassPolicy(ActorInfo.Class))
+	{
+	case ESlashClassRepPolicy::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+	case ESlashClassRepPolicy::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+	case ESlashClassRepPolicy::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+	case ESlashClassRepPolicy::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+	default:
+		break;
+	}
+}
+
+ESlashClassRepPolicy USlashReplicationGraph::GetClassPolicy(UClass* Class)
+{
+	if (const ESlashClassRepPolicy* Policy = ClassRepPolicies.Get(Class))
+	{
+		return *Policy;
+	}
+
+	// Anything we didn't set up gets routed by what its defaults say about relevancy
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	ESlashClassRepPolicy Policy = ESlashClassRepPolicy::Spatialize_Dynamic;
+	if (ActorCDO->bAlwaysRelevant || Class->IsChildOf(AInfo::StaticClass()))
+	{
+		Policy = ESlashClassRepPolicy::RelevantAllConnections;
+	}
+	else if (ActorCDO->bOnlyRelevantToOwner)
+	{
+		Policy = ESlashClassRepPolicy::NotRouted;
+	}
+	ClassRepPolicies.Set(Class, Policy);
+	return Policy;
+}
+
+void USlashReplicationGraph::InitClassInfo(UClass* Class, float CullDistance)
+{
+	const AActor* ActorCDO = Class->GetDefaultObject<AActor>();
+	const float ServerMaxTickRate = NetDriver ? NetDriver->GetNetServerMaxTickRate() : 30.f;
+
+	FClassReplicationInfo ClassInfo;
+	ClassInfo.SetCullDistanceSquared(FMath::Square(CullDistance));
+	ClassInfo.ReplicationPeriodFrame = FMath::Max<uint32>((uint32)FMath::RoundToFloat(ServerMaxTickRate / ActorCDO->NetUpdateFrequency), 1);
+	GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Persistence/ActorStateSubsystem.h"
+#include "Algo/BinarySearch.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+static FAutoConsoleCommandWithWorld DumpActorStateCommand(
+	TEXT("slash.State.Dump"),
+	TEXT("Prints how many actors have stored streaming state and what it costs."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		if (UActorStateSubsystem* ActorState = GameInstance ? GameInstance->GetSubsystem<UActorStateSubsystem>() : nullptr)
+		{
+			UE_LOG(LogTemp, Display, TEXT("Actor state: %d entries, %llu bytes"), ActorState->Num(), (uint64)ActorState->GetAllocatedSize());
+		}
+	}));
+
+bool UActorStateSubsystem::FindState(const FGuid& Guid, FPersistentActorState& OutState) const
+{
+	const int32 Index = Algo::BinarySearch(Guids, Guid);
+	if (Index == INDEX_NONE) return false;
+
+	OutState = States[Index];
+	return true;
+}
+
+void UActorStateSubsystem::SetState(const FGuid& Guid, const FPersistentActorState& State)
+{
+	if (!Guid.IsValid()) return;
+
+	const int32 Index = Algo::LowerBound(Guids, Guid);
+	if (Guids.IsValidIndex(Index) && Guids[Index] == Guid)
+	{
+		States[Index] = State;
+	}
+	else
+	{
+		Guids.Insert(Guid, Index);
+		States.Insert(State, Index);
+	}
+}
+
+void UActorStateSubsystem::Reset()
+{
+	Guids.Empty();
+	States.Empty();
+}
+
+void UActorStateSubsystem::Assign(TArray<FGuid>&& InGuids, TArray<FPersistentActorState>&& InStates)
+{
+	check(InGuids.Num() == InStates.Num());
+	Guids = MoveTemp(InGuids);
+	States = MoveTemp(InStates);
+}
+
+SIZE_T UActorStateSubsystem::GetAllocatedSize() const
+{
+	return Guids.GetAllocatedSize() + States.GetAllocatedSize();
+}
@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Persistence/SaveGameSubsystem.h"
+#include "Algo/BinarySearch.h"
+#include "Async/Async.h"
+#include "Characters/SlashCharacter.h"
+#include "Components/PersistentStateComponent.h"
+#include "Enemy/Enemy.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "HAL/FileManager.h"
+#include "Items/Weapons/Weapon.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "MyProject3/MyProject3.h"
+#include "Persistence/BinarySections.h"
+
+DECLARE_CYCLE_STAT(TEXT("Save Snapshot"), STAT_SlashSaveSnapshot, STATGROUP_Slash);
+
+static FAutoConsoleCommandWithWorldAndArgs SaveCommand(
+	TEXT("slash.Save"),
+	TEXT("slash.Save [Slot=Quick], saves the game in the background."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		if (USaveGameSubsystem* SaveGame = GameInstance ? GameInstance->GetSubsystem<USaveGameSubsystem>() : nullptr)
+		{
+			SaveGame->SaveGame(Args.Num() > 0 ? Args[0] : TEXT("Quick"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs LoadCommand(
+	TEXT("slash.Load"),
+	TEXT("slash.Load [Slot=Quick], loads the save and opens its map."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		if (USaveGameSubsystem* SaveGame = GameInstance ? GameInstance->GetSubsystem<USaveGameSubsystem>() : nullptr)
+		{
+			SaveGame->LoadGame(Args.Num() > 0 ? Args[0] : TEXT("Quick"));
+		}
+	}));
+
+void USaveGameSubsystem::Deinitialize()
+{
+	// Don't leave a half written save behind
+	SaveTask.Wait();
+	Super::Deinitialize();
+}
+
+bool USaveGameSubsystem::SaveGame(const FString& Slot)
+{
+	UWorld* World = GetGameInstance()->GetWorld();
+	if (World == nullptr || World->GetNetMode() == NM_Client || bLoading)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Save: only the server saves, and not while loading"));
+		return false;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	FSnapshot Snapshot;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SlashSaveSnapshot);
+		Snapshot.MapName = UGameplayStatics::GetCurrentLevelName(World);
+
+		// Plain array copies, the states are kept sorted by guid already
+		if (const UActorStateSubsystem* ActorState = GetGameInstance()->GetSubsystem<UActorStateSubsystem>())
+		{
+			Snapshot.ActorGuids = ActorState->GetGuids();
+			Snapshot.ActorStates = ActorState->GetStates();
+		}
+
+		if (const ASlashCharacter* Player = Cast<ASlashCharacter>(UGameplayStatics::GetPlayerPawn(World, 0)))
+		{
+			Player->GetSaveState(Snapshot.Players.AddZeroed_GetRef());
+
+			// The equipped weapon comes back with the player, not where it was picked up
+			const AWeapon* Weapon = Player->GetEquippedWeapon();
+			const UPersistentStateComponent* WeaponState = Weapon ? Weapon->GetPersistentState() : nullptr;
+			if (WeaponState && WeaponState->HasPersistentGuid())
+			{
+				const FGuid& Guid = WeaponState->GetPersistentGuid();
+				const int32 Index = Algo::LowerBound(Snapshot.ActorGuids, Guid);
+				if (!Snapshot.ActorGuids.IsValidIndex(Index) || Snapshot.ActorGuids[Index] != Guid)
+				{
+					Snapshot.ActorGuids.Insert(Guid, Index);
+					Snapshot.ActorStates.Insert(FPersistentActorState(), Index);
+				}
+				Snapshot.ActorStates[Index].Flags |= EPersistentStateFlags::Collected;
+			}
+		}
+
+		for (TActorIterator<AEnemy> It(World); It; ++It)
+		{
+			const UPersistentStateComponent* EnemyState = It->GetPersistentState();
+			if (EnemyState == nullptr || !EnemyState->HasPersistentGuid() || It->GetEnemyState() == EEnemyState::EES_Dead) continue;
+
+			SaveFile::FEnemy& Enemy = Snapshot.Enemies.AddZeroed_GetRef();
+			Enemy.Guid = EnemyState->GetPersistentGuid();
+			Enemy.Location = FVector3f(It->GetActorLocation());
+			Enemy.Yaw = static_cast<float>(It->GetActorRotation().Yaw);
+		}
+		Snapshot.Enemies.Sort([](const SaveFile::FEnemy& A, const SaveFile::FEnemy& B) { return A.Guid < B.Guid; });
+	}
+	UE_LOG(LogTemp, Display, TEXT("Save: snapshot of %d actor states and %d enemies took %.3f ms"),
+		Snapshot.ActorStates.Num(), Snapshot.Enemies.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	// Each save waits for the one before it so they land on disk in order
+	SaveTask = UE::Tasks::Launch(UE_SOURCE_LOCATION, [Snapshot = MoveTemp(Snapshot), Path = GetSlotPath(Slot)]()
+	{
+		if (!WriteSnapshot(Snapshot, Path))
+		{
+			UE_LOG(LogTemp, Error, TEXT("Save: couldn't write %s"), *Path);
+		}
+	}, UE::Tasks::Prerequisites(SaveTask));
+	return true;
+}
+
+void USaveGameSubsystem::LoadGame(const FString& Slot)
+{
+	if (bLoading) return;
+	bLoading = true;
+
+	TWeakObjectPtr<USaveGameSubsystem> WeakThis(this);
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, Path = GetSlotPath(Slot)]()
+	{
+		FSnapshot Snapshot;
+		const bool bRead = ReadSnapshot(Path, Snapshot);
+		if (!bRead)
+		{
+			UE_LOG(LogTemp, Error, TEXT("Save: couldn't load %s"), *Path);
+		}
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, bRead, Snapshot = MoveTemp(Snapshot)]() mutable
+		{
+			if (USaveGameSubsystem* This = WeakThis.Get())
+			{
+				This->bLoading = false;
+				if (bRead)
+				{
+					This->ApplySnapshot(MoveTemp(Snapshot));
+				}
+			}
+		});
+	}, UE::Tasks::Prerequisites(SaveTask));
+}
+
+bool USaveGameSubsystem::ConsumePlayer(SaveFile::FPlayer& OutPlayer)
+{
+	if (!bPlayerPending) return false;
+	bPlayerPending = false;
+	OutPlayer = LoadedPlayer;
+	return true;
+}
+
+bool USaveGameSubsystem::ConsumeEnemy(const FGuid& Guid, SaveFile::FEnemy& OutEnemy)
+{
+	const int32 Index = Algo::BinarySearchBy(LoadedEnemies, Guid, [](const SaveFile::FEnemy& Enemy) { return Enemy.Guid; });
+	if (Index == INDEX_NONE) return false;
+
+	// Keeps the rest sorted for the binary search
+	OutEnemy = LoadedEnemies[Index];
+	LoadedEnemies.RemoveAt(Index, 1, false);
+	return true;
+}
+
+FString USaveGameSubsystem::GetSlotPath(const FString& Slot)
+{
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SaveGames"), Slot + TEXT(".slsave"));
+}
+
+bool USaveGameSubsystem::WriteSnapshot(const FSnapshot& Snapshot, const FString& Path)
+{
+	SaveFile::FHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = SaveFile::Magic;
+	Header.Version = SaveFile::Version;
+	Header.HeaderSize = sizeof(SaveFile::FHeader);
+	Header.NumPlayers = Snapshot.Players.Num();
+	Header.NumActorStates = Snapshot.ActorStates.Num();
+	Header.NumEnemies = Snapshot.Enemies.Num();
+	FCStringAnsi::Strncpy(Header.MapName, TCHAR_TO_ANSI(*Snapshot.MapName), UE_ARRAY_COUNT(Header.MapName));
+
+	TArray<uint8> Payload;
+	Header.PlayerOffset = BinarySections::AppendSection(Payload, Snapshot.Players);
+	Header.ActorGuidsOffset = BinarySections::AppendSection(Payload, Snapshot.ActorGuids);
+	Header.ActorStatesOffset = BinarySections::AppendSection(Payload, Snapshot.ActorStates);
+	Header.EnemiesOffset = BinarySections::AppendSection(Payload, Snapshot.Enemies);
+	Header.UncompressedSize = Payload.Num();
+
+	TArray<uint8> Bytes;
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Oodle, Payload.Num());
+	Bytes.SetNumUninitialized(sizeof(SaveFile::FHeader) + CompressedSize);
+	if (!FCompression::CompressMemory(NAME_Oodle, Bytes.GetData() + sizeof(SaveFile::FHeader), CompressedSize, Payload.GetData(), Payload.Num())) return false;
+	Bytes.SetNum(sizeof(SaveFile::FHeader) + CompressedSize);
+	Header.CompressedSize = CompressedSize;
+	FMemory::Memcpy(Bytes.GetData(), &Header, sizeof(Header));
+
+	// Written next to the old save and swapped in, so a crash mid write keeps the old one
+	const FString TempPath = Path + TEXT(".tmp");
+	return FFileHelper::SaveArrayToFile(Bytes, *TempPath) && IFileManager::Get().Move(*Path, *TempPath, true);
+}
+
+bool USaveGameSubsystem::ReadSnapshot(const FString& Path, FSnapshot& OutSnapshot)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path) || Bytes.Num() < sizeof(SaveFile::FHeader)) return false;
+
+	SaveFile::FHeader Header;
+	FMemory::Memcpy(&Header, Bytes.GetData(), sizeof(Header));
+	if (Header.Magic != SaveFile::Magic || Header.Version != SaveFile::Version || Header.HeaderSize != sizeof(SaveFile::FHeader)
+		|| uint64(Header.HeaderSize) + Header.CompressedSize > uint64(Bytes.Num()) || Header.NumPlayers > 1)
+	{
+		return false;
+	}
+
+	TArray<uint8> Payload;
+	Payload.SetNumUninitialized(Header.UncompressedSize);
+	if (!FCompression::UncompressMemory(NAME_Oodle, Payload.GetData(), Payload.Num(), Bytes.GetData() + Header.HeaderSize, Header.CompressedSize)) return false;
+
+	Header.MapName[UE_ARRAY_COUNT(Header.MapName) - 1] = 0;
+	OutSnapshot.MapName = ANSI_TO_TCHAR(Header.MapName);
+	return BinarySections::ReadSection(Payload, Header.PlayerOffset, Header.NumPlayers, OutSnapshot.Players)
+		&& BinarySections::ReadSection(Payload, Header.ActorGuidsOffset, Header.NumActorStates, OutSnapshot.ActorGuids)
+		&& BinarySections::ReadSection(Payload, Header.ActorStatesOffset, Header.NumActorStates, OutSnapshot.ActorStates)
+		&& BinarySections::ReadSection(Payload, Header.EnemiesOffset, Header.NumEnemies, OutSnapshot.Enemies);
+}
+
+void USaveGameSubsystem::ApplySnapshot(FSnapshot&& Snapshot)
+{
+	// Everything is in place before the map opens, actors pick it up as they begin play
+	if (UActorStateSubsystem* ActorState = GetGameInstance()->GetSubsystem<UActorStateSubsystem>())
+	{
+		ActorState->Assign(MoveTemp(Snapshot.ActorGuids), MoveTemp(Snapshot.ActorStates));
+	}
+	LoadedEnemies = MoveTemp(Snapshot.Enemies);
+	bPlayerPending = Snapshot.Players.Num() > 0;
+	if (bPlayerPending)
+	{
+		LoadedPlayer = Snapshot.Players[0];
+	}
+
+	UGameplayStatics::OpenLevel(GetGameInstance(), FName(*Snapshot.MapName));
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Replay/GameplayRandomSubsystem.h"
+#include "Replay/SessionRecorderSubsystem.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<int32> CVarRandomSeed(
+	TEXT("slash.Random.Seed"),
+	0,
+	TEXT("Seed for the gameplay random streams when the next map loads, 0 picks one from the clock."));
+
+void UGameplayRandomSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// A replay has to roll what the recording rolled
+	USessionRecorderSubsystem* Recorder = Collection.InitializeDependency<USessionRecorderSubsystem>();
+	if (Recorder == nullptr || !Recorder->GetReplaySeed(Seed))
+	{
+		Seed = CVarRandomSeed.GetValueOnGameThread();
+		if (Seed == 0)
+		{
+			Seed = FPlatformTime::Cycles();
+		}
+	}
+
+	for (int32 Index = 0; Index < UE_ARRAY_COUNT(Streams); ++Index)
+	{
+		Streams[Index].Initialize(static_cast<int32>(HashCombine(Seed, GetTypeHash(Index))));
+	}
+	UE_LOG(LogTemp, Display, TEXT("Gameplay random seed %u"), Seed);
+}
+
+bool UGameplayRandomSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FRandomStream& UGameplayRandomSubsystem::GetStream(const UObject* WorldContextObject, EGameplayRandom Stream)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	if (UGameplayRandomSubsystem* Random = World ? World->GetSubsystem<UGameplayRandomSubsystem>() : nullptr)
+	{
+		return Random->Streams[static_cast<int32>(Stream)];
+	}
+
+	static FRandomStream Unseeded(static_cast<int32>(FPlatformTime::Cycles()));
+	return Unseeded;
+}
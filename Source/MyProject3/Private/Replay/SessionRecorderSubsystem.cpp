@@ -0,0 +1,400 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Replay/SessionRecorderSubsystem.h"
+#include "Replay/GameplayRandomSubsystem.h"
+#include "Async/MappedFileHandle.h"
+#include "Characters/SlashCharacter.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/PlatformFileManager.h"
+#include "Items/Item.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Persistence/BinarySections.h"
+
+static FAutoConsoleCommandWithWorld StopRecordingCommand(
+	TEXT("slash.Replay.StopRecording"),
+	TEXT("Ends the -SlashRecord session here and writes the file."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (USessionRecorderSubsystem* Recorder = World ? World->GetSubsystem<USessionRecorderSubsystem>() : nullptr)
+		{
+			Recorder->StopRecording();
+		}
+	}));
+
+void USessionRecorderSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// Before anything else initializes, the random subsystem asks us for the replay's seed
+	FString Name;
+	if (FParse::Value(FCommandLine::Get(), TEXT("SlashReplay="), Name))
+	{
+		if (OpenReplay(GetRecordingPath(Name)))
+		{
+			Mode = EMode::Replaying;
+			bExitWhenDone = FParse::Param(FCommandLine::Get(), TEXT("SlashReplayExit"));
+		}
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("SlashRecord="), Name))
+	{
+		RecordingPath = GetRecordingPath(Name);
+		Mode = EMode::Recording;
+	}
+}
+
+void USessionRecorderSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	if (Mode == EMode::Idle) return;
+
+	// Networked sessions depend on the other machines too, there is nothing to replay them against
+	if (InWorld.GetNetMode() != NM_Standalone)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Session recording and replay only cover standalone games, ignoring"));
+		Mode = EMode::Idle;
+		return;
+	}
+
+	const FString MapName = UWorld::RemovePIEPrefix(InWorld.GetMapName());
+	if (Mode == EMode::Replaying)
+	{
+		const FString RecordedMap(FCStringAnsi::Strnlen(ReplayHeader->MapName, UE_ARRAY_COUNT(ReplayHeader->MapName)), ReplayHeader->MapName);
+		if (RecordedMap != MapName)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Replay: recorded on %s, not %s, ignoring"), *RecordedMap, *MapName);
+			Mode = EMode::Idle;
+			return;
+		}
+
+		// Frame times come from the recording instead of the clock, which also lets it run flat out
+		bWasUsingFixedTimeStep = FApp::UseFixedTimeStep();
+		PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+		FApp::SetUseFixedTimeStep(true);
+		SetReplayDeltaTime(0);
+		LastFrameWallTime = FPlatformTime::Seconds();
+	}
+	else if (const UGameplayRandomSubsystem* Random = InWorld.GetSubsystem<UGameplayRandomSubsystem>())
+	{
+		RecordingSeed = Random->GetSeed();
+	}
+
+	PreActorTickHandle = FWorldDelegates::OnWorldPreActorTick.AddUObject(this, &USessionRecorderSubsystem::OnPreActorTick);
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &USessionRecorderSubsystem::OnActorSpawned));
+}
+
+void USessionRecorderSubsystem::Deinitialize()
+{
+	StopRecording();
+	if (Mode == EMode::Replaying)
+	{
+		FinishReplay();
+	}
+
+	FWorldDelegates::OnWorldPreActorTick.Remove(PreActorTickHandle);
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	}
+
+	ReplayHeader = nullptr;
+	ReplayFrames = nullptr;
+	ReplayInputs = nullptr;
+	ReplaySpawns = nullptr;
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedFile.Empty();
+
+	Super::Deinitialize();
+}
+
+bool USessionRecorderSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USessionRecorderSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USessionRecorderSubsystem, STATGROUP_Tickables);
+}
+
+void USessionRecorderSubsystem::NoteInput(const APawn* Pawn, ESessionInput Type, const FVector2D& Value)
+{
+	if (Pawn == nullptr || !Pawn->IsLocallyControlled()) return;
+
+	UWorld* World = Pawn->GetWorld();
+	USessionRecorderSubsystem* Recorder = World ? World->GetSubsystem<USessionRecorderSubsystem>() : nullptr;
+	if (Recorder == nullptr || Recorder->Mode != EMode::Recording || !Recorder->bFrameOpen) return;
+
+	SessionRecording::FInput& Input = Recorder->RecordedInputs.AddZeroed_GetRef();
+	Input.Type = Type;
+	Input.Value = FVector2f(Value);
+}
+
+bool USessionRecorderSubsystem::IsReplaying(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	const USessionRecorderSubsystem* Recorder = World ? World->GetSubsystem<USessionRecorderSubsystem>() : nullptr;
+	return Recorder && Recorder->Mode == EMode::Replaying;
+}
+
+bool USessionRecorderSubsystem::IsRecordingOrReplaying(const UObject* WorldContextObject)
+{
+	UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	const USessionRecorderSubsystem* Recorder = World ? World->GetSubsystem<USessionRecorderSubsystem>() : nullptr;
+	return Recorder && Recorder->Mode != EMode::Idle;
+}
+
+bool USessionRecorderSubsystem::GetReplaySeed(uint32& OutSeed) const
+{
+	if (Mode != EMode::Replaying) return false;
+	OutSeed = ReplayHeader->Seed;
+	return true;
+}
+
+void USessionRecorderSubsystem::OnPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld != GetWorld() || Mode == EMode::Idle) return;
+
+	if (Mode == EMode::Recording)
+	{
+		SessionRecording::FFrame& Frame = RecordedFrames.AddZeroed_GetRef();
+		Frame.DeltaTime = DeltaSeconds;
+		Frame.FirstInput = RecordedInputs.Num();
+		bFrameOpen = true;
+		return;
+	}
+
+	if (FrameIndex >= ReplayHeader->NumFrames)
+	{
+		FinishReplay();
+		return;
+	}
+	bFrameOpen = true;
+
+	// Fed in before the player controller ticks, where the real input would have come in
+	ASlashCharacter* Player = GetPlayerCharacter();
+	const uint32 EndInput = FrameIndex + 1 < ReplayHeader->NumFrames ? ReplayFrames[FrameIndex + 1].FirstInput : ReplayHeader->NumInputs;
+	for (uint32 InputIndex = ReplayFrames[FrameIndex].FirstInput; Player && InputIndex < EndInput; ++InputIndex)
+	{
+		Player->ReplayInput(ReplayInputs[InputIndex].Type, FVector2D(ReplayInputs[InputIndex].Value));
+	}
+}
+
+void USessionRecorderSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+	if (!bFrameOpen) return;
+	bFrameOpen = false;
+
+	const uint32 Checksum = ComputeChecksum();
+	if (Mode == EMode::Recording)
+	{
+		RecordedFrames.Last().Checksum = Checksum;
+	}
+	else if (Mode == EMode::Replaying)
+	{
+		if (FirstDivergentFrame == INDEX_NONE && Checksum != ReplayFrames[FrameIndex].Checksum)
+		{
+			FirstDivergentFrame = FrameIndex;
+			UE_LOG(LogTemp, Warning, TEXT("Replay: characters left the recorded path at frame %u"), FrameIndex);
+		}
+
+		const double Now = FPlatformTime::Seconds();
+		const double FrameWallTime = Now - LastFrameWallTime;
+		LastFrameWallTime = Now;
+		TotalFrameWallTime += FrameWallTime;
+		MaxFrameWallTime = FMath::Max(MaxFrameWallTime, FrameWallTime);
+
+		SetReplayDeltaTime(FrameIndex + 1);
+	}
+	++FrameIndex;
+}
+
+void USessionRecorderSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (Mode == EMode::Idle || Actor == nullptr || !(Actor->IsA<APawn>() || Actor->IsA<AItem>())) return;
+
+	SessionRecording::FSpawn Spawn;
+	FMemory::Memzero(Spawn);
+	Spawn.Frame = FrameIndex;
+	Spawn.ClassHash = FCrc::StrCrc32(*Actor->GetClass()->GetPathName());
+	Spawn.Location = FVector3f(Actor->GetActorLocation());
+
+	if (Mode == EMode::Recording)
+	{
+		RecordedSpawns.Add(Spawn);
+		return;
+	}
+
+	const SessionRecording::FSpawn* Expected = NextReplaySpawn < ReplayHeader->NumSpawns ? &ReplaySpawns[NextReplaySpawn] : nullptr;
+	const bool bMatches = Expected && Expected->Frame == Spawn.Frame && Expected->ClassHash == Spawn.ClassHash && Expected->Location.Equals(Spawn.Location, 1.f);
+	if (!bMatches)
+	{
+		if (SpawnMismatches == 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("Replay: %s spawned at frame %u doesn't match the recording"), *GetNameSafe(Actor), FrameIndex);
+		}
+		++SpawnMismatches;
+	}
+	++NextReplaySpawn;
+}
+
+uint32 USessionRecorderSubsystem::ComputeChecksum() const
+{
+	uint32 Checksum = 0;
+	for (TActorIterator<ABaseCharacter> It(GetWorld()); It; ++It)
+	{
+		// Whole centimetres, rounding noise below that isn't what we're checking for
+		const FVector Location = It->GetActorLocation();
+		const FIntVector Quantized(FMath::RoundToInt(Location.X), FMath::RoundToInt(Location.Y), FMath::RoundToInt(Location.Z));
+		Checksum = FCrc::MemCrc32(&Quantized, sizeof(Quantized), Checksum);
+	}
+	return Checksum;
+}
+
+void USessionRecorderSubsystem::StopRecording()
+{
+	if (Mode != EMode::Recording) return;
+	Mode = EMode::Idle;
+
+	// A frame that hasn't finished has no checksum yet, leave it and its inputs out
+	if (bFrameOpen && RecordedFrames.Num() > 0)
+	{
+		RecordedInputs.SetNum(RecordedFrames.Last().FirstInput);
+		RecordedFrames.Pop();
+		bFrameOpen = false;
+	}
+
+	SessionRecording::FHeader Header;
+	FMemory::Memzero(Header);
+	Header.Magic = SessionRecording::Magic;
+	Header.Version = SessionRecording::Version;
+	Header.HeaderSize = sizeof(Header);
+	Header.Seed = RecordingSeed;
+	Header.NumFrames = RecordedFrames.Num();
+	Header.NumInputs = RecordedInputs.Num();
+	Header.NumSpawns = RecordedSpawns.Num();
+	FCStringAnsi::Strncpy(Header.MapName, TCHAR_TO_ANSI(*UWorld::RemovePIEPrefix(GetWorld()->GetMapName())), UE_ARRAY_COUNT(Header.MapName));
+
+	TArray<uint8> Bytes;
+	Bytes.AddZeroed(sizeof(Header));
+	Header.FramesOffset = BinarySections::AppendSection(Bytes, RecordedFrames);
+	Header.InputsOffset = BinarySections::AppendSection(Bytes, RecordedInputs);
+	Header.SpawnsOffset = BinarySections::AppendSection(Bytes, RecordedSpawns);
+	FMemory::Memcpy(Bytes.GetData(), &Header, sizeof(Header));
+
+	if (FFileHelper::SaveArrayToFile(Bytes, *RecordingPath))
+	{
+		UE_LOG(LogTemp, Display, TEXT("Recorded %u frames, %u inputs and %u spawns to %s (%.1f KB)"),
+			Header.NumFrames, Header.NumInputs, Header.NumSpawns, *RecordingPath, Bytes.Num() / 1024.f);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Error, TEXT("Couldn't write the recording to %s"), *RecordingPath);
+	}
+
+	RecordedFrames.Empty();
+	RecordedInputs.Empty();
+	RecordedSpawns.Empty();
+}
+
+bool USessionRecorderSubsystem::OpenReplay(const FString& Path)
+{
+	const uint8* Data = nullptr;
+	int64 Size = 0;
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (MappedFile.IsValid())
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+	if (MappedRegion.IsValid())
+	{
+		Data = MappedRegion->GetMappedPtr();
+		Size = MappedRegion->GetMappedSize();
+	}
+	else if (FFileHelper::LoadFileToArray(LoadedFile, *Path))
+	{
+		Data = LoadedFile.GetData();
+		Size = LoadedFile.Num();
+	}
+	if (Data == nullptr)
+	{
+		UE_LOG(LogTemp, Error, TEXT("Replay: couldn't open %s"), *Path);
+		return false;
+	}
+
+	auto SectionFits = [Size](uint32 Offset, uint32 Count, SIZE_T RecordSize)
+	{
+		return uint64(Offset) + uint64(Count) * RecordSize <= uint64(Size);
+	};
+
+	const SessionRecording::FHeader* Header = reinterpret_cast<const SessionRecording::FHeader*>(Data);
+	if (Size < int64(sizeof(SessionRecording::FHeader)) ||
+		Header->Magic != SessionRecording::Magic ||
+		Header->Version != SessionRecording::Version ||
+		Header->HeaderSize != sizeof(SessionRecording::FHeader) ||
+		!SectionFits(Header->FramesOffset, Header->NumFrames, sizeof(SessionRecording::FFrame)) ||
+		!SectionFits(Header->InputsOffset, Header->NumInputs, sizeof(SessionRecording::FInput)) ||
+		!SectionFits(Header->SpawnsOffset, Header->NumSpawns, sizeof(SessionRecording::FSpawn)))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Replay: %s isn't a recording from this version"), *Path);
+		MappedRegion.Reset();
+		MappedFile.Reset();
+		LoadedFile.Empty();
+		return false;
+	}
+
+	ReplayHeader = Header;
+	ReplayFrames = reinterpret_cast<const SessionRecording::FFrame*>(Data + Header->FramesOffset);
+	ReplayInputs = reinterpret_cast<const SessionRecording::FInput*>(Data + Header->InputsOffset);
+	ReplaySpawns = reinterpret_cast<const SessionRecording::FSpawn*>(Data + Header->SpawnsOffset);
+	UE_LOG(LogTemp, Display, TEXT("Replay: playing %s, %u frames, seed %u"), *Path, Header->NumFrames, Header->Seed);
+	return true;
+}
+
+void USessionRecorderSubsystem::FinishReplay()
+{
+	Mode = EMode::Idle;
+	bFrameOpen = false;
+	SpawnMismatches += ReplayHeader->NumSpawns - FMath::Min(NextReplaySpawn, ReplayHeader->NumSpawns);
+
+	const FString Result = FirstDivergentFrame == INDEX_NONE ? FString(TEXT("matched the recording")) : FString::Printf(TEXT("diverged at frame %lld"), FirstDivergentFrame);
+	UE_LOG(LogTemp, Display, TEXT("Replay: %u of %u frames, %s, %d of %u spawns mismatched, %.2f ms average frame, %.2f ms worst"),
+		FrameIndex, ReplayHeader->NumFrames, *Result, SpawnMismatches, ReplayHeader->NumSpawns,
+		FrameIndex > 0 ? TotalFrameWallTime * 1000.0 / FrameIndex : 0.0, MaxFrameWallTime * 1000.0);
+
+	FApp::SetUseFixedTimeStep(bWasUsingFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void USessionRecorderSubsystem::SetReplayDeltaTime(uint32 Frame)
+{
+	// Takes effect on the engine's next frame
+	if (Frame < ReplayHeader->NumFrames)
+	{
+		FApp::SetFixedDeltaTime(ReplayFrames[Frame].DeltaTime);
+	}
+}
+
+ASlashCharacter* USessionRecorderSubsystem::GetPlayerCharacter() const
+{
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	return PlayerController ? Cast<ASlashCharacter>(PlayerController->GetPawn()) : nullptr;
+}
+
+FString USessionRecorderSubsystem::GetRecordingPath(const FString& Name)
+{
+	const FString FileName = FPaths::GetExtension(Name).IsEmpty() ? Name + TEXT(".slrp") : Name;
+	return FPaths::IsRelative(FileName) ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Replays"), FileName) : FileName;
+}
@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spawning/AsyncSpawnSubsystem.h"
+#include "Interfaces/PreloadInterface.h"
+#include "Spawning/SpawnDirectorSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "HAL/PlatformMemory.h"
+
+namespace
+{
+	double UsedPhysicalMB()
+	{
+		return FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+	}
+}
+
+void UAsyncSpawnSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	WorldInitTime = FPlatformTime::Seconds();
+}
+
+void UAsyncSpawnSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	UE_LOG(LogTemp, Display, TEXT("%s loaded in %.1f ms, %.1f MB resident"),
+		*InWorld.GetMapName(), (FPlatformTime::Seconds() - WorldInitTime) * 1000.0, UsedPhysicalMB());
+
+	PreloadStartTime = FPlatformTime::Seconds();
+	for (ULevel* Level : InWorld.GetLevels())
+	{
+		PreloadForLevel(Level);
+	}
+
+	// World partition cells and streamed sublevels show up after begin play
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UAsyncSpawnSubsystem::OnLevelAdded);
+}
+
+void UAsyncSpawnSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+
+	PreloadHandles.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UAsyncSpawnSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UAsyncSpawnSubsystem::IsPreloadComplete() const
+{
+	for (const TSharedPtr<FStreamableHandle>& Handle : PreloadHandles)
+	{
+		if (Handle.IsValid() && Handle->IsLoadingInProgress()) return false;
+	}
+	return true;
+}
+
+const TArray<FName>& UAsyncSpawnSubsystem::GetPreloadBundles()
+{
+	static const TArray<FName> Bundles = { FName("Game") };
+	return Bundles;
+}
+
+void UAsyncSpawnSubsystem::PreloadForLevel(ULevel* Level)
+{
+	if (Level == nullptr) return;
+
+	TArray<FSoftObjectPath> Paths;
+	for (AActor* Actor : Level->Actors)
+	{
+		if (const IPreloadInterface* Preloadable = Cast<IPreloadInterface>(Actor))
+		{
+			Preloadable->GetPreloadAssets(Paths);
+		}
+	}
+
+	UAssetManager& AssetManager = UAssetManager::Get();
+	TArray<FPrimaryAssetId> PrimaryAssets;
+	TArray<FSoftObjectPath> OtherAssets;
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		if (Path.IsNull() || Path.ResolveObject()) continue;
+
+		const FPrimaryAssetId AssetId = AssetManager.GetPrimaryAssetIdForPath(Path);
+		if (AssetId.IsValid())
+		{
+			PrimaryAssets.AddUnique(AssetId);
+		}
+		else
+		{
+			OtherAssets.AddUnique(Path);
+		}
+	}
+	if (PrimaryAssets.Num() == 0 && OtherAssets.Num() == 0) return;
+
+	TArray<TSharedPtr<FStreamableHandle>> Handles;
+	if (PrimaryAssets.Num() > 0)
+	{
+		Handles.Add(AssetManager.LoadPrimaryAssets(PrimaryAssets, GetPreloadBundles()));
+	}
+	if (OtherAssets.Num() > 0)
+	{
+		Handles.Add(AssetManager.GetStreamableManager().RequestAsyncLoad(OtherAssets));
+	}
+	Handles.RemoveAll([](const TSharedPtr<FStreamableHandle>& Handle) { return !Handle.IsValid(); });
+	if (Handles.Num() == 0) return;
+
+	TSharedPtr<FStreamableHandle> LevelHandle = AssetManager.GetStreamableManager().CreateCombinedHandle(Handles);
+	if (LevelHandle.IsValid())
+	{
+		LevelHandle->BindCompleteDelegate(FStreamableDelegate::CreateUObject(this, &UAsyncSpawnSubsystem::OnPreloadComplete));
+		PreloadHandles.Add(LevelHandle);
+	}
+}
+
+void UAsyncSpawnSubsystem::OnLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld())
+	{
+		PreloadForLevel(Level);
+	}
+}
+
+void UAsyncSpawnSubsystem::OnPreloadComplete()
+{
+	if (IsPreloadComplete())
+	{
+		UE_LOG(LogTemp, Display, TEXT("Spawn class preload finished %.1f ms after begin play, %.1f MB resident"),
+			(FPlatformTime::Seconds() - PreloadStartTime) * 1000.0, UsedPhysicalMB());
+	}
+}
+
+void UAsyncSpawnSubsystem::SpawnActorAsync(const TSoftClassPtr<AActor>& Class, const FTransform& Transform, const FActorSpawnParameters& SpawnParams, TFunction<void(AActor*)> OnSpawned)
+{
+	if (Class.IsNull()) return;
+
+	USpawnDirectorSubsystem* Director = GetWorld()->GetSubsystem<USpawnDirectorSubsystem>();
+	if (Director == nullptr) return;
+
+	FSpawnRequest Request;
+	Request.Class = Class;
+	Request.Transform = Transform;
+	Request.Owner = SpawnParams.Owner;
+	Request.Instigator = SpawnParams.Instigator;
+	Request.CollisionHandling = SpawnParams.SpawnCollisionHandlingOverride;
+	Request.OnSpawned = MoveTemp(OnSpawned);
+	Director->RequestSpawn(MoveTemp(Request));
+}
@@ -0,0 +1,183 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Spawning/SpawnDirectorSubsystem.h"
+#include "Diagnostics/CombatTelemetrySubsystem.h"
+#include "Diagnostics/HitchDetectorSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "Replay/SessionRecorderSubsystem.h"
+#include "MyProject3/MyProject3.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Director"), STAT_SlashSpawnDirector, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Backlog"), STAT_SlashSpawnBacklog, STATGROUP_Slash);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Init Step Backlog"), STAT_SlashInitStepBacklog, STATGROUP_Slash);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Actors Spawned"), STAT_SlashActorsSpawned, STATGROUP_Slash);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spawn Cost (ms)"), STAT_SlashSpawnCostMs, STATGROUP_Slash);
+
+static TAutoConsoleVariable<float> CVarSpawnBudgetMs(
+	TEXT("slash.SpawnDirector.BudgetMs"),
+	2.f,
+	TEXT("Game thread milliseconds per frame the spawn director spends on spawns and init steps."));
+
+static TAutoConsoleVariable<int32> CVarSpawnRecordedPerFrame(
+	TEXT("slash.SpawnDirector.RecordedPerFrame"),
+	4,
+	TEXT("Spawns and init steps per frame while a session is recorded or replayed, where wall time can't decide it."));
+
+void USpawnDirectorSubsystem::Deinitialize()
+{
+	for (const TSharedPtr<FStreamableHandle>& Handle : PendingLoads)
+	{
+		if (Handle.IsValid()) Handle->CancelHandle();
+	}
+	PendingLoads.Empty();
+	IncomingRequests.Empty();
+	PendingSpawns.Empty();
+	InitSteps.Empty();
+	NumPendingSpawns = 0;
+	NumInitSteps = 0;
+
+	Super::Deinitialize();
+}
+
+bool USpawnDirectorSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId USpawnDirectorSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USpawnDirectorSubsystem, STATGROUP_Tickables);
+}
+
+void USpawnDirectorSubsystem::RequestSpawn(FSpawnRequest&& Request)
+{
+	if (Request.Class.IsNull()) return;
+	IncomingRequests.Enqueue(MoveTemp(Request));
+}
+
+void USpawnDirectorSubsystem::QueueInitStep(AActor* Actor, TFunction<void()> Step)
+{
+	UWorld* World = Actor ? Actor->GetWorld() : nullptr;
+	USpawnDirectorSubsystem* Director = World ? World->GetSubsystem<USpawnDirectorSubsystem>() : nullptr;
+	if (Director == nullptr)
+	{
+		Step();
+		return;
+	}
+
+	Director->InitSteps.Enqueue({ Actor, MoveTemp(Step) });
+	++Director->NumInitSteps;
+}
+
+void USpawnDirectorSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SlashSpawnDirector);
+	SLASH_HITCH_SCOPE(Spawning);
+	Super::Tick(DeltaTime);
+
+	DrainIncoming();
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double Budget = FMath::Max(0.f, CVarSpawnBudgetMs.GetValueOnGameThread()) / 1000.0;
+	// A replay has to spawn on the same frames as the recording did
+	const bool bCountBudget = USessionRecorderSubsystem::IsRecordingOrReplaying(this);
+	const int32 MaxItems = FMath::Max(1, CVarSpawnRecordedPerFrame.GetValueOnGameThread());
+	int32 NumItems = 0;
+
+	// Finish setting up what is already in the world before adding more to it
+	while (NumInitSteps > 0 || NumPendingSpawns > 0)
+	{
+		if (NumItems > 0 && (bCountBudget ? NumItems >= MaxItems : FPlatformTime::Seconds() - StartTime >= Budget)) break;
+		++NumItems;
+
+		if (NumInitSteps > 0)
+		{
+			RunNextInitStep();
+		}
+		else
+		{
+			SpawnNext();
+		}
+	}
+
+	if (NumItems > 0)
+	{
+		INC_FLOAT_STAT_BY(STAT_SlashSpawnCostMs, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+	}
+	SET_DWORD_STAT(STAT_SlashSpawnBacklog, PendingLoads.Num() + NumPendingSpawns);
+	SET_DWORD_STAT(STAT_SlashInitStepBacklog, NumInitSteps);
+}
+
+void USpawnDirectorSubsystem::DrainIncoming()
+{
+	FSpawnRequest Request;
+	while (IncomingRequests.Dequeue(Request))
+	{
+		if (Request.Class.Get())
+		{
+			PendingSpawns.Enqueue(MoveTemp(Request));
+			++NumPendingSpawns;
+			continue;
+		}
+
+		// Never block on a load here, the request joins the queue once its class is in
+		TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+			Request.Class.ToSoftObjectPath(),
+			FStreamableDelegate::CreateWeakLambda(this, [this, Request]() mutable
+			{
+				PendingLoads.RemoveAll([](const TSharedPtr<FStreamableHandle>& Pending) { return !Pending.IsValid() || Pending->HasLoadCompleted(); });
+				PendingSpawns.Enqueue(MoveTemp(Request));
+				++NumPendingSpawns;
+			}),
+			FStreamableManager::AsyncLoadHighPriority);
+
+		if (Handle.IsValid())
+		{
+			PendingLoads.Add(Handle);
+		}
+	}
+}
+
+void USpawnDirectorSubsystem::RunNextInitStep()
+{
+	FInitStep InitStep;
+	if (!InitSteps.Dequeue(InitStep)) return;
+	--NumInitSteps;
+
+	if (IsValid(InitStep.Actor.Get()))
+	{
+		InitStep.Step();
+	}
+}
+
+void USpawnDirectorSubsystem::SpawnNext()
+{
+	FSpawnRequest Request;
+	if (!PendingSpawns.Dequeue(Request)) return;
+	--NumPendingSpawns;
+
+	UClass* Class = Request.Class.Get();
+	UWorld* World = GetWorld();
+	// Whoever asked for the spawn may be gone by now, or the class failed to load
+	if (Class == nullptr || World == nullptr || Request.Owner.IsStale()) return;
+
+	AActor* Actor = World->SpawnActorDeferred<AActor>(Class, Request.Transform, Request.Owner.Get(), Request.Instigator.Get(), Request.CollisionHandling);
+	if (Actor == nullptr) return;
+
+	if (Request.OnConfigure)
+	{
+		Request.OnConfigure(Actor);
+	}
+	Actor->FinishSpawning(Request.Transform);
+	INC_DWORD_STAT(STAT_SlashActorsSpawned);
+	UHitchDetectorSubsystem::NoteSpawn();
+	SLASH_COMBAT_EVENT(Spawn, Actor, Request.Owner.Get(), Request.Transform.GetLocation(), 0.f, 0, 0);
+
+	if (Request.OnSpawned && IsValid(Actor))
+	{
+		Request.OnSpawned(Actor);
+	}
+}
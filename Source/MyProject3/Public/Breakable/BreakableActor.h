@@ -5,12 +5,13 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "Interfaces/HitInterface.h"
+#include "Interfaces/PreloadInterface.h"
 #include "BreakableActor.generated.h"
 
 class UGeometryCollectionComponent;
 
 UCLASS()
-class MYPROJECT3_API ABreakableActor : public AActor, public IHitInterface
+class MYPROJECT3_API ABreakableActor : public AActor, public IHitInterface, public IPreloadInterface
 {
 	GENERATED_BODY()
 	
@@ -18,9 +19,12 @@ public:
 	ABreakableActor();
 	virtual void Tick(float DeltaTime) override;
 	virtual void GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter) override;
+	virtual void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
 	UGeometryCollectionComponent* GeometryCollection;
@@ -28,13 +32,24 @@ protected:
 	UPROPERTY(VisibleAnywhere, BlueprintReadWrite)
 	class UCapsuleComponent* Capsule;
 
+	UPROPERTY(VisibleAnywhere)
+	class UPersistentStateComponent* PersistentState;
+
 private:
 	
 
+	// Soft so every pot doesn't pull in every treasure mesh, they're preloaded with the level instead
 	UPROPERTY(EditAnywhere, Category = "Breakable Properties")
-	TArray<TSubclassOf<class ATreasure>> TreasureClasses;
+	TArray<TSoftClassPtr<class ATreasure>> TreasureClasses;
 	
 
+	UFUNCTION()
+	void OnRep_Broken();
+
+	UPROPERTY(ReplicatedUsing = OnRep_Broken)
 	bool isBroken = false;
 
+public:
+	FORCEINLINE UGeometryCollectionComponent* GetGeometryCollection() const { return GeometryCollection; }
+	FORCEINLINE bool IsBroken() const { return isBroken; }
 };
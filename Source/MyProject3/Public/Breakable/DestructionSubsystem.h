@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "DestructionSubsystem.generated.h"
+
+class ABreakableActor;
+class UGeometryCollection;
+
+/**
+ * Keeps the cost of broken pots bounded. Every fracture is tracked from the moment it breaks,
+ * frozen to kinematic once it has had time to settle and removed once it is past its lifetime
+ * or the debris budget. Breakables far from the camera break into fewer pieces.
+ * Budgets are the slash.Destruction.* console variables.
+ */
+UCLASS()
+class MYPROJECT3_API UDestructionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	void RegisterBreakable(ABreakableActor* Breakable);
+	void UnregisterBreakable(ABreakableActor* Breakable);
+
+	// Called by the breakable when it gets hit, before any field reaches the geometry collection
+	void OnBreakableFractured(ABreakableActor* Breakable);
+
+	// True if a registered breakable is within Radius of Location. Fractured ones count until their
+	// debris freezes and they unregister, so fields keep reaching pieces that are still moving
+	bool HasBreakableWithin(const FVector& Location, float Radius) const;
+
+	FORCEINLINE int32 GetNumActiveFractures() const { return NumActiveFractures; }
+	FORCEINLINE int32 GetNumActiveRigidBodies() const { return NumActiveRigidBodies; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FBodyCounts
+	{
+		int32 Full = 1;
+		int32 Reduced = 1;
+	};
+
+	struct FFracture
+	{
+		TWeakObjectPtr<ABreakableActor> Breakable;
+		double BrokenTime = 0.0;
+		int32 RigidBodies = 0;
+		bool bFrozen = false;
+	};
+
+	void ApplyFractureDetail(ABreakableActor* Breakable, bool bReduced, FFracture& Fracture);
+	void FreezeFracture(FFracture& Fracture);
+	void RemoveFracture(int32 Index);
+	bool GetViewLocation(FVector& OutLocation) const;
+	const FBodyCounts& GetBodyCounts(const UGeometryCollection* RestCollection);
+	void UpdateStats();
+
+	TArray<TWeakObjectPtr<ABreakableActor>> Breakables;
+
+	// Oldest first
+	TArray<FFracture> Fractures;
+
+	TMap<TObjectKey<UGeometryCollection>, FBodyCounts> BodyCountCache;
+
+	int32 NumActiveFractures = 0;
+	int32 NumActiveRigidBodies = 0;
+};
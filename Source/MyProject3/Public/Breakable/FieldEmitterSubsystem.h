@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FieldEmitterSubsystem.generated.h"
+
+class UFieldSystemComponent;
+class UFieldSystemMetaDataFilter;
+class UOperatorField;
+class URadialFalloff;
+class URadialVector;
+
+// One pooled field system component with its nodes already built, only the position changes per impact
+USTRUCT()
+struct FFieldEmitter
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UFieldSystemComponent* Component = nullptr;
+
+	UPROPERTY()
+	URadialFalloff* Strain = nullptr;
+
+	UPROPERTY()
+	URadialFalloff* VelocityFalloff = nullptr;
+
+	UPROPERTY()
+	URadialVector* Velocity = nullptr;
+
+	// Velocity scaled by the falloff
+	UPROPERTY()
+	UOperatorField* FalloffVelocity = nullptr;
+
+	UPROPERTY()
+	UFieldSystemMetaDataFilter* DebrisFilter = nullptr;
+};
+
+/**
+ * Breaks geometry collections where weapons hit without the Blueprint field actors. Impacts are
+ * queued and applied once a frame from a pool of field system components: external strain to
+ * crack the clusters and a falloff velocity to throw the pieces. Impacts with no unbroken
+ * breakable within slash.Fields.Radius are dropped before they cost anything.
+ */
+UCLASS()
+class MYPROJECT3_API UFieldEmitterSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	// Queues the strain and velocity fields for the next batch, returns false if nothing was in range
+	bool QueueImpact(const FVector& Location);
+
+	// Off with slash.Fields.Native 0, the weapon falls back to its Blueprint fields
+	static bool IsEnabled();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void CreatePool(UWorld& InWorld);
+	void ApplyImpact(FFieldEmitter& Emitter, const FVector& Location);
+
+	// Owns the pooled components, nothing else
+	UPROPERTY()
+	AActor* PoolOwner = nullptr;
+
+	UPROPERTY()
+	TArray<FFieldEmitter> Pool;
+
+	TArray<FVector> PendingImpacts;
+	int32 NextEmitter = 0;
+};
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Interfaces/HitInterface.h"
+#include "Interfaces/PreloadInterface.h"
 #include "BaseCharacter.generated.h"
 
 class AWeapon;
@@ -13,16 +14,19 @@ class UAnimMontage;
 
 
 UCLASS()
-class MYPROJECT3_API ABaseCharacter : public ACharacter, public IHitInterface
+class MYPROJECT3_API ABaseCharacter : public ACharacter, public IHitInterface, public IPreloadInterface
 {
 	GENERATED_BODY()
 
 public:
-	ABaseCharacter();
+	ABaseCharacter(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 	virtual void Tick(float DeltaTime) override;
+	virtual void GetPrewarmAssets(TArray<UObject*>& OutAssets) const override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	/** Combat */
 	virtual void GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter) override;
@@ -39,7 +43,8 @@ protected:
 
 	/** Montage */
 	void PlayHitReactMontage(const FName& SectionName);
-	virtual int32 PlayAttackMontage();
+	// Plays the given attack section, or a random one, and returns which
+	virtual int32 PlayAttackMontage(int32 Selection = INDEX_NONE);
 	virtual int32 PlayDeathMontage();
 	void StopAttackMontage();
 
@@ -55,7 +60,28 @@ protected:
 	UFUNCTION(BlueprintCallable)
 	void SetWeaponCollisionEnabled(ECollisionEnabled::Type CollisionEnabled);
 
-	UPROPERTY(VisibleAnywhere, Category = Weapon)
+	/** Network, gameplay runs on the server and these replay the visible parts everywhere */
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastPlayMontageSection(UAnimMontage* Montage, FName SectionName);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastHitReact(FVector_NetQuantize HitterLocation);
+
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastHitEffects(FVector_NetQuantize ImpactPoint);
+
+	UFUNCTION()
+	virtual void OnRep_EquippedWeapon();
+
+	// Where a replicated weapon goes when it shows up on a client
+	virtual FName GetEquippedWeaponSocket() const { return FName("RightHandSocket"); }
+
+	// Montages the owning client already started itself, the server's multicast of them is skipped there
+	virtual bool IsMontagePredictedLocally(const UAnimMontage* Montage) const { return false; }
+
+	FORCEINLINE UAnimMontage* GetAttackMontage() const { return AttackMontage; }
+
+	UPROPERTY(VisibleAnywhere, ReplicatedUsing = OnRep_EquippedWeapon, Category = Weapon)
 	AWeapon* EquippedWeapon;
 
 	UPROPERTY(VisibleAnywhere)
@@ -69,7 +95,7 @@ protected:
 
 private:
 	void PlayMontageSection(UAnimMontage* Montage, const FName& SectionName);
-	int32 PlayRandomMontageSection(UAnimMontage* Montage, const TArray<FName>& SectionNames);
+	int32 PlayRandomMontageSection(UAnimMontage* Montage, const TArray<FName>& SectionNames, int32 Selection = INDEX_NONE);
 
 	UPROPERTY(EditAnywhere, Category = Combat)
 	USoundBase* HitSound;
@@ -17,6 +17,17 @@ enum class EActionState : uint8
 	EAS_EquippingWeapon UMETA(DisplayName = "EquippingWeapon"),
 };
 
+// What the player's input ended up doing, the owning client and the server compare these
+UENUM()
+enum class EPredictedAction : uint8
+{
+	EPA_None,
+	EPA_Attack,
+	EPA_PickUp,
+	EPA_Arm,
+	EPA_Disarm
+};
+
 UENUM(BlueprintType)
 enum EDeathPose
 {
@@ -37,6 +48,7 @@ enum class EEnemyState : uint8
 	EES_Dead UMETA(DisplayName = "Dead"),
 	EES_Patrolling UMETA(DisplayName = "Patrolling"),
 	EES_Chasing UMETA(DisplayName = "Chasing"),
+	EES_Strafing UMETA(DisplayName = "Strafing"),
 	EES_Attacking UMETA(DisplayName = "Attacking"),
 	EES_Engaged UMETA(DisplayName = "Engaged")
 };
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "BaseCharacter.h"
 #include "InputActionValue.h"
 #include "CharacterTypes.h"
+#include "Replay/SessionRecorderSubsystem.h"
 #include "SlashCharacter.generated.h"
 
 class UInputMappingContext;
@@ -13,9 +14,20 @@ class UInputAction;
 class USpringArmComponent;
 class UCameraComponent;
 class UGroomComponent;
+class UGroomPolicyComponent;
 class AItem;
 class UAnimMontage;
 
+namespace SaveFile { struct FPlayer; }
+
+// An action the owning client ran ahead of the server, kept until the server answers for it
+struct FPredictedAction
+{
+	TWeakObjectPtr<AWeapon> WeaponBefore;
+	uint8 Id = 0;
+	EPredictedAction Action = EPredictedAction::EPA_None;
+};
+
 UCLASS()
 class MYPROJECT3_API ASlashCharacter : public ABaseCharacter
 {
@@ -26,9 +38,27 @@ public:
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 	// _Implementation is added when we make it a blueprint native event in hitinterface.h
 	virtual void GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter) override;
+	virtual void GetPrewarmAssets(TArray<UObject*>& OutAssets) const override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Test traffic for slash.LagComp.ProbeInterval, where this client sees Target at ClientTime
+	UFUNCTION(Server, Unreliable)
+	void ServerLagCompProbe(ACharacter* Target, FVector_NetQuantize SeenLocation, double ClientTime);
+
+	void DumpPredictionStats() const;
+
+	// Runs a recorded input through the same handler the live one went to
+	void ReplayInput(ESessionInput Type, const FVector2D& Value);
+
+	void GetSaveState(SaveFile::FPlayer& OutPlayer) const;
+	void ApplySaveState(const SaveFile::FPlayer& Player);
+
+	// From treasure, kept on the attributes so it is saved with them
+	void AddGold(int32 Amount);
 
 protected:
 	virtual void BeginPlay() override;
+	virtual void PreRegisterAllComponents() override;
 	/**
 	* Callbacks for input
 	**/
@@ -37,9 +67,35 @@ protected:
 	void Turn(float Value);
 	void LookUp(float Value);
 	void EKeyPressed();
+	void AttackPressed();
+	void JumpPressed();
+
+	/**
+	* Network, the owning client runs attacks and equips straight away and tells the server which
+	* action it predicted. The server runs it for real and answers with what it did and its states,
+	* a different answer rolls the prediction back.
+	**/
+	UFUNCTION(Server, Reliable)
+	void ServerEKeyPressed(uint8 PredictionId);
+
+	UFUNCTION(Server, Reliable)
+	void ServerAttack(uint8 PredictionId, int8 AttackSection);
+
+	UFUNCTION(Client, Reliable)
+	void ClientAckAction(uint8 PredictionId, EPredictedAction ServerAction, EActionState ServerActionState, ECharacterState ServerCharacterState);
+
+	UFUNCTION()
+	void OnRep_AuthState();
+
+	virtual FName GetEquippedWeaponSocket() const override;
+	virtual bool IsMontagePredictedLocally(const UAnimMontage* Montage) const override;
 	
 	// Combat
 	void EquipWeapon(AWeapon* Weapon);
+	EPredictedAction PerformEKeyAction();
+	int32 PerformAttack(int32 AttackSection);
+	void SetActionState(EActionState NewState);
+	void SetCharacterState(ECharacterState NewState);
 	virtual void Attack() override;
 	virtual void AttackEnd() override;
 	virtual bool CanAttack() override;
@@ -98,18 +154,45 @@ private:
 	UPROPERTY(VisibleAnywhere, Category = Hair);
 	UGroomComponent* Eyebrows;
 
+	UPROPERTY(VisibleAnywhere, Category = Hair);
+	UGroomPolicyComponent* GroomPolicy;
+
 	UPROPERTY(VisibleInstanceOnly);
 	AItem* OverlappingItem;
 
 	UPROPERTY(EditDefaultsOnly, Category = Montages);
 	UAnimMontage* EquipMontage;
 
+	// Everyone else gets these straight from the server, the owning client predicts its own
+	UPROPERTY(Replicated);
 	ECharacterState CharacterState = ECharacterState::ECS_Unequipped;
 
-	UPROPERTY(BlueprintReadWrite, meta = (AllowPrivateAccess = "true"));
+	UPROPERTY(BlueprintReadWrite, Replicated, meta = (AllowPrivateAccess = "true"));
 	EActionState ActionState = EActionState::EAS_Unoccupied;
 
+	// The server's states, only sent to the owning client and taken over once nothing is in flight
+	UPROPERTY(ReplicatedUsing = OnRep_AuthState);
+	ECharacterState AuthCharacterState = ECharacterState::ECS_Unequipped;
+
+	UPROPERTY(ReplicatedUsing = OnRep_AuthState);
+	EActionState AuthActionState = EActionState::EAS_Unoccupied;
+
+	/** Prediction */
+	uint8 BeginPrediction(EPredictedAction Action, AWeapon* WeaponBefore);
+	void CatchUpWithOwner();
+	void RollBackPrediction(const FPredictedAction& Mispredicted, EPredictedAction ServerAction, EActionState ServerActionState, ECharacterState ServerCharacterState);
+
+	static constexpr int32 MaxPendingActions = 16;
+	TArray<FPredictedAction, TInlineAllocator<MaxPendingActions>> PendingActions;
+	uint8 NextPredictionId = 0;
+	int32 NumPredictedActions = 0;
+	int32 NumMispredictions = 0;
+
+	// Set while the owning client plays its own predicted montage so the echo check lets it through
+	bool bPlayingPredictedMontage = false;
+
 public:
 	FORCEINLINE void SetOverlappingItem(AItem* Item) { OverlappingItem = Item; }
 	FORCEINLINE ECharacterState GetCharaterState() const { return this->CharacterState; }
+	FORCEINLINE AWeapon* GetEquippedWeapon() const { return EquippedWeapon; }
 };
@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// Batch versions of CombatCore over struct of arrays data, for running thousands of enemies at
+// once. Each has a scalar loop and a 4 wide SSE2 one that gives the same results; without SSE2 the
+// Simd versions run the scalar loop.
+
+#include "CombatCore/CombatCore.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COMBATCORE_SSE2 1
+#include <emmintrin.h>
+#else
+#define COMBATCORE_SSE2 0
+#endif
+
+namespace CombatCore
+{
+	// Count entries in each array
+	struct FVec3Array
+	{
+		const float* X = nullptr;
+		const float* Y = nullptr;
+		const float* Z = nullptr;
+	};
+
+	struct FMutableVec3Array
+	{
+		float* X = nullptr;
+		float* Y = nullptr;
+		float* Z = nullptr;
+	};
+
+	/** Scalar */
+
+	inline void ClassifyHitDirectionsScalar(int32_t Count, const float* ForwardX, const float* ForwardY, const float* ToHitX, const float* ToHitY, EHitDirection* OutDirections)
+	{
+		for (int32_t Index = 0; Index < Count; ++Index)
+		{
+			OutDirections[Index] = ClassifyHitDirection(ForwardX[Index], ForwardY[Index], ToHitX[Index], ToHitY[Index]);
+		}
+	}
+
+	inline void AreInRangeScalar(int32_t Count, const FVec3Array& Offsets, float Radius, uint8_t* OutInRange)
+	{
+		for (int32_t Index = 0; Index < Count; ++Index)
+		{
+			OutInRange[Index] = IsInRange({ Offsets.X[Index], Offsets.Y[Index], Offsets.Z[Index] }, Radius) ? 1 : 0;
+		}
+	}
+
+	inline void GetTranslationWarpOffsetsScalar(int32_t Count, const FVec3Array& FromTargets, float WarpDistance, const FMutableVec3Array& OutOffsets)
+	{
+		for (int32_t Index = 0; Index < Count; ++Index)
+		{
+			const FVec3 Offset = GetTranslationWarpOffset({ FromTargets.X[Index], FromTargets.Y[Index], FromTargets.Z[Index] }, WarpDistance);
+			OutOffsets.X[Index] = Offset.X;
+			OutOffsets.Y[Index] = Offset.Y;
+			OutOffsets.Z[Index] = Offset.Z;
+		}
+	}
+
+	inline void DecideCombatScalar(int32_t Count, const float* DistanceSquared, const uint8_t* Flags, float CombatRadius, float AttackRadius, ECombatDecision* OutDecisions)
+	{
+		for (int32_t Index = 0; Index < Count; ++Index)
+		{
+			OutDecisions[Index] = DecideCombat(DistanceSquared[Index], CombatRadius, AttackRadius, Flags[Index]);
+		}
+	}
+
+	inline void ApplyDamageScalar(int32_t Count, float* Health, const float* Damage, const float* MaxHealth)
+	{
+		for (int32_t Index = 0; Index < Count; ++Index)
+		{
+			Health[Index] = ApplyDamage(Health[Index], Damage[Index], MaxHealth[Index]);
+		}
+	}
+
+	/** SIMD */
+
+#if COMBATCORE_SSE2
+	namespace SimdPrivate
+	{
+		// Mask ? A : B, per 32 bit lane
+		inline __m128i Select(__m128i Mask, __m128i A, __m128i B)
+		{
+			return _mm_or_si128(_mm_and_si128(Mask, A), _mm_andnot_si128(Mask, B));
+		}
+
+		// Low byte of each 32 bit lane, the values all fit
+		inline void StoreBytes(__m128i Lanes, void* Out)
+		{
+			const __m128i Packed16 = _mm_packs_epi32(Lanes, Lanes);
+			const int32_t Packed8 = _mm_cvtsi128_si32(_mm_packus_epi16(Packed16, Packed16));
+			std::memcpy(Out, &Packed8, sizeof(Packed8));
+		}
+
+		inline __m128i LoadBytes(const void* In)
+		{
+			int32_t Bytes;
+			std::memcpy(&Bytes, In, sizeof(Bytes));
+			const __m128i Zero = _mm_setzero_si128();
+			return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(Bytes), Zero), Zero);
+		}
+
+		inline __m128 LengthSquared(__m128 X, __m128 Y, __m128 Z)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(X, X), _mm_mul_ps(Y, Y)), _mm_mul_ps(Z, Z));
+		}
+	}
+#endif
+
+	inline void ClassifyHitDirectionsSimd(int32_t Count, const float* ForwardX, const float* ForwardY, const float* ToHitX, const float* ToHitY, EHitDirection* OutDirections)
+	{
+		int32_t Index = 0;
+#if COMBATCORE_SSE2
+		using namespace SimdPrivate;
+		const __m128 Zero = _mm_setzero_ps();
+		const __m128 Small = _mm_set1_ps(SmallNumber);
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			const __m128 FX = _mm_loadu_ps(ForwardX + Index);
+			const __m128 FY = _mm_loadu_ps(ForwardY + Index);
+			const __m128 TX = _mm_loadu_ps(ToHitX + Index);
+			const __m128 TY = _mm_loadu_ps(ToHitY + Index);
+			const __m128 Dot = _mm_add_ps(_mm_mul_ps(FX, TX), _mm_mul_ps(FY, TY));
+			const __m128 Cross = _mm_sub_ps(_mm_mul_ps(FX, TY), _mm_mul_ps(FY, TX));
+			const __m128 Sum = _mm_add_ps(Dot, Cross);
+			const __m128 Diff = _mm_sub_ps(Dot, Cross);
+
+			// The three are exclusive, whatever is in none of them is Back
+			const __m128i Front = _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(Sum, Zero), _mm_cmpgt_ps(Diff, Zero)));
+			const __m128i Right = _mm_castps_si128(_mm_and_ps(_mm_cmple_ps(Diff, Zero), _mm_cmpgt_ps(Sum, Zero)));
+			const __m128i Left = _mm_castps_si128(_mm_and_ps(_mm_cmplt_ps(Sum, Zero), _mm_cmpge_ps(Diff, Zero)));
+			const __m128i Degenerate = _mm_castps_si128(_mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(TX, TX), _mm_mul_ps(TY, TY)), Small));
+
+			__m128i Result = _mm_set1_epi32(static_cast<int32_t>(EHitDirection::Back));
+			Result = Select(Front, _mm_set1_epi32(static_cast<int32_t>(EHitDirection::Front)), Result);
+			Result = Select(Right, _mm_set1_epi32(static_cast<int32_t>(EHitDirection::Right)), Result);
+			Result = Select(Left, _mm_set1_epi32(static_cast<int32_t>(EHitDirection::Left)), Result);
+			Result = Select(Degenerate, _mm_set1_epi32(static_cast<int32_t>(EHitDirection::Right)), Result);
+			StoreBytes(Result, OutDirections + Index);
+		}
+#endif
+		ClassifyHitDirectionsScalar(Count - Index, ForwardX + Index, ForwardY + Index, ToHitX + Index, ToHitY + Index, OutDirections + Index);
+	}
+
+	inline void AreInRangeSimd(int32_t Count, const FVec3Array& Offsets, float Radius, uint8_t* OutInRange)
+	{
+		int32_t Index = 0;
+#if COMBATCORE_SSE2
+		using namespace SimdPrivate;
+		const __m128 RadiusSquared = _mm_set1_ps(Radius * Radius);
+		auto InRangeMask = [&Offsets, RadiusSquared](int32_t First)
+		{
+			const __m128 SquaredLength = LengthSquared(_mm_loadu_ps(Offsets.X + First), _mm_loadu_ps(Offsets.Y + First), _mm_loadu_ps(Offsets.Z + First));
+			return _mm_castps_si128(_mm_cmple_ps(SquaredLength, RadiusSquared));
+		};
+
+		// The work per entity is tiny, 16 at a time so the masks pack straight down to one store
+		const __m128i One = _mm_set1_epi8(1);
+		for (; Index + 16 <= Count; Index += 16)
+		{
+			const __m128i Low = _mm_packs_epi32(InRangeMask(Index), InRangeMask(Index + 4));
+			const __m128i High = _mm_packs_epi32(InRangeMask(Index + 8), InRangeMask(Index + 12));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(OutInRange + Index), _mm_and_si128(_mm_packs_epi16(Low, High), One));
+		}
+#endif
+		const FVec3Array Rest = { Offsets.X + Index, Offsets.Y + Index, Offsets.Z + Index };
+		AreInRangeScalar(Count - Index, Rest, Radius, OutInRange + Index);
+	}
+
+	inline void GetTranslationWarpOffsetsSimd(int32_t Count, const FVec3Array& FromTargets, float WarpDistance, const FMutableVec3Array& OutOffsets)
+	{
+		int32_t Index = 0;
+#if COMBATCORE_SSE2
+		using namespace SimdPrivate;
+		const __m128 Distance = _mm_set1_ps(WarpDistance);
+		const __m128 Small = _mm_set1_ps(SmallNumber);
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			const __m128 X = _mm_loadu_ps(FromTargets.X + Index);
+			const __m128 Y = _mm_loadu_ps(FromTargets.Y + Index);
+			const __m128 Z = _mm_loadu_ps(FromTargets.Z + Index);
+			const __m128 SquaredLength = LengthSquared(X, Y, Z);
+
+			// Lanes with no direction get inf or nan here, the mask turns them into zero offsets
+			const __m128 HasDirection = _mm_cmpge_ps(SquaredLength, Small);
+			const __m128 Scale = _mm_div_ps(Distance, _mm_sqrt_ps(SquaredLength));
+			_mm_storeu_ps(OutOffsets.X + Index, _mm_and_ps(HasDirection, _mm_mul_ps(X, Scale)));
+			_mm_storeu_ps(OutOffsets.Y + Index, _mm_and_ps(HasDirection, _mm_mul_ps(Y, Scale)));
+			_mm_storeu_ps(OutOffsets.Z + Index, _mm_and_ps(HasDirection, _mm_mul_ps(Z, Scale)));
+		}
+#endif
+		const FVec3Array Rest = { FromTargets.X + Index, FromTargets.Y + Index, FromTargets.Z + Index };
+		const FMutableVec3Array RestOut = { OutOffsets.X + Index, OutOffsets.Y + Index, OutOffsets.Z + Index };
+		GetTranslationWarpOffsetsScalar(Count - Index, Rest, WarpDistance, RestOut);
+	}
+
+	inline void DecideCombatSimd(int32_t Count, const float* DistanceSquared, const uint8_t* Flags, float CombatRadius, float AttackRadius, ECombatDecision* OutDecisions)
+	{
+		int32_t Index = 0;
+#if COMBATCORE_SSE2
+		using namespace SimdPrivate;
+		const __m128 CombatRadiusSquared = _mm_set1_ps(CombatRadius * CombatRadius);
+		const __m128 AttackRadiusSquared = _mm_set1_ps(AttackRadius * AttackRadius);
+		const __m128i Engaged = _mm_set1_epi32(CombatFlags::Engaged);
+		const __m128i Chasing = _mm_set1_epi32(CombatFlags::Chasing);
+		const __m128i Busy = _mm_set1_epi32(CombatFlags::Attacking | CombatFlags::Engaged | CombatFlags::Dead);
+		const __m128i AllSet = _mm_set1_epi32(-1);
+		auto Decision = [](ECombatDecision Value) { return _mm_set1_epi32(static_cast<int32_t>(Value)); };
+
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			const __m128 Distances = _mm_loadu_ps(DistanceSquared + Index);
+			const __m128i LaneFlags = LoadBytes(Flags + Index);
+			const __m128i IsEngaged = _mm_cmpeq_epi32(_mm_and_si128(LaneFlags, Engaged), Engaged);
+			const __m128i IsChasing = _mm_cmpeq_epi32(_mm_and_si128(LaneFlags, Chasing), Chasing);
+			const __m128i IsFree = _mm_cmpeq_epi32(_mm_and_si128(LaneFlags, Busy), _mm_setzero_si128());
+			const __m128i OutsideCombat = _mm_castps_si128(_mm_cmpgt_ps(Distances, CombatRadiusSquared));
+			const __m128i InsideAttack = _mm_castps_si128(_mm_cmple_ps(Distances, AttackRadiusSquared));
+
+			// Built up from the last branch of DecideCombat to the first, so the first one that applies wins
+			__m128i Result = _mm_and_si128(_mm_and_si128(InsideAttack, IsFree), Decision(ECombatDecision::Attack));
+			const __m128i ShouldChase = _mm_andnot_si128(IsChasing, _mm_andnot_si128(InsideAttack, AllSet));
+			Result = Select(ShouldChase, Select(IsEngaged, Decision(ECombatDecision::StopAttacking), Decision(ECombatDecision::Chase)), Result);
+			Result = Select(OutsideCombat, Select(IsEngaged, Decision(ECombatDecision::LoseInterest), Decision(ECombatDecision::Patrol)), Result);
+			StoreBytes(Result, OutDecisions + Index);
+		}
+#endif
+		DecideCombatScalar(Count - Index, DistanceSquared + Index, Flags + Index, CombatRadius, AttackRadius, OutDecisions + Index);
+	}
+
+	inline void ApplyDamageSimd(int32_t Count, float* Health, const float* Damage, const float* MaxHealth)
+	{
+		int32_t Index = 0;
+#if COMBATCORE_SSE2
+		const __m128 Zero = _mm_setzero_ps();
+		for (; Index + 4 <= Count; Index += 4)
+		{
+			const __m128 NewHealth = _mm_sub_ps(_mm_loadu_ps(Health + Index), _mm_loadu_ps(Damage + Index));
+			_mm_storeu_ps(Health + Index, _mm_min_ps(_mm_max_ps(NewHealth, Zero), _mm_loadu_ps(MaxHealth + Index)));
+		}
+#endif
+		ApplyDamageScalar(Count - Index, Health + Index, Damage + Index, MaxHealth + Index);
+	}
+}
@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+// The combat and AI math with nothing of the engine in it, so the same code builds into the game
+// module and into Tools/CombatCoreBench with plain CMake. Positions come in relative to each other
+// (offsets), which keeps large world coordinates intact on the way down to float.
+
+#include <cmath>
+#include <cstdint>
+
+namespace CombatCore
+{
+	struct FVec3
+	{
+		float X = 0.f;
+		float Y = 0.f;
+		float Z = 0.f;
+	};
+
+	// Which side a hit came from, relative to where the character faces
+	enum class EHitDirection : uint8_t
+	{
+		Front,
+		Left,
+		Right,
+		Back
+	};
+
+	// What the enemy AI does about its combat target this tick
+	enum class ECombatDecision : uint8_t
+	{
+		None,
+		// Target left the combat radius mid swing, stop attacking and forget it
+		LoseInterest,
+		// Same, then go back to patrolling
+		Patrol,
+		// Target left the attack radius mid swing, only stop attacking
+		StopAttacking,
+		Chase,
+		Attack
+	};
+
+	// Enemy state bits the combat decision depends on
+	namespace CombatFlags
+	{
+		constexpr uint8_t Chasing = 1 << 0;
+		constexpr uint8_t Attacking = 1 << 1;
+		constexpr uint8_t Engaged = 1 << 2;
+		constexpr uint8_t Dead = 1 << 3;
+	}
+
+	// Shorter than this and a vector has no direction, same as the engine's SMALL_NUMBER
+	constexpr float SmallNumber = 1.e-8f;
+
+	inline float LengthSquared(const FVec3& V)
+	{
+		return V.X * V.X + V.Y * V.Y + V.Z * V.Z;
+	}
+
+	inline bool IsInRange(const FVec3& Offset, float Radius)
+	{
+		return LengthSquared(Offset) <= Radius * Radius;
+	}
+
+	// Only the signs of the dot and cross products matter, so nothing needs normalizing.
+	// Front is [-45, 45) degrees, Right [45, 135), Left [-135, -45) and Back the rest.
+	// A hit at the character's own location is Right, where the angle based version ended up with it.
+	inline EHitDirection ClassifyHitDirection(float ForwardX, float ForwardY, float ToHitX, float ToHitY)
+	{
+		if (ToHitX * ToHitX + ToHitY * ToHitY < SmallNumber) return EHitDirection::Right;
+
+		const float Dot = ForwardX * ToHitX + ForwardY * ToHitY;
+		const float Cross = ForwardX * ToHitY - ForwardY * ToHitX;
+		// Proportional to cos(Theta - 45) and cos(Theta + 45)
+		const float Sum = Dot + Cross;
+		const float Diff = Dot - Cross;
+
+		if (Sum >= 0.f && Diff > 0.f) return EHitDirection::Front;
+		if (Diff <= 0.f && Sum > 0.f) return EHitDirection::Right;
+		if (Sum < 0.f && Diff >= 0.f) return EHitDirection::Left;
+		return EHitDirection::Back;
+	}
+
+	// Where to stand to hit a target: WarpDistance away from it, on our side. FromTarget is our location minus the target's
+	inline FVec3 GetTranslationWarpOffset(const FVec3& FromTarget, float WarpDistance)
+	{
+		const float SquaredLength = LengthSquared(FromTarget);
+		if (SquaredLength < SmallNumber) return FVec3();
+
+		const float Scale = WarpDistance / std::sqrt(SquaredLength);
+		return { FromTarget.X * Scale, FromTarget.Y * Scale, FromTarget.Z * Scale };
+	}
+
+	// The enemy's combat target check, DistanceSquared is huge when there is no target
+	inline ECombatDecision DecideCombat(float DistanceSquared, float CombatRadius, float AttackRadius, uint8_t Flags)
+	{
+		const bool bEngaged = (Flags & CombatFlags::Engaged) != 0;
+		if (DistanceSquared > CombatRadius * CombatRadius)
+		{
+			return bEngaged ? ECombatDecision::LoseInterest : ECombatDecision::Patrol;
+		}
+
+		const bool bInsideAttackRadius = DistanceSquared <= AttackRadius * AttackRadius;
+		// Don't spam setting the chasing state
+		if (!bInsideAttackRadius && (Flags & CombatFlags::Chasing) == 0)
+		{
+			return bEngaged ? ECombatDecision::StopAttacking : ECombatDecision::Chase;
+		}
+
+		const uint8_t Busy = CombatFlags::Attacking | CombatFlags::Engaged | CombatFlags::Dead;
+		return bInsideAttackRadius && (Flags & Busy) == 0 ? ECombatDecision::Attack : ECombatDecision::None;
+	}
+
+	// Health minus damage, clamped like FMath::Clamp(Health - Damage, 0, MaxHealth)
+	inline float ApplyDamage(float Health, float Damage, float MaxHealth)
+	{
+		const float NewHealth = Health - Damage;
+		return NewHealth < 0.f ? 0.f : (NewHealth < MaxHealth ? NewHealth : MaxHealth);
+	}
+
+	// Health percent as a byte for replication, anything still alive keeps at least one step
+	inline uint8_t QuantizeHealth(float Health, float MaxHealth)
+	{
+		float Percent = Health / MaxHealth;
+		Percent = Percent < 0.f ? 0.f : (Percent < 1.f ? Percent : 1.f);
+		const uint8_t Quantized = static_cast<uint8_t>(std::floor(Percent * 255.f + 0.5f));
+		if (Health <= 0.f) return 0;
+		return Quantized > 1 ? Quantized : 1;
+	}
+}
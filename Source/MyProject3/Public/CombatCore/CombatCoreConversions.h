@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CombatCore/CombatCore.h"
+
+// The engine side of CombatCore, pass offsets rather than world locations so floats are enough
+namespace CombatCore
+{
+	FORCEINLINE FVec3 ToCore(const FVector& Vector)
+	{
+		return { static_cast<float>(Vector.X), static_cast<float>(Vector.Y), static_cast<float>(Vector.Z) };
+	}
+
+	FORCEINLINE FVector ToVector(const FVec3& Vector)
+	{
+		return FVector(Vector.X, Vector.Y, Vector.Z);
+	}
+}
@@ -6,6 +6,7 @@
 #include "Components/ActorComponent.h"
 #include "AttributeComponent.generated.h"
 
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnHealthChanged, float /*HealthPercent*/);
 
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class MYPROJECT3_API UAttributeComponent : public UActorComponent
@@ -15,19 +16,39 @@ class MYPROJECT3_API UAttributeComponent : public UActorComponent
 public:	
 	UAttributeComponent();
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Fires on clients when replicated health arrives, the server already knows when it changes health
+	FOnHealthChanged OnHealthChanged;
 
 protected:
 	virtual void BeginPlay() override;
 
 private:
+	void UpdateReplicatedHealth();
+
+	UFUNCTION()
+	void OnRep_ReplicatedHealth();
+
 	UPROPERTY(EditAnywhere, Category = "Actor Attributes")
 	float Health;
+
+	// Health percent as a byte, clients only need it for the health bar and alive checks
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedHealth)
+	uint8 ReplicatedHealth = 255;
 	
 	UPROPERTY(EditAnywhere, Category = "Actor Attributes")
 	float MaxHealth;
 
+	UPROPERTY(VisibleAnywhere, Category = "Actor Attributes")
+	int32 Gold = 0;
+
 public:
 	void ReceiveDamage(float Damage);
 	float GetHealthPercent();
+	void SetHealthPercent(float Percent);
 	bool IsAlive();
+	void AddGold(int32 Amount);
+	FORCEINLINE int32 GetGold() const { return Gold; }
+	FORCEINLINE void SetGold(int32 Amount) { Gold = Amount; }
 };
@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "GroomPolicyComponent.generated.h"
+
+class UGroomComponent;
+
+UENUM(BlueprintType)
+enum class EGroomDetail : uint8
+{
+	EGD_Simulated UMETA(DisplayName = "Simulated Strands"),
+	EGD_Strands UMETA(DisplayName = "Strands"),
+	EGD_Cards UMETA(DisplayName = "Cards"),
+	EGD_Mesh UMETA(DisplayName = "Mesh"),
+	EGD_Hidden UMETA(DisplayName = "Hidden")
+};
+
+/**
+ * Picks how much the owner's grooms cost a few times a second: simulated strands up close,
+ * plain strands, then cards and mesh LODs as they shrink on screen, and hidden with their
+ * tick off when the owner isn't rendered. slash.Groom.Quality caps the best detail allowed.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class MYPROJECT3_API UGroomPolicyComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UGroomPolicyComponent();
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	void AddGroom(UGroomComponent* Groom);
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	EGroomDetail ChooseDetail(const UGroomComponent* Groom, const FVector& ViewLocation, float TanHalfFOV) const;
+	void ApplyDetail(UGroomComponent* Groom, EGroomDetail Detail);
+	EGroomDetail GetBestAllowedDetail() const;
+
+	UPROPERTY()
+	TArray<UGroomComponent*> Grooms;
+
+	// Detail applied to each entry of Grooms, unset until the first update
+	TArray<TOptional<EGroomDetail>> AppliedDetail;
+
+	// Screen sizes are the groom bounds radius over half the screen width
+	UPROPERTY(EditAnywhere, Category = "Groom LOD")
+	float SimulationScreenSize = 0.3f;
+
+	UPROPERTY(EditAnywhere, Category = "Groom LOD")
+	float StrandsScreenSize = 0.12f;
+
+	UPROPERTY(EditAnywhere, Category = "Groom LOD")
+	float CardsScreenSize = 0.04f;
+
+	UPROPERTY(EditAnywhere, Category = "Groom LOD")
+	float MaxDrawDistance = 6000.f;
+
+	UPROPERTY(EditAnywhere, Category = "Groom LOD")
+	int32 CardsLOD = 1;
+
+	UPROPERTY(EditAnywhere, Category = "Groom LOD")
+	int32 MeshLOD = 2;
+
+	// How long the owner can go unrendered before its grooms are hidden
+	UPROPERTY(EditAnywhere, Category = "Groom LOD")
+	float OffscreenTime = 0.5f;
+};
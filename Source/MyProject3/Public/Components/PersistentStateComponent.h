@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Persistence/ActorStateSubsystem.h"
+#include "PersistentStateComponent.generated.h"
+
+/**
+ * Gives a level placed actor a stable guid so its gameplay state survives world partition
+ * streaming. The guid is assigned in the editor, actors spawned at runtime don't have one
+ * and are not tracked.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class MYPROJECT3_API UPersistentStateComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UPersistentStateComponent();
+
+#if WITH_EDITOR
+	virtual void OnRegister() override;
+	virtual void PostEditImport() override;
+#endif
+
+	bool LoadState(FPersistentActorState& OutState) const;
+	void SaveState(const FPersistentActorState& State) const;
+
+	// Reads the stored state (or the default one) so callers can change a single field
+	FPersistentActorState GetState() const;
+
+	FORCEINLINE bool HasPersistentGuid() const { return PersistentGuid.IsValid(); }
+	FORCEINLINE const FGuid& GetPersistentGuid() const { return PersistentGuid; }
+
+private:
+	UActorStateSubsystem* GetActorStateSubsystem() const;
+
+	// Reset when the actor is duplicated so copies get their own, kept for PIE
+	UPROPERTY(VisibleAnywhere, NonPIEDuplicateTransient, Category = "Persistence")
+	FGuid PersistentGuid;
+};
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tasks/Task.h"
+#include "CombatTelemetrySubsystem.generated.h"
+
+// Off in shipping unless the target defines it, then every SLASH_COMBAT_EVENT compiles to nothing
+#ifndef SLASH_COMBAT_TELEMETRY
+#define SLASH_COMBAT_TELEMETRY !UE_BUILD_SHIPPING
+#endif
+
+enum class ECombatEvent : uint8
+{
+	// Subject was hit by Other at Location, Value is Subject's health percent after it
+	Hit,
+	// Detail is the new EEnemyState, PreviousDetail the old one
+	StateChange,
+	// Subject was killed by Other
+	Death,
+	// Subject was spawned for Other
+	Spawn
+};
+
+/**
+ * Telemetry file layout. A header followed by records until the end of the file. Actors are
+ * their UObject unique ids, only meaningful within one run.
+ */
+namespace CombatTelemetry
+{
+	constexpr uint32 Magic = 0x4C544353; // "SCTL"
+	constexpr uint16 Version = 2;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint16 Version;
+		uint16 RecordSize;
+		// Turns record cycles into seconds
+		double SecondsPerCycle;
+	};
+
+	struct FRecord
+	{
+		uint64 Cycles;
+		uint32 Frame;
+		uint32 Subject;
+		uint32 Other;
+		FVector3f Location;
+		float Value;
+		ECombatEvent Type;
+		uint8 Detail;
+		uint8 PreviousDetail;
+		uint8 Padding;
+	};
+
+	static_assert(sizeof(FHeader) == 16 && sizeof(FRecord) == 40, "Telemetry records are written as is");
+}
+
+#if SLASH_COMBAT_TELEMETRY
+// Records a combat event from any thread, arguments aren't evaluated when telemetry is compiled out
+#define SLASH_COMBAT_EVENT(Type, Subject, Other, Location, Value, Detail, PreviousDetail) \
+	UCombatTelemetrySubsystem::Record(ECombatEvent::Type, Subject, Other, Location, Value, Detail, PreviousDetail)
+#else
+#define SLASH_COMBAT_EVENT(Type, Subject, Other, Location, Value, Detail, PreviousDetail)
+#endif
+
+/**
+ * Combat events as fixed size binary records instead of log lines. Record copies 40 bytes into
+ * a ring owned by the calling thread, with no lock and no formatting; a full ring drops the event
+ * and counts it. About once a second a background task drains every ring into
+ * Saved/Profiling/CombatTelemetry. Each event also goes to the SlashCombat trace channel, so
+ * -trace=default,SlashCombat puts them in the Insights session next to the frame timing.
+ * slash.Telemetry.Enabled 0 stops recording at runtime.
+ */
+UCLASS()
+class MYPROJECT3_API UCombatTelemetrySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** <FTickableGameObject> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </FTickableGameObject> */
+
+	static void Record(ECombatEvent Type, const AActor* Subject, const AActor* Other, const FVector& Location, float Value, uint8 Detail, uint8 PreviousDetail);
+
+	// Drains the rings now and waits for the file write
+	void Flush();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Runs on the flush task, the only place the rings are drained and the file is touched
+	void WriteRecords();
+
+	bool bWriter = false;
+	float TimeSinceFlush = 0.f;
+	UE::Tasks::FTask FlushTask;
+
+	FString Path;
+	TUniquePtr<FArchive> File;
+	TArray<CombatTelemetry::FRecord> Drained;
+	uint64 NumWritten = 0;
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HitchDetectorSubsystem.generated.h"
+
+// Gameplay systems timed every frame, scopes are inclusive so nested ones count twice
+enum class EHitchSystem : uint8
+{
+	AI,
+	Melee,
+	Movement,
+	Destruction,
+	Spawning,
+	LagComp,
+	Corpses,
+
+	Count
+};
+
+// Times the rest of the scope into the current frame's entry for System, works in shipping
+#define SLASH_HITCH_SCOPE(System) FHitchScope PREPROCESSOR_JOIN(HitchScope_, __LINE__)(EHitchSystem::System)
+
+/**
+ * Keeps the last few seconds of per system game thread times, GC time and spawn counts in a ring
+ * buffer. A frame longer than slash.Hitch.ThresholdMs writes the buffer and what the game was doing
+ * (enemies per state, swings in progress, fractures, spawns, GC) to Saved/Hitches. Cheap enough to
+ * leave on: a few timer reads per system and one ring entry per frame.
+ */
+UCLASS()
+class MYPROJECT3_API UHitchDetectorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** <FTickableGameObject> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </FTickableGameObject> */
+
+	static void AddSystemCycles(EHitchSystem System, uint64 Cycles);
+	static void NoteSpawn();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FHitchFrame
+	{
+		uint64 FrameNumber = 0;
+		float FrameMs = 0.f;
+		float GCMs = 0.f;
+		float SystemMs[static_cast<int32>(EHitchSystem::Count)] = {};
+		uint32 Spawns = 0;
+	};
+
+	static constexpr int32 RingSize = 512;
+
+	void CloseFrame(FHitchFrame& Frame, double FrameMs);
+	void DumpHitch(const FHitchFrame& Hitch);
+	FString DescribeContext(const FHitchFrame& Hitch) const;
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	// Filled by the scopes between two ticks, game thread only
+	static uint64 FrameCycles[static_cast<int32>(EHitchSystem::Count)];
+	static uint32 FrameSpawns;
+	static double FrameGCSeconds;
+
+	TArray<FHitchFrame> Ring;
+	int32 RingHead = 0;
+	int32 RingCount = 0;
+
+	double LastTickTime = 0.0;
+	double GCStartTime = 0.0;
+	double LastDumpTime = -DBL_MAX;
+	int32 NumDumps = 0;
+
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
+
+struct FHitchScope
+{
+	explicit FHitchScope(EHitchSystem InSystem)
+		: System(InSystem)
+		, StartCycles(FPlatformTime::Cycles64())
+	{
+	}
+
+	~FHitchScope()
+	{
+		UHitchDetectorSubsystem::AddSystemCycles(System, FPlatformTime::Cycles64() - StartCycles);
+	}
+
+	EHitchSystem System;
+	uint64 StartCycles;
+};
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "InputLatencySubsystem.generated.h"
+
+// The player inputs that get timed
+enum class ELatencyInput : uint8
+{
+	Attack,
+	EKey,
+	Move
+};
+
+// What an input is timed to, the first one of each after the input counts
+enum class ELatencyEffect : uint8
+{
+	AttackMontage,
+	AttackCollision,
+	EquipMontage,
+	Movement,
+
+	Count
+};
+
+/**
+ * Times the locally controlled player's inputs to what they cause: the attack and equip montages
+ * starting, the weapon box first turning on and the first frame the character moves. Latencies go
+ * into 5 ms histograms, slash.InputLatency.Report logs them and slash.InputLatency.Csv writes them,
+ * as does ending a run started with -InputLatencyCsv=<path>. slash.InputLatency.SyntheticInterval
+ * presses the inputs itself, for headless runs with nobody at the keyboard.
+ */
+UCLASS()
+class MYPROJECT3_API UInputLatencySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** <FTickableGameObject> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </FTickableGameObject> */
+
+	// Call from the input handlers and where the effects happen, only the local player is timed
+	static void NoteInput(const APawn* Pawn, ELatencyInput Input);
+	static void NoteEffect(const APawn* Pawn, ELatencyEffect Effect);
+
+	void LogReport() const;
+	bool WriteCsv(const FString& Path) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	static constexpr int32 NumBuckets = 41;
+	static constexpr double BucketMs = 5.0;
+
+	struct FHistogram
+	{
+		// The last bucket takes everything from 200 ms up
+		uint32 Buckets[NumBuckets] = {};
+		uint32 Count = 0;
+		double TotalMs = 0.0;
+		double MaxMs = 0.0;
+
+		void Add(double LatencyMs);
+		double GetPercentile(double Percentile) const;
+	};
+
+	void StartTiming(ELatencyEffect Effect, double Now);
+	void DriveSyntheticInput(float DeltaTime);
+	static UInputLatencySubsystem* GetForPawn(const APawn* Pawn);
+	static const TCHAR* GetEffectName(ELatencyEffect Effect);
+
+	FHistogram Histograms[static_cast<int32>(ELatencyEffect::Count)];
+
+	// When the input each effect is waiting on came in, 0 when nothing is waiting
+	double PendingInputTime[static_cast<int32>(ELatencyEffect::Count)] = {};
+
+	TWeakObjectPtr<const APawn> TrackedPawn;
+	uint64 LastMoveInputFrame = 0;
+
+	FString ExitCsvPath;
+	float TimeSinceSyntheticInput = 0.f;
+	float SyntheticMoveTimeLeft = 0.f;
+	int32 NextSyntheticInput = 0;
+};
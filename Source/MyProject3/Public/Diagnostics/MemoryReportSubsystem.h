@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "MemoryReportSubsystem.generated.h"
+
+/**
+ * Estimates what each gameplay class costs per instance: the actor and its subobjects (components,
+ * anim instance, health bar widget), what hangs off it (weapon, AI controller) and its share of the
+ * assets it uses (meshes, montages, sounds, effects). slash.Memory.Report logs it, slash.Memory.Csv
+ * appends it to a CSV tagged with the build version, as does ending a map run with
+ * -MemoryReportCsv=<path>. The live allocations are under the Slash LLM tags (stat LLMFULL, -llmcsv).
+ */
+UCLASS()
+class MYPROJECT3_API UMemoryReportSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	void LogReport() const;
+	bool WriteCsv(const FString& Path) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FClassFootprint
+	{
+		FString ClassName;
+		int32 Count = 0;
+		SIZE_T InstanceBytes = 0;
+		SIZE_T AttachedBytes = 0;
+		SIZE_T SharedBytes = 0;
+		TSet<FObjectKey> SharedAssets;
+
+		double GetPerInstanceKB() const;
+	};
+
+	void GatherFootprints(TArray<FClassFootprint>& OutFootprints) const;
+	void OnWorldBeginTearDown(UWorld* World);
+
+	FString ExitCsvPath;
+	FDelegateHandle TearDownHandle;
+};
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SoakTestSubsystem.generated.h"
+
+class ASlashCharacter;
+
+/**
+ * Only exists with -SlashSoak. Plays the map on its own for -SlashSoakHours (2 by default): the
+ * player walks to the nearest enemy, pot or treasure and fights, smashes or collects it, and once
+ * the map is cleared the enemies and pots placed in it come back as the next wave. Every
+ * slash.Soak.SampleInterval it collects garbage and samples UObjects, actors, resident memory and
+ * frame time into Saved/Profiling/Soak.csv (or -SlashSoakCsv=<path>). At the end any of them growing
+ * more than slash.Soak.Tolerance over the run fails it, and the game exits with status 1.
+ */
+UCLASS()
+class MYPROJECT3_API USoakTestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	/** </UWorldSubsystem> */
+
+	/** <FTickableGameObject> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </FTickableGameObject> */
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FSpawnPoint
+	{
+		TSoftClassPtr<AActor> Class;
+		FTransform Transform;
+	};
+
+	struct FSample
+	{
+		double Seconds = 0.0;
+		int32 Wave = 0;
+		int32 UObjects = 0;
+		int32 Actors = 0;
+		double UsedMB = 0.0;
+		double FrameMs = 0.0;
+	};
+
+	void SpawnWave();
+	void DriveAutopilot(ASlashCharacter* Player, float DeltaTime);
+	AActor* ChooseTarget(const ASlashCharacter* Player) const;
+	void ForceResolve(AActor* InTarget, ASlashCharacter* Player);
+	void TakeSample(double Now);
+	void Finish();
+	bool CheckTrend(const TCHAR* Name, TFunctionRef<double(const FSample&)> GetValue) const;
+
+	TArray<FSpawnPoint> SpawnPoints;
+	TArray<FSample> Samples;
+	FString CsvPath;
+
+	double StartTime = 0.0;
+	double Duration = 0.0;
+	double LastSampleTime = 0.0;
+	double LastTickTime = 0.0;
+	double LastWaveTime = 0.0;
+	double FrameSecondsSinceSample = 0.0;
+	int32 FramesSinceSample = 0;
+	int32 Wave = 0;
+	bool bSampleAfterGC = false;
+	bool bFinished = false;
+
+	TWeakObjectPtr<AActor> Target;
+	float TimeOnTarget = 0.f;
+	float TimeSinceAction = 0.f;
+};
@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimNotifies/AnimNotify.h"
+#include "AnimNotify_EnemyFootstep.generated.h"
+
+/**
+ * Plays a footstep through the owner's enemy audio component, for enemies with bFootstepsFromNotifies
+ * set. Goes through the same culling and caps as the footsteps driven by ground speed.
+ */
+UCLASS(meta = (DisplayName = "Enemy Footstep"))
+class MYPROJECT3_API UAnimNotify_EnemyFootstep : public UAnimNotify
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Notify(USkeletalMeshComponent* MeshComp, UAnimSequenceBase* Animation, const FAnimNotifyEventReference& EventReference) override;
+};
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "AttackTokenSubsystem.generated.h"
+
+class AEnemy;
+
+/**
+ * Limits how many enemies swing at the same target at once. An enemy needs a token for its combat
+ * target to start an attack, slash.AttackTokens.PerTarget per target and slash.AttackTokens.Max
+ * across the world. Enemies that are turned down wait in line, and a freed token goes to whoever
+ * in line is closest to the target and most in front of it. A holder that hasn't attacked within
+ * slash.AttackTokens.Lease can lose its token to someone who is asking.
+ */
+UCLASS()
+class MYPROJECT3_API UAttackTokenSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// True if Attacker holds or just got a token for Target, otherwise it's put in line for one
+	bool RequestToken(AEnemy* Attacker, AActor* Target);
+
+	// Gives back the token or place in line Attacker has, a freed token goes to the next in line
+	void ReleaseToken(AEnemy* Attacker);
+
+	bool HasToken(const AEnemy* Attacker) const;
+
+	FORCEINLINE int32 GetNumTokensHeld() const { return NumTokensHeld; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FHolder
+	{
+		TWeakObjectPtr<AEnemy> Enemy;
+		double RenewTime = 0.0;
+	};
+
+	struct FTargetTokens
+	{
+		TWeakObjectPtr<AActor> Target;
+		TArray<FHolder> Holders;
+		TArray<TWeakObjectPtr<AEnemy>> Waiting;
+	};
+
+	void Grant(FTargetTokens& Tokens, AEnemy* Attacker);
+	void GrantToWaiting();
+	bool ReclaimExpired(FTargetTokens& Tokens);
+	void RemoveStale();
+	bool CanGrant(const FTargetTokens& Tokens) const;
+	static float GetPriority(const AEnemy* Attacker, const AActor* Target);
+
+	TMap<TObjectKey<AActor>, FTargetTokens> Targets;
+	int32 NumTokensHeld = 0;
+};
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CorpseSubsystem.generated.h"
+
+class AEnemy;
+
+/**
+ * Keeps dead enemies close to free. Each corpse is frozen once its death montage has played out:
+ * the pose is kept (on a pose snapshot mesh if slash.Corpse.PoseSnapshot is on) and the anim,
+ * tick, movement, sensing and health bar are shut down. Past slash.Corpse.Max corpses the oldest
+ * goes first.
+ */
+UCLASS()
+class MYPROJECT3_API UCorpseSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	void AddCorpse(AEnemy* Enemy);
+
+	FORCEINLINE int32 GetNumCorpses() const { return Corpses.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FCorpse
+	{
+		TWeakObjectPtr<AEnemy> Enemy;
+		double DeathTime = 0.0;
+		bool bFrozen = false;
+	};
+
+	void FreezeCorpse(FCorpse& Corpse);
+	void RecycleOldest();
+	void UpdateStats();
+
+	// Oldest first
+	TArray<FCorpse> Corpses;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CrowdSubsystem.generated.h"
+
+class AEnemy;
+class AEnemyAIController;
+
+/**
+ * Keeps the detour crowd affordable. A few times a second the enemy crowd agents are ranked by
+ * distance to the nearest player. The closest slash.Crowd.MaxSimulated get avoidance quality by
+ * distance tier, the rest drop to the cheapest avoidance and to being an obstacle only. Moving
+ * agents can't switch, so their move is stopped and requested again. That makes MaxSimulated the
+ * budget for the crowd manager's per frame update, which only steers simulated agents and can't be
+ * time sliced from here. slash.Crowd.Bench runs the same crowd of enemies at the player with the
+ * crowd off and on and reports frame time and capsule penetration resolves for both.
+ */
+UCLASS()
+class MYPROJECT3_API UCrowdSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	void RegisterAgent(AEnemyAIController* Controller);
+	void UnregisterAgent(AEnemyAIController* Controller);
+
+	// False with slash.Crowd.Enabled 0, or during the crowd off half of a bench
+	bool IsCrowdEnabled() const;
+
+	void StartBench(int32 NumEnemies, float Seconds);
+
+	FORCEINLINE int32 GetNumAgents() const { return Agents.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	enum class ETier : uint8
+	{
+		None,
+		High,
+		Good,
+		Medium,
+		Low,
+		// Past the simulation budget
+		Budget
+	};
+
+	struct FAgent
+	{
+		TWeakObjectPtr<AEnemyAIController> Controller;
+		ETier Tier = ETier::None;
+		// The tier's simulation state still has to be applied, retried on every pass
+		bool bSimulationPending = false;
+	};
+
+	enum class EBenchPhase : uint8
+	{
+		Idle,
+		WarmUp,
+		Measure
+	};
+
+	struct FBench
+	{
+		TWeakObjectPtr<APawn> Player;
+		TSubclassOf<AEnemy> EnemyClass;
+		TArray<TWeakObjectPtr<AEnemy>> Enemies;
+		EBenchPhase Phase = EBenchPhase::Idle;
+		bool bCrowdEnabled = false;
+		bool bPlayerCouldBeDamaged = true;
+		int32 NumEnemies = 0;
+		float Seconds = 0.f;
+		double PhaseStartTime = 0.0;
+		uint64 StartPenetrationResolves = 0;
+		int32 NumFrames = 0;
+		double TotalFrameTime = 0.0;
+		double WorstFrameTime = 0.0;
+	};
+
+	void UpdateTiers();
+	// Return false if the simulation state couldn't be switched yet
+	bool ApplyTier(AEnemyAIController* Controller, ETier Tier);
+	bool ApplySimulationState(AEnemyAIController* Controller, ETier Tier);
+
+	void TickBench();
+	void StartBenchPass(bool bCrowdEnabled);
+	void FinishBenchPass();
+	void ClearBenchEnemies();
+
+	TArray<FAgent> Agents;
+	float TimeSinceTierUpdate = 0.f;
+
+	FBench Bench;
+};
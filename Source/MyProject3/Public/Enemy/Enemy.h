@@ -7,8 +7,13 @@
 #include "Characters/CharacterTypes.h"
 #include "Enemy.generated.h"
 
+class UEnemyAudioComponent;
+class UEnemyMovementComponent;
+enum class EPathPriority : uint8;
+struct FAIMoveRequest;
 class UHealthBarComponent;
 class UPawnSensingComponent;
+class UPersistentStateComponent;
 
 UCLASS()
 class MYPROJECT3_API AEnemy : public ABaseCharacter
@@ -16,12 +21,13 @@ class MYPROJECT3_API AEnemy : public ABaseCharacter
 	GENERATED_BODY()
 
 public:
-	AEnemy();
+	AEnemy(const FObjectInitializer& ObjectInitializer);
 
 	/** <AActor> */
-	virtual void Tick(float DeltaTime) override;
 	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
 	virtual void Destroyed() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	/** </AActor> */
 
 	/** <IHitInterface> */
@@ -29,6 +35,24 @@ public:
 	virtual void GetHit_Implementation(const FVector& ImpactPoint, AActor* Hitter) override;
 	/** </IHitInterface> */
 
+	/** <IPreloadInterface> */
+	virtual void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const override;
+	virtual void GetPrewarmAssets(TArray<UObject*>& OutAssets) const override;
+	/** </IPreloadInterface> */
+
+	// Called by the corpse subsystem once the death pose has settled, shuts down everything but the pose
+	void FreezeCorpse(bool bUsePoseSnapshot);
+
+	FORCEINLINE EEnemyState GetEnemyState() const { return EnemyState; }
+	FORCEINLINE const UPersistentStateComponent* GetPersistentState() const { return PersistentState; }
+	FORCEINLINE double GetCombatRadius() const { return CombatRadius; }
+
+	// Chases Target unless already fighting or dead, what seeing an engageable pawn does
+	void EngageTarget(APawn* Target);
+
+	// Called by the attack token subsystem when a token frees up for an enemy waiting in line
+	void OnAttackTokenGranted();
+
 protected:
 	/** <AActor> */
 	virtual void BeginPlay() override;
@@ -44,16 +68,18 @@ protected:
 
 	/** </ABaseCharacter> */
 
-	UPROPERTY(BlueprintReadOnly)
+	UPROPERTY(BlueprintReadOnly, Replicated)
 	TEnumAsByte<EDeathPose> DeathPose;
 
-	UPROPERTY(BlueprintReadOnly)
+	UPROPERTY(BlueprintReadOnly, ReplicatedUsing = OnRep_EnemyState)
 	EEnemyState EnemyState = EEnemyState::EES_Patrolling;
 
 
 private:
 
 	// AI Behavior
+	bool ApplyPersistentState();
+	void SetEnemyState(EEnemyState NewState);
 	void InitializeEnemy();
 	void CheckPatrolTarget();
 	void CheckCombatTarget();
@@ -63,10 +89,22 @@ private:
 	void LoseInterest();
 	void StartPatrolling();
 	void ChaseTarget();
+	void TryStartAttack();
+	void StartStrafing();
+	void StopStrafing();
+	void StrafeStep();
+	void ReleaseAttackToken();
+	// Return the band the target starts in, only crossings after that come in as events
+	int32 WatchCombatTarget();
+	void WatchPatrolTarget();
+	void StopWatching();
+	void OnCombatBandCrossed(int32 Band, bool bEntered);
+	void OnPatrolBandCrossed(int32 Band, bool bEntered);
 	bool IsOutsideCombatRadius();
 	bool IsOutsideAttackRadius();
 	bool IsInsideAttackRadius();
 	bool IsChasing();
+	bool IsStrafing();
 	bool IsAttacking();
 	bool IsDead();
 	bool IsEngaged();
@@ -75,8 +113,16 @@ private:
 	void ClearAttackTimer();
 	bool InTargetRange(AActor* Target, double Radius);
 	void MoveToTarget(AActor* Target);
+	void RequestMove(const FAIMoveRequest& MoveRequest, EPathPriority Priority);
+	void CancelMove();
 	AActor* ChoosePatrolTarget();
 	void SpawnDefaultWeapon();
+	UEnemyMovementComponent* GetEnemyMovement() const;
+	void SetIdleDormancy(bool bIdle);
+	void OnReplicatedHealthChanged(float HealthPercent);
+
+	UFUNCTION()
+	void OnRep_EnemyState(EEnemyState OldState);
 
 	UFUNCTION()
 	void PawnSeen(APawn* SeenPawn); //Callback for onpawnseen in UPawnSensingComponent
@@ -87,8 +133,18 @@ private:
 	UPROPERTY(VisibleAnywhere)
 	UPawnSensingComponent* PawnSensing;
 
+	UPROPERTY(VisibleAnywhere)
+	UPersistentStateComponent* PersistentState;
+
+	UPROPERTY(VisibleAnywhere)
+	UEnemyAudioComponent* Audio;
+
+	// Clients only see health go down through replication, a drop is when to play pain
+	float LastReplicatedHealthPercent = 1.f;
+
+	// Soft so loading the enemy doesn't pull in the weapon, it's preloaded with the level instead
 	UPROPERTY(EditAnywhere)
-	TSubclassOf<class AWeapon> WeaponClass;
+	TSoftClassPtr<class AWeapon> WeaponClass;
 
 	UPROPERTY(EditAnywhere)
 	double CombatRadius = 1000.f;
@@ -132,6 +188,21 @@ private:
 	UPROPERTY(EditAnywhere, Category = "Combat")
 	float ChasingSpeed = 300.f;
 
+	// Enemies without an attack token circle the target at this distance until one frees up
+	UPROPERTY(EditAnywhere, Category = "Combat")
+	double StrafeRadius = 400.f;
+
+	UPROPERTY(EditAnywhere, Category = "Combat")
+	float StrafingSpeed = 150.f;
+
+	FTimerHandle StrafeTimer;
+
+	UPROPERTY(EditAnywhere, Category = "Combat")
+	float StrafeMinTime = 1.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Combat")
+	float StrafeMaxTime = 3.f;
+
 	UPROPERTY(EditAnywhere, Category = Combat)
 	float DeathLifeSpan = 8.f;
 };
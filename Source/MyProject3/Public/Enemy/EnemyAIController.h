@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "EnemyAIController.generated.h"
+
+class UCrowdFollowingComponent;
+
+/**
+ * AI controller that follows paths as a detour crowd agent, so enemies steer around each other
+ * instead of pushing into each other's capsules. The crowd subsystem sets how good the avoidance
+ * is and whether the agent is simulated at all, slash.Crowd.Enabled 0 falls back to plain path
+ * following for controllers possessing after it changes.
+ */
+UCLASS()
+class MYPROJECT3_API AEnemyAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	AEnemyAIController(const FObjectInitializer& ObjectInitializer);
+
+	UCrowdFollowingComponent* GetCrowdFollowing() const;
+
+protected:
+	/** <AController> */
+	virtual void OnPossess(APawn* InPawn) override;
+	virtual void OnUnPossess() override;
+	/** </AController> */
+};
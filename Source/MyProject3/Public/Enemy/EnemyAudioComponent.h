@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "EnemyAudioComponent.generated.h"
+
+class USoundBase;
+
+UENUM(BlueprintType)
+enum class EEnemyVocal : uint8
+{
+	EEV_Aggro UMETA(DisplayName = "Aggro"),
+	EEV_Pain UMETA(DisplayName = "Pain"),
+	EEV_Death UMETA(DisplayName = "Death")
+};
+
+/**
+ * Footsteps and vocals for an enemy. Footsteps follow the ground speed, one per StrideLength
+ * walked, or come from AnimNotify_EnemyFootstep on the animations if bFootstepsFromNotifies is set.
+ * The enemy audio subsystem only lets this tick while a listener could hear it, and checks the
+ * distance and the per listener caps again before any sound is created. Each set plays through
+ * in a shuffled order so the same sound never comes twice in a row.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class MYPROJECT3_API UEnemyAudioComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyAudioComponent();
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	void PlayFootstep();
+	void PlayVocal(EEnemyVocal Vocal);
+
+	// Set by the enemy audio subsystem, nothing is played or ticked while false
+	void SetAudible(bool bInAudible);
+
+	// Furthest any of the sounds can be heard from
+	float GetAudibleDistance() const;
+
+	void GetSoundAssets(TArray<UObject*>& OutAssets) const;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FShuffleBag
+	{
+		TArray<int32> Order;
+		int32 Next = 0;
+	};
+
+	USoundBase* PickSound(const TArray<USoundBase*>& Sounds, FShuffleBag& Bag);
+	FVector GetFootLocation() const;
+
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	TArray<USoundBase*> FootstepSounds;
+
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	TArray<USoundBase*> AggroSounds;
+
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	TArray<USoundBase*> PainSounds;
+
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	TArray<USoundBase*> DeathSounds;
+
+	// Distance walked per footstep
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	float StrideLength = 120.f;
+
+	// Slower than this counts as standing still
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	float MinStepSpeed = 30.f;
+
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	bool bFootstepsFromNotifies = false;
+
+	// Least time between two vocals, a death always plays
+	UPROPERTY(EditAnywhere, Category = "Audio")
+	float VocalCooldown = 1.5f;
+
+	FShuffleBag FootstepBag;
+	FShuffleBag AggroBag;
+	FShuffleBag PainBag;
+	FShuffleBag DeathBag;
+
+	// Its own stream, so how often an enemy is audible doesn't shift the gameplay rolls
+	FRandomStream Random;
+
+	float DistanceSinceStep = 0.f;
+	double LastVocalTime = -1000.0;
+	bool bAudible = false;
+};
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemyAudioSubsystem.generated.h"
+
+class UEnemyAudioComponent;
+class USoundBase;
+
+enum class EEnemySoundKind : uint8
+{
+	Footstep,
+	Vocal
+};
+
+/**
+ * Decides which enemies can make a sound at all. A few times a second every enemy audio component
+ * is marked audible or not by its distance to the nearest local listener, so far enemies don't tick
+ * or play anything. A sound that does get asked for is dropped if it is past its attenuation
+ * distance or slash.Audio.MaxDistance, or if its nearest listener already has slash.Audio.MaxFootsteps
+ * footsteps or slash.Audio.MaxVocals vocals playing. Not created on dedicated servers.
+ */
+UCLASS()
+class MYPROJECT3_API UEnemyAudioSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	void Register(UEnemyAudioComponent* Component);
+	void Unregister(UEnemyAudioComponent* Component);
+
+	// Plays Sound at Location unless it's culled or over the cap, returns whether it played
+	bool TryPlay(USoundBase* Sound, const FVector& Location, EEnemySoundKind Kind);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FListener
+	{
+		FVector Location = FVector::ZeroVector;
+		// End times of what's playing for this listener
+		TArray<double> FootstepsPlaying;
+		TArray<double> VocalsPlaying;
+	};
+
+	void UpdateListeners();
+	int32 FindNearestListener(const FVector& Location, double& OutDistanceSquared) const;
+
+	TArray<TWeakObjectPtr<UEnemyAudioComponent>> Components;
+	TArray<FListener> Listeners;
+	float TimeSinceCull = 0.f;
+};
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "EnemyMovementComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class EEnemyMovementLOD : uint8
+{
+	EML_Full UMETA(DisplayName = "Full"),
+	EML_NavWalking UMETA(DisplayName = "NavWalking"),
+	EML_Offscreen UMETA(DisplayName = "Offscreen")
+};
+
+/**
+ * Character movement with a LOD for enemies that are only patrolling. Far away they walk on the
+ * navmesh instead of sweeping for the floor, and offscreen they also skip the movement sweep and
+ * update less often. The owner decides when reduced movement is allowed, anything else runs full
+ * walking. The mesh is eased over the height change when the mode switches so it doesn't pop.
+ */
+UCLASS()
+class MYPROJECT3_API UEnemyMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UEnemyMovementComponent();
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void FindFloor(const FVector& CapsuleLocation, FFindFloorResult& OutFloorResult, bool bCanUseCachedLocation, const FHitResult* DownwardSweepResult = nullptr) const override;
+
+	// Enemies allow this while patrolling, chasing and fighting always get full walking right away
+	void SetReducedMovementAllowed(bool bAllowed);
+
+	FORCEINLINE EEnemyMovementLOD GetMovementLOD() const { return MovementLOD; }
+
+	// Penetration resolves by every enemy since startup, for benchmarks to diff
+	static uint64 GetTotalPenetrationResolves();
+
+protected:
+	virtual bool MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit = nullptr, ETeleportType Teleport = ETeleportType::None) override;
+	virtual bool ResolvePenetrationImpl(const FVector& Adjustment, const FHitResult& Hit, const FQuat& NewRotation) override;
+
+private:
+	EEnemyMovementLOD ChooseMovementLOD() const;
+	void SetMovementLOD(EEnemyMovementLOD NewLOD);
+	void UpdateMeshOffset(float DeltaTime);
+
+	UPROPERTY(EditAnywhere, Category = "Movement LOD")
+	float NavWalkingDistance = 2500.f;
+
+	// How long the owner can go unrendered before it counts as offscreen
+	UPROPERTY(EditAnywhere, Category = "Movement LOD")
+	float OffscreenTime = 0.5f;
+
+	UPROPERTY(EditAnywhere, Category = "Movement LOD")
+	float OffscreenTickInterval = 0.1f;
+
+	UPROPERTY(EditAnywhere, Category = "Movement LOD")
+	float LODCheckInterval = 0.25f;
+
+	// How fast the mesh catches up with the capsule after a mode switch moved it vertically
+	UPROPERTY(EditAnywhere, Category = "Movement LOD")
+	float MeshOffsetInterpSpeed = 8.f;
+
+	EEnemyMovementLOD MovementLOD = EEnemyMovementLOD::EML_Full;
+	bool bReducedMovementAllowed = false;
+	bool bModeSwitched = false;
+	float TimeSinceLODCheck = 0.f;
+	float MeshOffsetZ = 0.f;
+};
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AITypes.h"
+#include "NavigationData.h"
+#include "PathRequestSubsystem.generated.h"
+
+class AAIController;
+
+// Lower goes first
+enum class EPathPriority : uint8
+{
+	Chase,
+	Strafe,
+	Patrol
+};
+
+/**
+ * Queues AI moves and finds their paths asynchronously instead of pathfinding inside MoveTo.
+ * Queries are sent within slash.Paths.BudgetMs of game thread a frame, chasers before strafers
+ * before patrollers and nearer the players first. A newer request from the same controller replaces
+ * its older one unless both go to the same goal, then the newer one is dropped. So is one for the
+ * goal it is already following a valid path to, the path keeps tracking the goal on its own.
+ * "stat Slash" has the queue depth and latency, slash.Paths.Report the totals.
+ */
+UCLASS()
+class MYPROJECT3_API UPathRequestSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	// Goes straight to MoveTo with slash.Paths.Async 0
+	void RequestMove(AAIController* Controller, const FAIMoveRequest& MoveRequest, EPathPriority Priority);
+
+	// Drops anything queued or in flight for Controller
+	void CancelMove(const AAIController* Controller);
+
+	void Report() const;
+
+	FORCEINLINE int32 GetQueueDepth() const { return Pending.Num(); }
+	FORCEINLINE int32 GetNumInFlight() const { return InFlight.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FRequest
+	{
+		TWeakObjectPtr<AAIController> Controller;
+		FAIMoveRequest MoveRequest;
+		EPathPriority Priority = EPathPriority::Patrol;
+		double RequestTime = 0.0;
+		double SortKey = 0.0;
+	};
+
+	static bool IsSameGoal(const FAIMoveRequest& A, const FAIMoveRequest& B);
+	bool IsFollowingPathTo(const AAIController* Controller, const FAIMoveRequest& MoveRequest) const;
+	void Dispatch(FRequest&& Request);
+	void OnPathFound(uint32 QueryId, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+	void ApplyPath(const FRequest& Request, FNavPathSharedPtr Path);
+	void MoveDirectly(const FRequest& Request);
+	void NoteLatency(const FRequest& Request);
+	void SortPending();
+
+	TArray<FRequest> Pending;
+	TMap<uint32, FRequest> InFlight;
+
+	uint64 NumRequested = 0;
+	uint64 NumReplaced = 0;
+	uint64 NumDeduped = 0;
+	uint64 NumReused = 0;
+	uint64 NumDispatched = 0;
+	uint64 NumFailed = 0;
+	uint64 NumStale = 0;
+	double AverageLatencyMs = 0.0;
+	double MaxLatencyMs = 0.0;
+};
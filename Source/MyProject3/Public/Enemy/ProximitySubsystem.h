@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "ProximitySubsystem.generated.h"
+
+// Band is the index of the radius crossed, bEntered is true when moving inside it
+DECLARE_DELEGATE_TwoParams(FOnProximityCrossed, int32 /*Band*/, bool /*bEntered*/);
+
+/**
+ * Tells an actor when another one crosses radius bands around it, instead of it checking the
+ * distance every frame. Leaving a band takes slash.Proximity.Hysteresis more than entering it so
+ * standing on the edge doesn't flap. A watch isn't looked at again until the two could have
+ * closed the gap to the nearest boundary at slash.Proximity.MaxClosingSpeed. Watches wait in a
+ * heap ordered by that time and a frame only pops the ones that are due, so watches that are far
+ * from any edge cost nothing. A target that goes away counts as leaving every band.
+ */
+UCLASS()
+class MYPROJECT3_API UProximitySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	// Replaces any watch Watcher already had. Radii are smallest first. Returns the band Target starts in,
+	// 0 inside the first radius up to Radii.Num() outside all of them
+	int32 Watch(AActor* Watcher, AActor* Target, TArrayView<const float> Radii, FOnProximityCrossed OnCrossed);
+	void Unwatch(const AActor* Watcher);
+
+	FORCEINLINE int32 GetNumWatches() const { return Watches.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FWatch
+	{
+		TWeakObjectPtr<AActor> Watcher;
+		TWeakObjectPtr<AActor> Target;
+		TArray<float, TInlineAllocator<4>> Radii;
+		FOnProximityCrossed OnCrossed;
+		double NextCheckTime = 0.0;
+		int32 Band = 0;
+		uint32 Serial = 0;
+	};
+
+	struct FCrossing
+	{
+		TObjectKey<AActor> Watcher;
+		uint32 Serial = 0;
+		int32 Band = 0;
+		bool bEntered = false;
+	};
+
+	// Replaced and removed watches leave their entry behind, it is skipped when it comes up
+	struct FScheduled
+	{
+		double Time = 0.0;
+		TObjectKey<AActor> Watcher;
+		uint32 Serial = 0;
+
+		FORCEINLINE bool operator<(const FScheduled& Other) const { return Time < Other.Time; }
+	};
+
+	void Schedule(const FWatch& Entry);
+
+	// Moves the watch to the band for Distance, recording each boundary crossed on the way
+	void UpdateBand(FWatch& Entry, double Distance, TArray<FCrossing>& OutCrossings) const;
+	double GetRecheckDelay(const FWatch& Entry, double Distance) const;
+
+	TMap<TObjectKey<AActor>, FWatch> Watches;
+
+	// Min heap on Time
+	TArray<FScheduled> Scheduled;
+
+	// Crossings are only delivered to the watch that produced them, not one set up since
+	uint32 NextSerial = 0;
+};
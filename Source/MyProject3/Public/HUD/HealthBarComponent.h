@@ -15,6 +15,10 @@ class MYPROJECT3_API UHealthBarComponent : public UWidgetComponent
 	GENERATED_BODY()
 
 public:
+	/** <UWidgetComponent> */
+	virtual void InitWidget() override;
+	/** </UWidgetComponent> */
+
 	void SetHealthPercent(float Percent);
 
 private:
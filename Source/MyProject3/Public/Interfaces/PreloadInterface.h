@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "PreloadInterface.generated.h"
+
+// This class does not need to be modified.
+UINTERFACE(MinimalAPI, meta = (CannotImplementInterfaceInBlueprint))
+class UPreloadInterface : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Implemented by placed actors so the level can get their assets ready while it loads.
+ * Preload assets are soft references the actor spawns from later, prewarm assets are the
+ * montages, sounds and effects it plays that should be primed before their first use.
+ */
+class MYPROJECT3_API IPreloadInterface
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GetPreloadAssets(TArray<FSoftObjectPath>& OutAssets) const {}
+	virtual void GetPrewarmAssets(TArray<UObject*>& OutAssets) const {}
+};
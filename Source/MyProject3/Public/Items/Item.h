@@ -4,9 +4,11 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "Interfaces/PreloadInterface.h"
 #include "Item.generated.h"
 
 class USphereComponent;
+class UPersistentStateComponent;
 
 enum class EItemState : uint8
 {
@@ -15,7 +17,7 @@ enum class EItemState : uint8
 };
 
 UCLASS()
-class MYPROJECT3_API AItem : public AActor
+class MYPROJECT3_API AItem : public AActor, public IPreloadInterface
 {
 	GENERATED_BODY()
 
@@ -23,11 +25,19 @@ public:
 	// Cpp constructor
 	AItem();
 	virtual void Tick(float DeltaTime) override;
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+	virtual void GetPrewarmAssets(TArray<UObject*>& OutAssets) const override;
+
+	FORCEINLINE EItemState GetItemState() const { return ItemState; }
+	FORCEINLINE const UPersistentStateComponent* GetPersistentState() const { return PersistentState; }
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Asset manager type for blueprints of this item class, none means not a primary asset
+	virtual FPrimaryAssetType GetItemAssetType() const { return FPrimaryAssetType(); }
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sine Parameters")
 	float Amplitude = 0.25f;
 
@@ -60,6 +70,9 @@ protected:
 	UPROPERTY(EditAnywhere)
 	class UNiagaraComponent* EmbersEffect;
 
+	UPROPERTY(VisibleAnywhere)
+	class UPersistentStateComponent* PersistentState;
+
 private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
 	float RunningTime;
@@ -14,7 +14,11 @@ class MYPROJECT3_API ATreasure : public AItem
 {
 	GENERATED_BODY()
 	
+public:
+	virtual void GetPrewarmAssets(TArray<UObject*>& OutAssets) const override;
+
 protected:
+	virtual FPrimaryAssetType GetItemAssetType() const override { return FPrimaryAssetType(TEXT("Treasure")); }
 	virtual void OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult) override;
 
 private:
@@ -25,6 +25,7 @@ class MYPROJECT3_API AWeapon : public AItem
 	GENERATED_BODY()
 public:
 	AWeapon();
+	virtual void GetPrewarmAssets(TArray<UObject*>& OutAssets) const override;
 	void Equip(USceneComponent* InParent, FName InSocketName, AActor* NewOwner, APawn* NewInstigator);
 
 	void DeactivateEmbers();
@@ -35,6 +36,8 @@ public:
 
 	void AttachMeshToSocket(USceneComponent* InParent, const FName& InSocketName);
 
+	// Already hit this swing. A UPROPERTY so destroyed actors get nulled instead of left dangling
+	UPROPERTY()
 	TArray<AActor*> IgnoreActors;
 
 	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
@@ -42,17 +45,30 @@ public:
 
 protected:
 	virtual void BeginPlay() override;
+	virtual FPrimaryAssetType GetItemAssetType() const override { return FPrimaryAssetType(TEXT("Weapon")); }
 
 	UFUNCTION()
 	void OnBoxOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
 
 	bool ActorIsSameType(AActor* OtherActor);
 
-	void ExecuteGetHit(FHitResult& BoxHit);
+	void ExecuteGetHit(AActor* HitActor, const FVector& ImpactPoint);
 
+	// Damage, hit react and fields for a hit the server has accepted
+	void ApplyHit(AActor* HitActor, const FVector& ImpactPoint);
+
+	// A remote player's swing is traced where they see things, the server checks it against the hitbox history
+	UFUNCTION(Server, Reliable)
+	void ServerConfirmHit(AActor* HitActor, FVector_NetQuantize TraceStart, FVector_NetQuantize TraceEnd, double ClientTime);
+
+	// Only used with slash.Fields.Native 0, the field emitter subsystem handles impacts otherwise
 	UFUNCTION(BlueprintImplementableEvent)
 	void CreateFields(const FVector& FieldLocation);
 
+	// Every machine runs the fracture itself, only where it happens goes over the network
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastCreateFields(FVector_NetQuantize FieldLocation);
+
 
 private:
 	void BoxTrace(FHitResult& BoxHit); // non const reference bc we want to fill in and use later
@@ -78,6 +94,14 @@ private:
 	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
 	float Damage = 20.f;
 
+	// How far from the wielder a client reported swing may start
+	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
+	float MaxSwingReach = 300.f;
+
+	// How much longer than the blade a client reported swing may be, covers quantization and the wielder's pose differing
+	UPROPERTY(EditAnywhere, Category = "Weapon Properties")
+	float TraceLengthTolerance = 20.f;
+
 	
 
 public:
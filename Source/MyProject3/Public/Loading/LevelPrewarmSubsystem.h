@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "LevelPrewarmSubsystem.generated.h"
+
+class UAnimMontage;
+class UNiagaraSystem;
+class UParticleSystem;
+class USoundBase;
+struct FStreamableHandle;
+
+// Everything the placed actors of a map will play, built while the map loads
+USTRUCT()
+struct FLevelPrewarmManifest
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UAnimMontage*> Montages;
+
+	UPROPERTY()
+	TArray<USoundBase*> Sounds;
+
+	UPROPERTY()
+	TArray<UParticleSystem*> Particles;
+
+	UPROPERTY()
+	TArray<UNiagaraSystem*> NiagaraSystems;
+};
+
+/**
+ * Builds a prewarm manifest from the placed actors when the map begins play (still behind the
+ * loading screen) and primes it: montage notifies are resolved, sounds get their first chunk
+ * cached and particle pools are filled. Outside shipping, any gameplay asset first used after
+ * the game started that wasn't primed gets logged so it can be added.
+ */
+UCLASS()
+class MYPROJECT3_API ULevelPrewarmSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	// Call where gameplay plays an asset, logs it if it wasn't prewarmed
+	static void NoteAssetUse(const UObject* WorldContextObject, const UObject* Asset);
+
+	void DumpManifest() const;
+
+	FORCEINLINE const FLevelPrewarmManifest& GetManifest() const { return Manifest; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void GatherFromLevel(ULevel* Level);
+	void GatherFromObject(const UObject* Object, TArray<FSoftObjectPath>& OutSoftAssets);
+	void AddAsset(UObject* Asset);
+	void AddMontage(UAnimMontage* Montage);
+	void PrimePending();
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+	void OnSoftAssetsLoaded(TArray<FSoftObjectPath> Paths);
+
+	UPROPERTY()
+	FLevelPrewarmManifest Manifest;
+
+	// Added to the manifest but not primed yet
+	UPROPERTY()
+	TArray<UObject*> PendingPrime;
+
+	TSet<FObjectKey> KnownAssets;
+	TSet<FObjectKey> ReportedLateAssets;
+	TArray<TSharedPtr<FStreamableHandle>> SoftAssetHandles;
+	FDelegateHandle LevelAddedHandle;
+	bool bGameStarted = false;
+};
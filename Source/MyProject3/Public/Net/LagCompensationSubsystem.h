@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class ACharacter;
+
+// Where a character's capsule was at one recorded frame
+struct FHitboxSnapshot
+{
+	FVector3f Location = FVector3f::ZeroVector;
+	float HalfHeight = 0.f;
+};
+
+/**
+ * Server side hitbox history for lag compensated melee. Every tracked character's capsule is
+ * recorded into one flat array (each character's ring of frames is contiguous) at a fixed rate,
+ * so a client's hit can be checked against where the target was when the client saw it instead
+ * of where it is now. History length comes from slash.LagComp.MaxRewind and SampleRate, capped
+ * by the per character memory budget, and the record cost per character is measured against
+ * its CPU budget. Only runs on servers with a net driver.
+ */
+UCLASS()
+class MYPROJECT3_API ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </UTickableWorldSubsystem> */
+
+	void RegisterCharacter(ACharacter* Character);
+	void UnregisterCharacter(ACharacter* Character);
+	bool IsTracked(const ACharacter* Character) const;
+
+	// Interpolated capsule of Character at server time Time, clamped to the recorded window
+	bool GetRewoundHitbox(const ACharacter* Character, double Time, FHitboxSnapshot& OutHitbox) const;
+
+	// Sweeps a sphere of SweepRadius from Start to End against Target's capsule rewound to Time
+	bool ConfirmHit(const ACharacter* Target, double Time, const FVector& Start, const FVector& End, float SweepRadius, FVector& OutImpactPoint);
+
+	// Compares where a client saw Target at Time against the rewound and the current capsule
+	void ProbeHit(const ACharacter* Target, const FVector& SeenLocation, double Time);
+
+	// Server time a client should stamp its hits with, what it sees of other characters lags by this much
+	static double GetClientViewTime(const UWorld* World);
+
+	void Dump() const;
+
+	FORCEINLINE int32 GetHistoryLength() const { return HistoryLength; }
+	FORCEINLINE int32 GetBytesPerCharacter() const { return HistoryLength * sizeof(FHitboxSnapshot); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	bool IsServer() const;
+	void RecordFrame();
+	void SendProbes();
+	static bool SweepCapsule(const FHitboxSnapshot& Hitbox, float Radius, const FVector& Start, const FVector& End, float SweepRadius, FVector& OutImpactPoint);
+
+	// Snapshots[Slot * HistoryLength + Frame], a rewind only touches one character's run of frames
+	TArray<FHitboxSnapshot> Snapshots;
+	TArray<double> FrameTimes;
+	int32 HistoryLength = 0;
+	int32 NewestFrame = INDEX_NONE;
+	int32 NumFrames = 0;
+
+	TArray<TWeakObjectPtr<ACharacter>> SlotCharacters;
+	TArray<float> SlotRadii;
+	TArray<int32> FreeSlots;
+	TMap<FObjectKey, int32> SlotLookup;
+
+	float TimeSinceSample = 0.f;
+	float TimeSinceProbe = 0.f;
+	double RecordSecondsPerCharacter = 0.0;
+	bool bWarnedOverBudget = false;
+
+	// Results, for the dump and the localhost test
+	int32 NumConfirmed = 0;
+	int32 NumRejected = 0;
+	int32 NumProbes = 0;
+	double ProbeErrorRewound = 0.0;
+	double ProbeErrorCurrent = 0.0;
+	double TotalRewindSeconds = 0.0;
+};
@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NetBandwidthSubsystem.generated.h"
+
+/**
+ * Server side bandwidth report for multiplayer tests. Every slash.Net.ReportInterval seconds it
+ * logs what each client connection sends and receives, and when the world goes away it logs the
+ * average per client. Lines start with "NetReport:" so test scripts can pull them from the log.
+ */
+UCLASS()
+class MYPROJECT3_API UNetBandwidthSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UTickableWorldSubsystem> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual void Deinitialize() override;
+	/** </UTickableWorldSubsystem> */
+
+	void LogReport();
+	void LogSummary() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FClientTotals
+	{
+		double OutBytesPerSecond = 0.0;
+		double InBytesPerSecond = 0.0;
+		int32 Samples = 0;
+	};
+
+	TMap<FString, FClientTotals> ClientTotals;
+	float TimeSinceReport = 0.f;
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "SlashReplicationGraph.generated.h"
+
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+
+enum class ESlashClassRepPolicy : uint8
+{
+	NotRouted,
+	RelevantAllConnections,
+	Spatialize_Static,
+	Spatialize_Dynamic,
+	Spatialize_Dormancy
+};
+
+/**
+ * Server replication graph. Enemies, players, items and breakables go into a 2D spatial grid so
+ * each client only gathers the cells around it instead of every actor in the world, dormant
+ * actors (idle or dead enemies, items on the ground, unbroken pots) cost nothing until they wake.
+ * Always relevant actors like the game state go to every connection, owner only actors like the
+ * player controller are handled per connection.
+ */
+UCLASS(Transient)
+class MYPROJECT3_API USlashReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	/** <UReplicationGraph> */
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	/** </UReplicationGraph> */
+
+private:
+	ESlashClassRepPolicy GetClassPolicy(UClass* Class);
+	void InitClassInfo(UClass* Class, float CullDistance);
+
+	UPROPERTY()
+	UReplicationGraphNode_GridSpatialization2D* GridNode;
+
+	UPROPERTY()
+	UReplicationGraphNode_ActorList* AlwaysRelevantNode;
+
+	TClassMap<ESlashClassRepPolicy> ClassRepPolicies;
+};
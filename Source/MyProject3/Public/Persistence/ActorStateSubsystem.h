@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "ActorStateSubsystem.generated.h"
+
+enum class EPersistentStateFlags : uint8
+{
+	None = 0,
+	Dead = 1 << 0,
+	Broken = 1 << 1,
+	Collected = 1 << 2
+};
+ENUM_CLASS_FLAGS(EPersistentStateFlags);
+
+// Two bytes per actor, health is stored as a fraction of max health in 1/255 steps
+struct FPersistentActorState
+{
+	EPersistentStateFlags Flags = EPersistentStateFlags::None;
+	uint8 Health = 255;
+
+	FORCEINLINE bool HasFlag(EPersistentStateFlags Flag) const { return EnumHasAnyFlags(Flags, Flag); }
+	FORCEINLINE float GetHealthPercent() const { return Health / 255.f; }
+	FORCEINLINE void SetHealthPercent(float Percent) { Health = (uint8)FMath::RoundToInt(FMath::Clamp(Percent, 0.f, 1.f) * 255.f); }
+};
+
+/**
+ * Gameplay state of level placed actors that can stream out, keyed by the actor's persistent guid.
+ * Lives on the game instance so it outlives world partition cells. Only actors that changed are
+ * stored, so an untouched cell costs nothing and a touched actor costs its guid plus two bytes.
+ */
+UCLASS()
+class MYPROJECT3_API UActorStateSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	bool FindState(const FGuid& Guid, FPersistentActorState& OutState) const;
+	void SetState(const FGuid& Guid, const FPersistentActorState& State);
+	void Reset();
+
+	// Replaces everything, Guids must be sorted with States parallel to them
+	void Assign(TArray<FGuid>&& InGuids, TArray<FPersistentActorState>&& InStates);
+
+	FORCEINLINE int32 Num() const { return Guids.Num(); }
+	SIZE_T GetAllocatedSize() const;
+
+	FORCEINLINE const TArray<FGuid>& GetGuids() const { return Guids; }
+	FORCEINLINE const TArray<FPersistentActorState>& GetStates() const { return States; }
+
+private:
+	// Sorted so lookups are a binary search, States is parallel to Guids
+	TArray<FGuid> Guids;
+	TArray<FPersistentActorState> States;
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Flat arrays of POD records laid out back to back in one byte buffer, for the save file and the
+ * session recording. Sections start 8 byte aligned so they can be read straight out of the
+ * payload or a mapped file.
+ */
+namespace BinarySections
+{
+	// Returns the section's offset in Bytes
+	template <typename RecordType>
+	uint32 AppendSection(TArray<uint8>& Bytes, const TArray<RecordType>& Records)
+	{
+		Bytes.SetNumZeroed(Align(Bytes.Num(), 8));
+		const uint32 Offset = Bytes.Num();
+		Bytes.Append(reinterpret_cast<const uint8*>(Records.GetData()), Records.Num() * sizeof(RecordType));
+		return Offset;
+	}
+
+	// False if the section runs past the end of Bytes
+	template <typename RecordType>
+	bool ReadSection(const TArray<uint8>& Bytes, uint32 Offset, uint32 Num, TArray<RecordType>& OutRecords)
+	{
+		if (uint64(Offset) + uint64(Num) * sizeof(RecordType) > uint64(Bytes.Num())) return false;
+
+		OutRecords.SetNumUninitialized(Num);
+		FMemory::Memcpy(OutRecords.GetData(), Bytes.GetData() + Offset, Num * sizeof(RecordType));
+		return true;
+	}
+}
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Characters/CharacterTypes.h"
+#include "Persistence/ActorStateSubsystem.h"
+#include "Tasks/Task.h"
+#include "SaveGameSubsystem.generated.h"
+
+/**
+ * Save file layout. A header followed by the Oodle compressed payload, which holds flat arrays of
+ * these at the header's offsets so a load copies them out as is. Actor states are the actor state
+ * subsystem's sorted guids and states, which already cover dead enemies, enemy health, broken
+ * breakables and collected treasure. Enemies are sorted by guid too.
+ */
+namespace SaveFile
+{
+	constexpr uint32 Magic = 0x56534C53; // "SLSV"
+	constexpr uint16 Version = 2;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint16 Version;
+		uint16 HeaderSize;
+		uint32 UncompressedSize;
+		uint32 CompressedSize;
+		uint32 NumPlayers;
+		uint32 NumActorStates;
+		uint32 NumEnemies;
+		uint32 PlayerOffset;
+		uint32 ActorGuidsOffset;
+		uint32 ActorStatesOffset;
+		uint32 EnemiesOffset;
+		ANSICHAR MapName[64];
+	};
+
+	struct FPlayer
+	{
+		FVector3f Location;
+		float Yaw;
+		float HealthPercent;
+		int32 Gold;
+		ECharacterState CharacterState;
+		uint8 Padding[3];
+		// Class of the equipped weapon, empty without one
+		ANSICHAR WeaponClass[128];
+	};
+
+	// Only level placed enemies that are alive, the rest of their state is in the actor states. The
+	// AI isn't saved, a loaded enemy starts over from patrolling
+	struct FEnemy
+	{
+		FGuid Guid;
+		FVector3f Location;
+		float Yaw;
+	};
+
+	static_assert(sizeof(FPlayer) == 156 && sizeof(FEnemy) == 32 && sizeof(FPersistentActorState) == 2, "Save records are written as is");
+}
+
+/**
+ * Saves and loads the gameplay state without reflection. Saving copies the player, the actor state
+ * subsystem's arrays and the level placed enemies into flat arrays on the game thread, then a
+ * background task lays them out, compresses them and swaps the file in. Loading reads and
+ * decompresses on a background task too, fills the actor state subsystem and opens the saved map,
+ * so every actor finds its state in BeginPlay the same way it does after streaming back in.
+ * Saves in Saved/SaveGames, slash.Save and slash.Load take a slot name. Only the server saves,
+ * and only its local player.
+ */
+UCLASS()
+class MYPROJECT3_API USaveGameSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <USubsystem> */
+	virtual void Deinitialize() override;
+	/** </USubsystem> */
+
+	// Snapshots now and writes in the background, a save still writing finishes first
+	bool SaveGame(const FString& Slot);
+	void LoadGame(const FString& Slot);
+
+	// The loaded player state, handed out once to the first player character to begin play
+	bool ConsumePlayer(SaveFile::FPlayer& OutPlayer);
+	// A loaded enemy's state, handed out once so later BeginPlays leave it where it is
+	bool ConsumeEnemy(const FGuid& Guid, SaveFile::FEnemy& OutEnemy);
+
+	FORCEINLINE bool IsLoading() const { return bLoading; }
+
+private:
+	struct FSnapshot
+	{
+		FString MapName;
+		TArray<SaveFile::FPlayer> Players;
+		TArray<FGuid> ActorGuids;
+		TArray<FPersistentActorState> ActorStates;
+		TArray<SaveFile::FEnemy> Enemies;
+	};
+
+	static FString GetSlotPath(const FString& Slot);
+	static bool WriteSnapshot(const FSnapshot& Snapshot, const FString& Path);
+	static bool ReadSnapshot(const FString& Path, FSnapshot& OutSnapshot);
+	void ApplySnapshot(FSnapshot&& Snapshot);
+
+	UE::Tasks::FTask SaveTask;
+	bool bLoading = false;
+
+	TArray<SaveFile::FEnemy> LoadedEnemies;
+	SaveFile::FPlayer LoadedPlayer;
+	bool bPlayerPending = false;
+};
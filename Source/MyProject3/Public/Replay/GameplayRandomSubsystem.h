@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplayRandomSubsystem.generated.h"
+
+// One stream per gameplay system, so extra rolls in one don't shift the others
+enum class EGameplayRandom : uint8
+{
+	Patrol,
+	Combat,
+	Animation,
+	Loot,
+
+	Count
+};
+
+/**
+ * Seeded random streams for gameplay. The seed comes from the replay being played, else
+ * slash.Random.Seed, else the clock, and a recording stores it so the rolls come out the same.
+ */
+UCLASS()
+class MYPROJECT3_API UGameplayRandomSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	/** </UWorldSubsystem> */
+
+	// Falls back to an unseeded stream in worlds without the subsystem (editor previews)
+	static FRandomStream& GetStream(const UObject* WorldContextObject, EGameplayRandom Stream);
+
+	FORCEINLINE uint32 GetSeed() const { return Seed; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	FRandomStream Streams[static_cast<int32>(EGameplayRandom::Count)];
+	uint32 Seed = 0;
+};
@@ -0,0 +1,157 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SessionRecorderSubsystem.generated.h"
+
+class ASlashCharacter;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// The player inputs that drive a session, what SlashCharacter's handlers receive
+enum class ESessionInput : uint8
+{
+	Move,
+	Look,
+	Jump,
+	EKey,
+	Attack
+};
+
+/**
+ * Recording file layout. A header followed by flat arrays of these, so a replay maps the file and
+ * reads it in place. Inputs of a frame run from its FirstInput up to the next frame's.
+ */
+namespace SessionRecording
+{
+	constexpr uint32 Magic = 0x50524C53; // "SLRP"
+	constexpr uint16 Version = 1;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint16 Version;
+		uint16 HeaderSize;
+		uint32 Seed;
+		uint32 NumFrames;
+		uint32 NumInputs;
+		uint32 NumSpawns;
+		uint32 FramesOffset;
+		uint32 InputsOffset;
+		uint32 SpawnsOffset;
+		ANSICHAR MapName[64];
+	};
+
+	struct FFrame
+	{
+		float DeltaTime;
+		uint32 FirstInput;
+		// Of every character's location at the end of the frame, where a replay checks it is still on track
+		uint32 Checksum;
+	};
+
+	struct FInput
+	{
+		ESessionInput Type;
+		uint8 Padding[3];
+		FVector2f Value;
+	};
+
+	struct FSpawn
+	{
+		uint32 Frame;
+		uint32 ClassHash;
+		FVector3f Location;
+	};
+
+	static_assert(sizeof(FFrame) == 12 && sizeof(FInput) == 12 && sizeof(FSpawn) == 20, "Recording records are written as is");
+}
+
+/**
+ * Records a standalone session started with -SlashRecord=<name>: each frame's delta time, the
+ * player's inputs and the pawns and items spawned, plus the random seed. -SlashReplay=<name>
+ * plays one back, headless works, by feeding the inputs to the player with the recorded frame
+ * times and reports the first frame where the characters end up somewhere else.
+ * -SlashReplayExit quits when it's done, so a captured fight runs as a repeatable benchmark.
+ */
+UCLASS()
+class MYPROJECT3_API USessionRecorderSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** <FTickableGameObject> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </FTickableGameObject> */
+
+	// Call from the input handlers, a no-op unless recording
+	static void NoteInput(const APawn* Pawn, ESessionInput Type, const FVector2D& Value = FVector2D::ZeroVector);
+	static bool IsReplaying(const UObject* WorldContextObject);
+	static bool IsRecordingOrReplaying(const UObject* WorldContextObject);
+
+	bool GetReplaySeed(uint32& OutSeed) const;
+	void StopRecording();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	enum class EMode : uint8
+	{
+		Idle,
+		Recording,
+		Replaying
+	};
+
+	void OnPreActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void OnActorSpawned(AActor* Actor);
+	uint32 ComputeChecksum() const;
+	bool OpenReplay(const FString& Path);
+	void FinishReplay();
+	void SetReplayDeltaTime(uint32 Frame);
+	ASlashCharacter* GetPlayerCharacter() const;
+	static FString GetRecordingPath(const FString& Name);
+
+	EMode Mode = EMode::Idle;
+	uint32 FrameIndex = 0;
+	bool bFrameOpen = false;
+
+	// Recording
+	FString RecordingPath;
+	uint32 RecordingSeed = 0;
+	TArray<SessionRecording::FFrame> RecordedFrames;
+	TArray<SessionRecording::FInput> RecordedInputs;
+	TArray<SessionRecording::FSpawn> RecordedSpawns;
+
+	// Replay, points into the mapped file (or LoadedFile where mapping isn't supported)
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> LoadedFile;
+	const SessionRecording::FHeader* ReplayHeader = nullptr;
+	const SessionRecording::FFrame* ReplayFrames = nullptr;
+	const SessionRecording::FInput* ReplayInputs = nullptr;
+	const SessionRecording::FSpawn* ReplaySpawns = nullptr;
+	uint32 NextReplaySpawn = 0;
+	int64 FirstDivergentFrame = INDEX_NONE;
+	int32 SpawnMismatches = 0;
+	bool bExitWhenDone = false;
+	bool bWasUsingFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0.0;
+
+	// Wall time per replayed frame, what the benchmark reports
+	double LastFrameWallTime = 0.0;
+	double TotalFrameWallTime = 0.0;
+	double MaxFrameWallTime = 0.0;
+
+	FDelegateHandle PreActorTickHandle;
+	FDelegateHandle ActorSpawnedHandle;
+};
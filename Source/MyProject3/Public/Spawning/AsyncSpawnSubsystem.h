@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/World.h"
+#include "Engine/StreamableManager.h"
+#include "AsyncSpawnSubsystem.generated.h"
+
+/**
+ * Loads the classes placed actors may spawn later (enemy weapons, treasure) in the background
+ * when the level starts, and spawns soft classes without ever blocking the game thread on a load.
+ * Primary assets go through the asset manager with the preload bundles, anything else through
+ * the streamable manager. The spawns themselves go through the spawn director's budget.
+ */
+UCLASS()
+class MYPROJECT3_API UAsyncSpawnSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/**
+	 * Spawns Class at Transform once it is loaded and the spawn director gets to it.
+	 * OnSpawned is not called if the spawn fails or the world goes away first.
+	 */
+	void SpawnActorAsync(const TSoftClassPtr<AActor>& Class, const FTransform& Transform, const FActorSpawnParameters& SpawnParams, TFunction<void(AActor*)> OnSpawned = nullptr);
+
+	bool IsPreloadComplete() const;
+
+	static const TArray<FName>& GetPreloadBundles();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void PreloadForLevel(ULevel* Level);
+	void OnLevelAdded(ULevel* Level, UWorld* World);
+	void OnPreloadComplete();
+
+	// One handle per level that had something to preload, held so the classes stay loaded
+	TArray<TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+	FDelegateHandle LevelAddedHandle;
+
+	double WorldInitTime = 0.0;
+	double PreloadStartTime = 0.0;
+};
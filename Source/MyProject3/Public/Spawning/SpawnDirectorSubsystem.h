@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Containers/Queue.h"
+#include "Engine/StreamableManager.h"
+#include "SpawnDirectorSubsystem.generated.h"
+
+struct FSpawnRequest
+{
+	TSoftClassPtr<AActor> Class;
+	FTransform Transform;
+	// Dropped if an owner was given and is gone by the time it spawns
+	TWeakObjectPtr<AActor> Owner;
+	TWeakObjectPtr<APawn> Instigator;
+	ESpawnActorCollisionHandlingMethod CollisionHandling = ESpawnActorCollisionHandlingMethod::Undefined;
+
+	// Game thread, between the deferred spawn and FinishSpawning, so before BeginPlay
+	TFunction<void(AActor*)> OnConfigure;
+	// Game thread, once the actor has begun play
+	TFunction<void(AActor*)> OnSpawned;
+};
+
+/**
+ * Does spawns and the expensive parts of actor setup a few at a time, within slash.SpawnDirector.BudgetMs
+ * of game thread per frame, so a map full of enemies or a wave doesn't land in one frame. Requests can
+ * come from any thread. Init steps queued for actors already in the world run before new spawns, and
+ * at least one thing happens every frame so the backlog always drains.
+ */
+UCLASS()
+class MYPROJECT3_API USpawnDirectorSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** <UWorldSubsystem> */
+	virtual void Deinitialize() override;
+	/** </UWorldSubsystem> */
+
+	/** <FTickableGameObject> */
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	/** </FTickableGameObject> */
+
+	// Safe from any thread, the class loads first if it isn't loaded yet
+	void RequestSpawn(FSpawnRequest&& Request);
+
+	// Runs Step within the budget while Actor is still around, steps of the same actor keep their order.
+	// Runs it right away in worlds without a director.
+	static void QueueInitStep(AActor* Actor, TFunction<void()> Step);
+
+	FORCEINLINE int32 GetBacklog() const { return PendingLoads.Num() + NumPendingSpawns + NumInitSteps; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FInitStep
+	{
+		TWeakObjectPtr<AActor> Actor;
+		TFunction<void()> Step;
+	};
+
+	void DrainIncoming();
+	void RunNextInitStep();
+	void SpawnNext();
+
+	// Filled from any thread, drained at the start of the game thread tick
+	TQueue<FSpawnRequest, EQueueMode::Mpsc> IncomingRequests;
+
+	// Classes that weren't loaded yet, the request moves on to PendingSpawns when its load finishes
+	TArray<TSharedPtr<FStreamableHandle>> PendingLoads;
+
+	TQueue<FSpawnRequest, EQueueMode::Spsc> PendingSpawns;
+	TQueue<FInitStep, EQueueMode::Spsc> InitSteps;
+	int32 NumPendingSpawns = 0;
+	int32 NumInitSteps = 0;
+};
@@ -0,0 +1,97 @@
+// Times the scalar and SIMD batch versions of the combat core over a crowd of enemies.
+//
+//   combat_core_bench [entities] [iterations]
+
+#include "CombatCore/CombatBatch.h"
+#include "entity_data.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace CombatCore;
+
+namespace
+{
+	// Best of a few runs, in nanoseconds per entity
+	template<typename FunctionType>
+	double Time(int32_t Count, int32_t Iterations, FunctionType&& Function)
+	{
+		double Best = 1.e30;
+		for (int Run = 0; Run < 5; ++Run)
+		{
+			const auto Start = std::chrono::steady_clock::now();
+			for (int32_t Iteration = 0; Iteration < Iterations; ++Iteration)
+			{
+				Function();
+			}
+			const std::chrono::duration<double, std::nano> Elapsed = std::chrono::steady_clock::now() - Start;
+			const double PerEntity = Elapsed.count() / (double(Count) * Iterations);
+			Best = PerEntity < Best ? PerEntity : Best;
+		}
+		return Best;
+	}
+
+	// Keeps the optimizer from dropping work whose results nobody reads
+	volatile uint32_t Sink = 0;
+
+	template<typename T>
+	void Consume(const std::vector<T>& Values)
+	{
+		Sink = Sink + static_cast<uint32_t>(Values[Values.size() / 2]);
+	}
+
+	void Report(const char* Name, double ScalarNs, double SimdNs)
+	{
+		std::printf("%-24s %8.3f ns %8.3f ns %7.2fx\n", Name, ScalarNs, SimdNs, ScalarNs / SimdNs);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int32_t Count = argc > 1 ? std::atoi(argv[1]) : 10000;
+	const int32_t Iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+	if (Count <= 0 || Iterations <= 0)
+	{
+		std::printf("usage: combat_core_bench [entities] [iterations]\n");
+		return EXIT_FAILURE;
+	}
+
+	const FEntityData Data(Count);
+	std::printf("%d entities, %d iterations, SIMD is %s\n", Count, Iterations, COMBATCORE_SSE2 ? "SSE2" : "the scalar fallback");
+	std::printf("%-24s %11s %11s %8s\n", "per entity", "scalar", "simd", "speedup");
+
+	{
+		std::vector<EHitDirection> Out(Count);
+		const double Scalar = Time(Count, Iterations, [&]() { ClassifyHitDirectionsScalar(Count, Data.ForwardX.data(), Data.ForwardY.data(), Data.ToHitX.data(), Data.ToHitY.data(), Out.data()); Consume(Out); });
+		const double Simd = Time(Count, Iterations, [&]() { ClassifyHitDirectionsSimd(Count, Data.ForwardX.data(), Data.ForwardY.data(), Data.ToHitX.data(), Data.ToHitY.data(), Out.data()); Consume(Out); });
+		Report("hit direction", Scalar, Simd);
+	}
+	{
+		std::vector<uint8_t> Out(Count);
+		const double Scalar = Time(Count, Iterations, [&]() { AreInRangeScalar(Count, Data.GetOffsets(), 1000.f, Out.data()); Consume(Out); });
+		const double Simd = Time(Count, Iterations, [&]() { AreInRangeSimd(Count, Data.GetOffsets(), 1000.f, Out.data()); Consume(Out); });
+		Report("in range", Scalar, Simd);
+	}
+	{
+		std::vector<float> X(Count), Y(Count), Z(Count);
+		const FMutableVec3Array Out = { X.data(), Y.data(), Z.data() };
+		const double Scalar = Time(Count, Iterations, [&]() { GetTranslationWarpOffsetsScalar(Count, Data.GetOffsets(), 75.f, Out); Consume(X); });
+		const double Simd = Time(Count, Iterations, [&]() { GetTranslationWarpOffsetsSimd(Count, Data.GetOffsets(), 75.f, Out); Consume(X); });
+		Report("translation warp", Scalar, Simd);
+	}
+	{
+		std::vector<ECombatDecision> Out(Count);
+		const double Scalar = Time(Count, Iterations, [&]() { DecideCombatScalar(Count, Data.DistanceSquared.data(), Data.Flags.data(), 1000.f, 150.f, Out.data()); Consume(Out); });
+		const double Simd = Time(Count, Iterations, [&]() { DecideCombatSimd(Count, Data.DistanceSquared.data(), Data.Flags.data(), 1000.f, 150.f, Out.data()); Consume(Out); });
+		Report("combat decision", Scalar, Simd);
+	}
+	{
+		// Damage is applied to a fresh copy each time or everything ends up dead after a few iterations
+		std::vector<float> Health(Count);
+		const double Scalar = Time(Count, Iterations, [&]() { Health = Data.Health; ApplyDamageScalar(Count, Health.data(), Data.Damage.data(), Data.MaxHealth.data()); Consume(Health); });
+		const double Simd = Time(Count, Iterations, [&]() { Health = Data.Health; ApplyDamageSimd(Count, Health.data(), Data.Damage.data(), Data.MaxHealth.data()); Consume(Health); });
+		Report("damage (with copy)", Scalar, Simd);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,198 @@
+// Checks the combat core against the engine code it was pulled out of, and the SIMD batch
+// versions against the scalar ones. Exits non zero on the first failure.
+
+#include "CombatCore/CombatBatch.h"
+#include "entity_data.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace CombatCore;
+
+static int NumFailures = 0;
+
+#define EXPECT(Condition) \
+	do \
+	{ \
+		if (!(Condition)) \
+		{ \
+			std::printf("%s:%d: expected %s\n", __FILE__, __LINE__, #Condition); \
+			++NumFailures; \
+		} \
+	} while (0)
+
+// ABaseCharacter::DirectionalHitReact as it was, in double with acos
+static EHitDirection ReferenceHitDirection(double ForwardX, double ForwardY, double ToHitX, double ToHitY, double& OutTheta)
+{
+	const double Length = std::sqrt(ToHitX * ToHitX + ToHitY * ToHitY);
+	// FMath::Acos clamps, rounding can take the cosine a hair past 1
+	const double CosTheta = std::fmax(-1.0, std::fmin(1.0, (ForwardX * ToHitX + ForwardY * ToHitY) / Length));
+	double Theta = std::acos(CosTheta) * 180.0 / 3.14159265358979323846;
+	if (ForwardX * ToHitY - ForwardY * ToHitX < 0.0) Theta = -Theta;
+	OutTheta = Theta;
+
+	if (-45.0 <= Theta && Theta < 45.0) return EHitDirection::Front;
+	if (-135.0 <= Theta && Theta < -45.0) return EHitDirection::Left;
+	if (45.0 <= Theta && Theta < 135.0) return EHitDirection::Right;
+	return EHitDirection::Back;
+}
+
+static void TestHitDirection()
+{
+	// Facing +X, +Y is to the right in the engine's left handed frame
+	EXPECT(ClassifyHitDirection(1.f, 0.f, 10.f, 0.f) == EHitDirection::Front);
+	EXPECT(ClassifyHitDirection(1.f, 0.f, 0.f, 10.f) == EHitDirection::Right);
+	EXPECT(ClassifyHitDirection(1.f, 0.f, 0.f, -10.f) == EHitDirection::Left);
+	EXPECT(ClassifyHitDirection(1.f, 0.f, -10.f, 0.f) == EHitDirection::Back);
+	// The boundaries belong where the engine code put them
+	EXPECT(ClassifyHitDirection(1.f, 0.f, 1.f, -1.f) == EHitDirection::Front);
+	EXPECT(ClassifyHitDirection(1.f, 0.f, 1.f, 1.f) == EHitDirection::Right);
+	EXPECT(ClassifyHitDirection(1.f, 0.f, -1.f, -1.f) == EHitDirection::Left);
+	EXPECT(ClassifyHitDirection(1.f, 0.f, -1.f, 1.f) == EHitDirection::Back);
+	// GetSafeNormal gave the old code a zero vector here, acos(0) put it at 90 degrees
+	EXPECT(ClassifyHitDirection(1.f, 0.f, 0.f, 0.f) == EHitDirection::Right);
+	EXPECT(ClassifyHitDirection(0.f, 1.f, -1.e-5f, 1.e-5f) == EHitDirection::Right);
+	{
+		const float Forward[5] = { 1.f, 0.f, -1.f, 1.f, 0.f };
+		const float ToHit[5] = { 0.f, 0.f, 0.f, 1.e-5f, 0.f };
+		EHitDirection Degenerate[5];
+		ClassifyHitDirectionsSimd(5, Forward, Forward, ToHit, ToHit, Degenerate);
+		for (const EHitDirection Direction : Degenerate)
+		{
+			EXPECT(Direction == EHitDirection::Right);
+		}
+	}
+
+	const FEntityData Data(10007);
+	int32_t NumCompared = 0;
+	for (int32_t Index = 0; Index < Data.Count; ++Index)
+	{
+		double Theta = 0.0;
+		const EHitDirection Expected = ReferenceHitDirection(Data.ForwardX[Index], Data.ForwardY[Index], Data.ToHitX[Index], Data.ToHitY[Index], Theta);
+		// Float and double can land on different sides of a boundary
+		const double FromBoundary = std::fabs(std::fmod(std::fabs(Theta) + 45.0, 90.0));
+		if (FromBoundary < 1.e-3 || FromBoundary > 90.0 - 1.e-3) continue;
+
+		EXPECT(ClassifyHitDirection(Data.ForwardX[Index], Data.ForwardY[Index], Data.ToHitX[Index], Data.ToHitY[Index]) == Expected);
+		++NumCompared;
+	}
+	EXPECT(NumCompared > Data.Count * 9 / 10);
+
+	std::vector<EHitDirection> Scalar(Data.Count), Simd(Data.Count);
+	ClassifyHitDirectionsScalar(Data.Count, Data.ForwardX.data(), Data.ForwardY.data(), Data.ToHitX.data(), Data.ToHitY.data(), Scalar.data());
+	ClassifyHitDirectionsSimd(Data.Count, Data.ForwardX.data(), Data.ForwardY.data(), Data.ToHitX.data(), Data.ToHitY.data(), Simd.data());
+	EXPECT(Scalar == Simd);
+}
+
+static void TestRange()
+{
+	EXPECT(IsInRange({ 3.f, 4.f, 0.f }, 5.f));
+	EXPECT(!IsInRange({ 3.f, 4.f, 0.1f }, 5.f));
+	EXPECT(IsInRange({}, 0.f));
+
+	const FEntityData Data(10007);
+	std::vector<uint8_t> Scalar(Data.Count), Simd(Data.Count);
+	AreInRangeScalar(Data.Count, Data.GetOffsets(), 1000.f, Scalar.data());
+	AreInRangeSimd(Data.Count, Data.GetOffsets(), 1000.f, Simd.data());
+	EXPECT(Scalar == Simd);
+
+	int32_t NumInRange = 0;
+	for (int32_t Index = 0; Index < Data.Count; ++Index)
+	{
+		const double Distance = std::sqrt(double(Data.OffsetX[Index]) * Data.OffsetX[Index] + double(Data.OffsetY[Index]) * Data.OffsetY[Index] + double(Data.OffsetZ[Index]) * Data.OffsetZ[Index]);
+		if (std::fabs(Distance - 1000.0) > 1.e-2)
+		{
+			EXPECT((Scalar[Index] != 0) == (Distance <= 1000.0));
+		}
+		NumInRange += Scalar[Index];
+	}
+	EXPECT(NumInRange > 0 && NumInRange < Data.Count);
+}
+
+static void TestWarpOffset()
+{
+	const FVec3 Offset = GetTranslationWarpOffset({ 0.f, 300.f, 0.f }, 75.f);
+	EXPECT(Offset.X == 0.f && Offset.Y == 75.f && Offset.Z == 0.f);
+
+	// Standing right on the target there is nowhere to warp to
+	const FVec3 None = GetTranslationWarpOffset({ 0.f, 0.f, 0.f }, 75.f);
+	EXPECT(None.X == 0.f && None.Y == 0.f && None.Z == 0.f);
+
+	FEntityData Data(10007);
+	Data.OffsetX[5] = Data.OffsetY[5] = Data.OffsetZ[5] = 0.f;
+	std::vector<float> ScalarX(Data.Count), ScalarY(Data.Count), ScalarZ(Data.Count);
+	std::vector<float> SimdX(Data.Count), SimdY(Data.Count), SimdZ(Data.Count);
+	GetTranslationWarpOffsetsScalar(Data.Count, Data.GetOffsets(), 75.f, { ScalarX.data(), ScalarY.data(), ScalarZ.data() });
+	GetTranslationWarpOffsetsSimd(Data.Count, Data.GetOffsets(), 75.f, { SimdX.data(), SimdY.data(), SimdZ.data() });
+	EXPECT(ScalarX == SimdX && ScalarY == SimdY && ScalarZ == SimdZ);
+	EXPECT(SimdX[5] == 0.f && SimdY[5] == 0.f && SimdZ[5] == 0.f);
+
+	for (int32_t Index = 0; Index < Data.Count; ++Index)
+	{
+		if (Index == 5) continue;
+		const float Length = std::sqrt(LengthSquared({ ScalarX[Index], ScalarY[Index], ScalarZ[Index] }));
+		EXPECT(std::fabs(Length - 75.f) < 1.e-3f);
+	}
+}
+
+static void TestCombatDecision()
+{
+	const float CombatRadius = 1000.f;
+	const float AttackRadius = 150.f;
+	const float Far = 2000.f * 2000.f;
+	const float Mid = 500.f * 500.f;
+	const float Close = 100.f * 100.f;
+
+	EXPECT(DecideCombat(Far, CombatRadius, AttackRadius, 0) == ECombatDecision::Patrol);
+	EXPECT(DecideCombat(Far, CombatRadius, AttackRadius, CombatFlags::Engaged) == ECombatDecision::LoseInterest);
+	EXPECT(DecideCombat(Mid, CombatRadius, AttackRadius, 0) == ECombatDecision::Chase);
+	EXPECT(DecideCombat(Mid, CombatRadius, AttackRadius, CombatFlags::Chasing) == ECombatDecision::None);
+	EXPECT(DecideCombat(Mid, CombatRadius, AttackRadius, CombatFlags::Engaged) == ECombatDecision::StopAttacking);
+	EXPECT(DecideCombat(Close, CombatRadius, AttackRadius, CombatFlags::Chasing) == ECombatDecision::Attack);
+	EXPECT(DecideCombat(Close, CombatRadius, AttackRadius, CombatFlags::Attacking) == ECombatDecision::None);
+	EXPECT(DecideCombat(Close, CombatRadius, AttackRadius, CombatFlags::Dead) == ECombatDecision::None);
+	// No target at all is as far as it gets
+	EXPECT(DecideCombat(3.4e38f, CombatRadius, AttackRadius, CombatFlags::Chasing) == ECombatDecision::Patrol);
+
+	const FEntityData Data(10007);
+	std::vector<ECombatDecision> Scalar(Data.Count), Simd(Data.Count);
+	DecideCombatScalar(Data.Count, Data.DistanceSquared.data(), Data.Flags.data(), CombatRadius, AttackRadius, Scalar.data());
+	DecideCombatSimd(Data.Count, Data.DistanceSquared.data(), Data.Flags.data(), CombatRadius, AttackRadius, Simd.data());
+	EXPECT(Scalar == Simd);
+}
+
+static void TestDamage()
+{
+	EXPECT(ApplyDamage(50.f, 20.f, 100.f) == 30.f);
+	EXPECT(ApplyDamage(10.f, 20.f, 100.f) == 0.f);
+	EXPECT(ApplyDamage(90.f, -20.f, 100.f) == 100.f);
+
+	EXPECT(QuantizeHealth(100.f, 100.f) == 255);
+	EXPECT(QuantizeHealth(0.f, 100.f) == 0);
+	EXPECT(QuantizeHealth(0.01f, 100.f) == 1);
+	EXPECT(QuantizeHealth(50.f, 100.f) == 128);
+
+	const FEntityData Data(10007);
+	std::vector<float> Scalar = Data.Health, Simd = Data.Health;
+	ApplyDamageScalar(Data.Count, Scalar.data(), Data.Damage.data(), Data.MaxHealth.data());
+	ApplyDamageSimd(Data.Count, Simd.data(), Data.Damage.data(), Data.MaxHealth.data());
+	EXPECT(Scalar == Simd);
+}
+
+int main()
+{
+	TestHitDirection();
+	TestRange();
+	TestWarpOffset();
+	TestCombatDecision();
+	TestDamage();
+
+	if (NumFailures > 0)
+	{
+		std::printf("%d checks failed\n", NumFailures);
+		return EXIT_FAILURE;
+	}
+	std::printf("all checks passed (%s)\n", COMBATCORE_SSE2 ? "SSE2" : "scalar fallback");
+	return EXIT_SUCCESS;
+}
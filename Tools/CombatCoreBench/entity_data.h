@@ -0,0 +1,57 @@
+#pragma once
+
+// Random struct of arrays data for a crowd of enemies, shared by the bench and the tests
+
+#include "CombatCore/CombatBatch.h"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+struct FEntityData
+{
+	int32_t Count = 0;
+
+	std::vector<float> ForwardX, ForwardY, ToHitX, ToHitY;
+	std::vector<float> OffsetX, OffsetY, OffsetZ;
+	std::vector<float> DistanceSquared;
+	std::vector<uint8_t> Flags;
+	std::vector<float> Health, Damage, MaxHealth;
+
+	explicit FEntityData(int32_t InCount, uint32_t Seed = 1234)
+		: Count(InCount)
+	{
+		std::mt19937 Random(Seed);
+		std::uniform_real_distribution<float> Angle(-3.14159265f, 3.14159265f);
+		std::uniform_real_distribution<float> Coordinate(-1500.f, 1500.f);
+		std::uniform_real_distribution<float> Unit(0.f, 1.f);
+		std::uniform_int_distribution<int> FlagBits(0, 15);
+
+		auto Resize = [InCount](auto&... Arrays) { (Arrays.resize(InCount), ...); };
+		Resize(ForwardX, ForwardY, ToHitX, ToHitY, OffsetX, OffsetY, OffsetZ, DistanceSquared, Flags, Health, Damage, MaxHealth);
+
+		for (int32_t Index = 0; Index < InCount; ++Index)
+		{
+			const float Yaw = Angle(Random);
+			ForwardX[Index] = std::cos(Yaw);
+			ForwardY[Index] = std::sin(Yaw);
+			ToHitX[Index] = Coordinate(Random);
+			ToHitY[Index] = Coordinate(Random);
+
+			OffsetX[Index] = Coordinate(Random);
+			OffsetY[Index] = Coordinate(Random);
+			OffsetZ[Index] = Coordinate(Random) * 0.1f;
+			DistanceSquared[Index] = CombatCore::LengthSquared({ OffsetX[Index], OffsetY[Index], OffsetZ[Index] });
+			Flags[Index] = static_cast<uint8_t>(FlagBits(Random));
+
+			MaxHealth[Index] = 100.f;
+			Health[Index] = Unit(Random) * 100.f;
+			Damage[Index] = Unit(Random) * 60.f - 10.f;
+		}
+	}
+
+	CombatCore::FVec3Array GetOffsets() const
+	{
+		return { OffsetX.data(), OffsetY.data(), OffsetZ.data() };
+	}
+};
@@ -0,0 +1,46 @@
+#!/usr/bin/env bash
+# Checks lag compensation on localhost with simulated latency. A dedicated server and one client
+# run with PktLag, the client probes where it sees every other character and the server compares
+# that against the rewound hitbox and the current one. Fails if rewinding isn't closer.
+#
+#   UE_EDITOR=/path/to/UnrealEditor PROJECT=/path/to/MyProject3.uproject ./lag_comp_test.sh [lag ms] [seconds]
+set -euo pipefail
+
+LAG_MS="${1:-150}"
+DURATION="${2:-60}"
+MAP="${MAP:-/Game/Maps/TestMap}"
+PORT="${PORT:-7777}"
+: "${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}"
+: "${PROJECT:?set PROJECT to the .uproject}"
+
+LOG_DIR="$(mktemp -d)"
+PIDS=()
+cleanup() { kill "${PIDS[@]}" 2>/dev/null || true; }
+trap cleanup EXIT
+
+"$UE_EDITOR" "$PROJECT" "$MAP" -server -log -port="$PORT" -unattended \
+	-PktLag="$LAG_MS" -abslog="$LOG_DIR/server.log" >/dev/null 2>&1 &
+PIDS+=($!)
+sleep 15
+
+"$UE_EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game -nullrhi -nosound -unattended \
+	-PktLag="$LAG_MS" -ExecCmds="slash.LagComp.ProbeInterval 0.25" -abslog="$LOG_DIR/client.log" >/dev/null 2>&1 &
+PIDS+=($!)
+
+sleep "$DURATION"
+# The server dumps its results on the way out
+kill -INT "${PIDS[0]}" 2>/dev/null || true
+sleep 10
+
+grep "LagComp:" "$LOG_DIR/server.log" || { echo "No LagComp lines, see $LOG_DIR/server.log"; exit 1; }
+
+PROBES=$(grep "LagComp: .* probes" "$LOG_DIR/server.log" | tail -1)
+[ -n "$PROBES" ] || { echo "No probes reached the server"; exit 1; }
+REWOUND=$(echo "$PROBES" | sed -E 's/.*rewound ([0-9.]+) cm.*/\1/')
+CURRENT=$(echo "$PROBES" | sed -E 's/.*current ([0-9.]+) cm.*/\1/')
+if awk "BEGIN { exit !($REWOUND <= $CURRENT) }"; then
+	echo "PASS: rewound error $REWOUND cm, current $CURRENT cm at ${LAG_MS} ms lag"
+else
+	echo "FAIL: rewound error $REWOUND cm is worse than current $CURRENT cm"
+	exit 1
+fi
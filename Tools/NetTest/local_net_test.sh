@@ -0,0 +1,39 @@
+#!/usr/bin/env bash
+# Runs a dedicated server and a few clients on localhost and prints the per client bandwidth
+# the server logged. Needs the editor binary and the .uproject path:
+#
+#   UE_EDITOR=/path/to/UnrealEditor PROJECT=/path/to/MyProject3.uproject ./local_net_test.sh [clients] [seconds]
+#
+# Clients run with -nullrhi so several fit on one machine, the server reports every 5 seconds.
+set -euo pipefail
+
+CLIENTS="${1:-2}"
+DURATION="${2:-60}"
+MAP="${MAP:-/Game/Maps/TestMap}"
+PORT="${PORT:-7777}"
+: "${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}"
+: "${PROJECT:?set PROJECT to the .uproject}"
+
+LOG_DIR="$(mktemp -d)"
+PIDS=()
+cleanup() { kill "${PIDS[@]}" 2>/dev/null || true; }
+trap cleanup EXIT
+
+"$UE_EDITOR" "$PROJECT" "$MAP" -server -log -port="$PORT" -unattended \
+	-ExecCmds="slash.Net.ReportInterval 5" -abslog="$LOG_DIR/server.log" >/dev/null 2>&1 &
+PIDS+=($!)
+sleep 15
+
+for ((i = 0; i < CLIENTS; i++)); do
+	"$UE_EDITOR" "$PROJECT" "127.0.0.1:$PORT" -game -nullrhi -nosound -unattended \
+		-abslog="$LOG_DIR/client$i.log" >/dev/null 2>&1 &
+	PIDS+=($!)
+done
+
+sleep "$DURATION"
+# Ask the server to quit so it logs the averages on the way out
+kill -INT "${PIDS[0]}" 2>/dev/null || true
+sleep 10
+
+grep "NetReport:" "$LOG_DIR/server.log" || echo "No NetReport lines, see $LOG_DIR/server.log"
+echo "Logs in $LOG_DIR"
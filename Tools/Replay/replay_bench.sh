@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+# Replays a session recorded with -SlashRecord=<name> headless, a few times over, and prints how
+# each run went: whether it stayed on the recorded path and the average and worst frame times.
+# Recordings live in Saved/Replays of the project unless a full path is given.
+#
+#   UE_EDITOR=/path/to/UnrealEditor PROJECT=/path/to/MyProject3.uproject ./replay_bench.sh <recording> [runs]
+set -euo pipefail
+
+RECORDING="${1:?name or path of the recording}"
+RUNS="${2:-3}"
+MAP="${MAP:-/Game/Maps/TestMap}"
+: "${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}"
+: "${PROJECT:?set PROJECT to the .uproject}"
+
+LOG_DIR="$(mktemp -d)"
+STATUS=0
+for RUN in $(seq 1 "$RUNS"); do
+	"$UE_EDITOR" "$PROJECT" "$MAP" -game -nullrhi -nosound -unattended \
+		-SlashReplay="$RECORDING" -SlashReplayExit -abslog="$LOG_DIR/replay_$RUN.log" >/dev/null 2>&1 || true
+
+	RESULT=$(grep "Replay: .* frames," "$LOG_DIR/replay_$RUN.log" | tail -1)
+	if [ -z "$RESULT" ]; then
+		echo "run $RUN: no result, see $LOG_DIR/replay_$RUN.log"
+		STATUS=1
+		continue
+	fi
+	echo "run $RUN: ${RESULT#*Replay: }"
+	echo "$RESULT" | grep -q "matched the recording" || STATUS=1
+done
+exit "$STATUS"
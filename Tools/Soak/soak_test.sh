@@ -0,0 +1,21 @@
+#!/usr/bin/env bash
+# Runs the autopiloted combat loop headless for a few hours and fails if UObjects, actors, memory or
+# frame time crept up over the run. The sampled series ends up next to the log as soak.csv.
+#
+#   UE_EDITOR=/path/to/UnrealEditor PROJECT=/path/to/MyProject3.uproject ./soak_test.sh [hours]
+set -euo pipefail
+
+HOURS="${1:-2}"
+MAP="${MAP:-/Game/Maps/TestMap}"
+: "${UE_EDITOR:?set UE_EDITOR to the UnrealEditor binary}"
+: "${PROJECT:?set PROJECT to the .uproject}"
+
+OUT_DIR="$(mktemp -d)"
+STATUS=0
+"$UE_EDITOR" "$PROJECT" "$MAP" -game -nullrhi -nosound -unattended \
+	-SlashSoak -SlashSoakHours="$HOURS" -SlashSoakCsv="$OUT_DIR/soak.csv" \
+	-abslog="$OUT_DIR/soak.log" >/dev/null 2>&1 || STATUS=$?
+
+grep "Soak: " "$OUT_DIR/soak.log" | sed 's/.*Soak: /  /' || echo "no soak results, see $OUT_DIR/soak.log"
+echo "series: $OUT_DIR/soak.csv"
+exit "$STATUS"